@@ -135,7 +135,7 @@ class bitVector {
   public:
 
     bitVector()
-            : _size(0) {
+            : _size(0), _nchar(0) {
         _bitArray = nullptr;
     }
 
@@ -146,15 +146,15 @@ class bitVector {
     }
 
     ~bitVector() {
-        if (_bitArray != nullptr)
-            free(_bitArray);
+        release();
     }
 
-    //copy constructor
+    //copy constructor, mapped arrays are copied into the owned memory
     bitVector(bitVector const &r) {
         _size =  r._size;
         _nchar = r._nchar;
-        _ranks = r._ranks;
+        _ranks.assign(r._rankArray, r._rankArray + r._nranks);
+        update_ranks();
         _bitArray = nullptr;
         if (r._bitArray) {
             _bitArray = (uint64_t *) calloc(_nchar,sizeof(uint64_t));
@@ -165,12 +165,11 @@ class bitVector {
     // Copy assignment operator
     bitVector &operator=(bitVector const &r) {
         if (&r != this) {
+            release();
             _size =  r._size;
             _nchar = r._nchar;
-            _ranks = r._ranks;
-            if (_bitArray != nullptr)
-                free(_bitArray);
-            _bitArray = nullptr;
+            _ranks.assign(r._rankArray, r._rankArray + r._nranks);
+            update_ranks();
             if (r._bitArray) {
                 _bitArray = (uint64_t *) calloc(_nchar, sizeof(uint64_t));
                 memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
@@ -182,14 +181,19 @@ class bitVector {
     // Move assignment operator
     bitVector &operator=(bitVector &&r) noexcept {
         if (&r != this) {
-            if (_bitArray != nullptr)
-                free(_bitArray);
+            release();
 
             _size =  r._size;
             _nchar = r._nchar;
             _ranks = std::move(r._ranks);
+            _rankArray = r._rankArray;
+            _nranks = r._nranks;
             _bitArray = r._bitArray;
+            _mapped = r._mapped;
             r._bitArray = nullptr;
+            r._rankArray = nullptr;
+            r._nranks = 0;
+            r._mapped = false;
         }
         return *this;
     }
@@ -202,13 +206,14 @@ class bitVector {
 
 
     void resize(uint64_t newsize) {
+        assert(!_mapped);
         _nchar  = (1ULL+newsize/64ULL);
         _bitArray = (uint64_t *) realloc(_bitArray,_nchar*sizeof(uint64_t));
         _size = newsize;
     }
 
     size_t size() const { return _size; }
-    uint64_t bitSize() const {return (_nchar*64ULL + _ranks.capacity()*64ULL );}
+    uint64_t bitSize() const {return (_nchar*64ULL + _nranks*64ULL );}
 
     //clear whole array
     void clear() {
@@ -296,6 +301,7 @@ class bitVector {
             }
             curent_rank +=  popcount_64(_bitArray[ii]);
         }
+        update_ranks();
 
         return curent_rank;
     }
@@ -304,7 +310,7 @@ class bitVector {
         uint64_t word_idx = pos / 64ULL;
         uint64_t word_offset = pos % 64;
         uint64_t block = pos / _nb_bits_per_rank_sample;
-        uint64_t r = _ranks[block];
+        uint64_t r = _rankArray[block];
         for (uint64_t w = block * _nb_bits_per_rank_sample / 64; w < word_idx; ++w)
             r += popcount_64(_bitArray[w]);
         uint64_t mask = (uint64_t(1) << word_offset ) - 1;
@@ -313,16 +319,25 @@ class bitVector {
         return r;
     }
 
+    // prefetch the words rank(pos) reads
+    void prefetch(uint64_t pos) const {
+        uint64_t block = pos / _nb_bits_per_rank_sample;
+        __builtin_prefetch(_rankArray + block);
+        __builtin_prefetch(_bitArray + block * _nb_bits_per_rank_sample / 64);
+        __builtin_prefetch(_bitArray + pos / 64ULL);
+    }
+
     void save(std::ostream& os) const {
         os.write(reinterpret_cast<char const*>(&_size), sizeof(_size));
         os.write(reinterpret_cast<char const*>(&_nchar), sizeof(_nchar));
         os.write(reinterpret_cast<char const*>(_bitArray), (std::streamsize)(sizeof(uint64_t) * _nchar));
-        size_t sizer = _ranks.size();
+        size_t sizer = _nranks;
         os.write(reinterpret_cast<char const*>(&sizer),  sizeof(size_t));
-        os.write(reinterpret_cast<char const*>(_ranks.data()), (std::streamsize)(sizeof(_ranks[0]) * _ranks.size()));
+        os.write(reinterpret_cast<char const*>(_rankArray), (std::streamsize)(sizeof(uint64_t) * _nranks));
     }
 
     void load(std::istream& is) {
+        release();
         is.read(reinterpret_cast<char*>(&_size), sizeof(_size));
         is.read(reinterpret_cast<char*>(&_nchar), sizeof(_nchar));
         this->resize(_size);
@@ -332,10 +347,50 @@ class bitVector {
         is.read(reinterpret_cast<char *>(&sizer),  sizeof(size_t));
         _ranks.resize(sizer);
         is.read(reinterpret_cast<char*>(_ranks.data()), (std::streamsize)(sizeof(_ranks[0]) * _ranks.size()));
+        update_ranks();
+    }
+
+    // save in the layout map() uses in place: Writer should provide
+    // write(const char*, size) and array(const T*, size) placing aligned arrays
+    template<class Writer>
+    void save_aligned(Writer& os) const {
+        os.write(reinterpret_cast<char const*>(&_size), sizeof(_size));
+        os.write(reinterpret_cast<char const*>(&_nchar), sizeof(_nchar));
+        os.write(reinterpret_cast<char const*>(&_nranks), sizeof(_nranks));
+        os.array(_bitArray, _nchar);
+        os.array(_rankArray, _nranks);
+    }
+
+    // use the arrays saved by save_aligned() in place: Reader should provide
+    // read(char*, size) and array<T>(size) returning the pointer to the array.
+    // The memory should outlive the vector
+    template<class Reader>
+    void map(Reader& is) {
+        release();
+        is.read(reinterpret_cast<char*>(&_size), sizeof(_size));
+        is.read(reinterpret_cast<char*>(&_nchar), sizeof(_nchar));
+        is.read(reinterpret_cast<char*>(&_nranks), sizeof(_nranks));
+        _bitArray = is.template array<uint64_t>(_nchar);
+        _rankArray = is.template array<uint64_t>(_nranks);
+        _mapped = true;
     }
 
 
   protected:
+    void release() {
+        if (_bitArray != nullptr && !_mapped)
+            free(_bitArray);
+        _bitArray = nullptr;
+        _mapped = false;
+        _ranks.clear();
+        update_ranks();
+    }
+
+    void update_ranks() {
+        _rankArray = _ranks.data();
+        _nranks = _ranks.size();
+    }
+
     uint64_t*  _bitArray;
     uint64_t _size;
     uint64_t _nchar;
@@ -344,6 +399,11 @@ class bitVector {
     // additional size for rank is epsilon * _size
     static constexpr uint64_t _nb_bits_per_rank_sample = 512; //512 seems ok
     std::vector<uint64_t> _ranks;
+    // either _ranks or the mapped memory
+    const uint64_t *_rankArray = nullptr;
+    uint64_t _nranks = 0;
+    // whether _bitArray and _rankArray point to the memory we do not own
+    bool _mapped = false;
 };
 
 ////////////////////////////////////////////////////////////////
@@ -366,6 +426,10 @@ class level{
         return bitset.get(hashi);
     }
 
+    void prefetch(uint64_t hash_raw) const {
+        bitset.prefetch(fastrange64(hash_raw, hash_domain));
+    }
+
     uint64_t hash_domain;
     bitVector bitset;
 };
@@ -462,6 +526,19 @@ class mphf {
     }
 
 
+    // hash of the element, lookup() accepts it in place of the element itself
+    template<class elem_t>
+    hash_pair_t hash(const elem_t &elem) const {
+        return _hasher.hashpair128(elem);
+    }
+
+    // prefetch the memory the lookup of the hashed element starts with, so
+    // lookups of several elements might be interleaved to hide cache misses
+    void prefetch(const hash_pair_t &bbhash) const {
+        if (!_built) return;
+        _levels[0].prefetch(bbhash[0]);
+    }
+
     template<class elem_t>
     uint64_t lookup(const elem_t &elem) const {
         if (!_built) return NOT_FOUND;
@@ -521,14 +598,7 @@ class mphf {
         }
 
         //save final hash
-        size_t final_hash_size = _final_hash.size();
-
-        os.write(reinterpret_cast<char const*>(&final_hash_size), sizeof(size_t));
-        for (auto it = _final_hash.begin(); it != _final_hash.end(); ++it) {
-            os.write(reinterpret_cast<char const*>(&(it->first)), sizeof(internal_hash_t));
-            os.write(reinterpret_cast<char const*>(&(it->second)), sizeof(uint64_t));
-        }
-
+        save_final_hash(os);
     }
 
     void load(std::istream& is) {
@@ -541,9 +611,55 @@ class mphf {
         for (int ii=0; ii<_nb_levels; ii++)
             _levels[ii].bitset.load(is);
 
+        load_tail(is);
+    }
+
+    // save in the layout map() uses in place, see bitVector::save_aligned()
+    template<class Writer>
+    void save_aligned(Writer& os) const {
+        os.write(reinterpret_cast<char const*>(&_gamma), sizeof(_gamma));
+        os.write(reinterpret_cast<char const*>(&_nb_levels), sizeof(_nb_levels));
+        os.write(reinterpret_cast<char const*>(&_lastbitsetrank), sizeof(_lastbitsetrank));
+        os.write(reinterpret_cast<char const*>(&_nelem), sizeof(_nelem));
+        for (int ii=0; ii<_nb_levels; ii++)
+            _levels[ii].bitset.save_aligned(os);
+
+        save_final_hash(os);
+    }
+
+    // use the bit arrays saved by save_aligned() in place, see bitVector::map()
+    template<class Reader>
+    void map(Reader& is) {
+        is.read(reinterpret_cast<char*>(&_gamma), sizeof(_gamma));
+        is.read(reinterpret_cast<char*>(&_nb_levels), sizeof(_nb_levels));
+        is.read(reinterpret_cast<char*>(&_lastbitsetrank), sizeof(_lastbitsetrank));
+        is.read(reinterpret_cast<char*>(&_nelem), sizeof(_nelem));
+
+        _levels.resize(_nb_levels);
+        for (int ii=0; ii<_nb_levels; ii++)
+            _levels[ii].bitset.map(is);
+
+        load_tail(is);
+    }
+
+
+  private:
+    template<class Writer>
+    void save_final_hash(Writer& os) const {
+        size_t final_hash_size = _final_hash.size();
+
+        os.write(reinterpret_cast<char const*>(&final_hash_size), sizeof(size_t));
+        for (auto it = _final_hash.begin(); it != _final_hash.end(); ++it) {
+            os.write(reinterpret_cast<char const*>(&(it->first)), sizeof(internal_hash_t));
+            os.write(reinterpret_cast<char const*>(&(it->second)), sizeof(uint64_t));
+        }
+    }
+
+    // restore the sizes of the levels and the final hash
+    template<class Reader>
+    void load_tail(Reader& is) {
         // mini setup, recompute size of each level
         _proba_collision = 1.0 -  pow(((_gamma*(double)_nelem -1 ) / (_gamma*(double)_nelem)),_nelem-1);
-        uint64_t previous_idx =0;
         _hash_domain = (size_t)(ceil(double(_nelem) * _gamma)) ;
         for (int ii=0; ii<_nb_levels; ii++) {
             _levels[ii].hash_domain =  ((uint64_t(_hash_domain * pow(_proba_collision,ii)) + 63) / 64) * 64;
@@ -570,8 +686,6 @@ class mphf {
         _built = true;
     }
 
-
-  private:
     void setup() {
         if (_fastmode)
             setLevelFastmode.resize(_percent_elem_loaded_for_fastMode * (double)_nelem);
@@ -14,6 +14,8 @@ option(SPADES_DEBUG_LOGGING "Turn on debug / trace logging" ON)
 
 option(SPADES_ENABLE_EXPENSIVE_CHECKS "Turn on expensive checks in hot places" OFF)
 
+option(SPADES_PAIRED_INDEX_HASHMAP "Use hash tables instead of b-trees in paired info indices" OFF)
+
 # Define option to enable / disable ASAN
 option(SPADES_ENABLE_ASAN "Turn on / off address sanitizer" OFF)
 if (SPADES_ENABLE_ASAN)
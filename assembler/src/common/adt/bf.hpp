@@ -1,5 +1,8 @@
 #pragma once
 
+#include "utils/verify.hpp"
+
+#include <algorithm>
 #include <functional>
 #include <vector>
 #include <atomic>
@@ -217,5 +220,125 @@ public:
     }
 };
 
+/// The counting Bloom filter keeping all the cells of an element within the
+/// same 64-byte block, so add() and lookup() touch a single cache line. The
+/// hasher is a functor returning one digest per element: the block is chosen
+/// by its high bits, the cells inside the block by the low ones. The cells an
+/// element hits several times are incremented once.
+template<class T, class Hasher, unsigned width_ = 4, unsigned num_hashes_ = 3>
+class blocked_counting_bloom_filter {
+    blocked_counting_bloom_filter(const blocked_counting_bloom_filter &) = delete;
+    blocked_counting_bloom_filter &operator=(const blocked_counting_bloom_filter &) = delete;
+
+    static constexpr unsigned log2(unsigned n) {
+        return n > 1 ? 1 + log2(n / 2) : 0;
+    }
+
+    static constexpr unsigned entries_per_block_ = 64 / sizeof(uint64_t);
+    static constexpr uint64_t cell_mask_ = (1ull << width_) - 1;
+    // Lowest bits of all the cells of an entry
+    static constexpr uint64_t low_bits_ = ~0ull / cell_mask_;
+    static constexpr unsigned cells_per_entry_ = 8 * sizeof(uint64_t) / width_;
+    static constexpr unsigned cells_per_block_ = entries_per_block_ * cells_per_entry_;
+    static constexpr unsigned cell_bits_ = log2(cells_per_block_);
+
+public:
+    /// The hash digest type.
+    typedef uint64_t digest;
+
+    /// The hash function type.
+    typedef Hasher hasher;
+
+    /// Constructs a counting Bloom filter.
+    /// @param cells The number of cells, rounded up to the whole blocks.
+    /// @param h The hasher.
+    /// The memory consumption will be cells * width bits
+    blocked_counting_bloom_filter(size_t cells, hasher h = hasher())
+            : hasher_(std::move(h)),
+              blocks_(std::max<size_t>(1, (cells + cells_per_block_ - 1) / cells_per_block_)),
+              data_(blocks_ * entries_per_block_ + entries_per_block_ - 1) {
+        static_assert((width_ & (width_ - 1)) == 0 && width_ <= 8, "Width must be power of two up to 8");
+        static_assert(num_hashes_ * cell_bits_ <= 8 * sizeof(digest), "Too many hash functions");
+
+        // std::vector does not align its data to the cache line
+        uintptr_t addr = reinterpret_cast<uintptr_t>(data_.data());
+        offset_ = (64 - addr % 64) % 64 / sizeof(uint64_t);
+    }
+
+    /// Move-constructs a counting Bloom filter.
+    blocked_counting_bloom_filter(blocked_counting_bloom_filter &&) = default;
+
+    /// Adds an element to the Bloom filter.
+    /// @param o An instance of type `T`.
+    void add(const T &o) {
+        digest d = hasher_(o);
+        std::atomic<uint64_t> *block = this->block(d);
+
+        uint64_t incs[entries_per_block_] = {};
+        for (unsigned i = 0; i < num_hashes_; ++i) {
+            unsigned cell_id = unsigned(d >> (i * cell_bits_)) & (cells_per_block_ - 1);
+            incs[cell_id / cells_per_entry_] |= 1ull << (width_ * (cell_id % cells_per_entry_));
+        }
+
+        for (unsigned i = 0; i < entries_per_block_; ++i) {
+            if (!incs[i])
+                continue;
+
+            // Increment all the cells of the entry at once, saturated ones are left as is
+            uint64_t val = block[i].load(std::memory_order_relaxed), newval;
+            do {
+                newval = val + (incs[i] & ~saturated(val));
+            } while (newval != val &&
+                     !block[i].compare_exchange_weak(val, newval, std::memory_order_relaxed));
+        }
+    }
+
+    /// Retrieves the count of an element.
+    /// @param o An instance of type `T`.
+    /// @return A frequency estimate for *o*.
+    size_t lookup(const T &o) const {
+        digest d = hasher_(o);
+        const std::atomic<uint64_t> *block = this->block(d);
+
+        size_t val = cell_mask_;
+        for (unsigned i = 0; i < num_hashes_; ++i) {
+            unsigned cell_id = unsigned(d >> (i * cell_bits_)) & (cells_per_block_ - 1);
+            uint64_t entry = block[cell_id / cells_per_entry_].load(std::memory_order_relaxed);
+            size_t cval = (entry >> (width_ * (cell_id % cells_per_entry_))) & cell_mask_;
+            if (val > cval)
+                val = cval;
+        }
+
+        return val;
+    }
+
+    /// Removes all items from the Bloom filter.
+    void clear() {
+        for (auto &entry : data_)
+            entry.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // Lowest bits of the cells having all the bits set
+    static uint64_t saturated(uint64_t val) {
+        for (unsigned shift = 1; shift < width_; shift *= 2)
+            val &= val >> shift;
+        return val & low_bits_;
+    }
+
+    // Multiply-shift instead of modulo
+    std::atomic<uint64_t> *block(digest d) {
+        return data_.data() + offset_ + size_t((unsigned __int128)d * blocks_ >> 64) * entries_per_block_;
+    }
+
+    const std::atomic<uint64_t> *block(digest d) const {
+        return data_.data() + offset_ + size_t((unsigned __int128)d * blocks_ >> 64) * entries_per_block_;
+    }
+
+    hasher hasher_;
+    size_t blocks_;
+    size_t offset_;
+    std::vector<std::atomic<uint64_t>> data_;
+};
 
 } // namespace bf
@@ -21,7 +21,7 @@ class cqf {
 
     cqf(uint64_t maxn)
             : insertions_(0) {
-        unsigned qbits = std::max(7u, unsigned(ceil(log2(double(maxn))))) + 1;
+        unsigned qbits = quotient_bits(maxn);
         num_hash_bits_ = qbits + 8;
         num_slots_ = (1ULL << qbits);
         qf_init(&qf_, num_slots_, num_hash_bits_, 0, 42);
@@ -39,6 +39,12 @@ class cqf {
 
     cqf(cqf&&) noexcept = default;
 
+    /// # of hash bits cqf(maxn) uses. The filter created with them might be
+    /// started small and expanded up to maxn elements without losing precision.
+    static unsigned hash_bits_for(uint64_t maxn) {
+        return quotient_bits(maxn) + 8;
+    }
+
     bool add(digest d, uint64_t count = 1,
              bool lock = true, bool spin = true) {
         bool res = qf_insert(&qf_, d & range_mask_, 0, count, lock, spin);
@@ -85,6 +91,10 @@ class cqf {
     }
 
 private:
+    static unsigned quotient_bits(uint64_t maxn) {
+        return std::max(7u, unsigned(ceil(log2(double(maxn))))) + 1;
+    }
+
     void merge(QF *qf, QF *other) {
         QFi other_cfi;
 
@@ -184,6 +184,11 @@ public:
         entry_[0] = replay(winner_index);
     }
 
+    // Remaining parts of the runs (including the sentinels)
+    const std::vector<adt::iterator_range<It>> &runs() const {
+        return runs_;
+    }
+
 private:
     std::vector<adt::iterator_range<It>> runs_;
 };
@@ -0,0 +1,123 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io/binary/binary.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace adt {
+
+// Vector which elements could be located in the memory it does not own
+// (e.g. mapped from a file). Such memory is used in place until the vector
+// is resized, then the elements are copied into the owned storage.
+template<class T>
+class mappable_vector {
+  public:
+    typedef size_t size_type;
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef T &reference;
+    typedef const T &const_reference;
+
+    mappable_vector()
+            : data_(nullptr), size_(0) {}
+
+    mappable_vector(const mappable_vector &other)
+            : storage_(other.begin(), other.end()) {
+        update();
+    }
+
+    mappable_vector(mappable_vector &&other) noexcept
+            : mappable_vector() {
+        swap(other);
+    }
+
+    mappable_vector &operator=(mappable_vector other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void swap(mappable_vector &other) noexcept {
+        std::swap(storage_, other.storage_);
+        std::swap(holder_, other.holder_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    // Uses size elements located at data, holder keeps the memory alive
+    void map(T *data, size_t size, std::shared_ptr<void> holder) {
+        storage_.clear();
+        storage_.shrink_to_fit();
+        holder_ = std::move(holder);
+        data_ = data;
+        size_ = size;
+    }
+
+    bool mapped() const { return holder_ != nullptr; }
+
+    void resize(size_t size) {
+        if (mapped()) {
+            storage_.assign(data_, data_ + std::min(size, size_));
+            holder_.reset();
+        }
+        storage_.resize(size);
+        update();
+    }
+
+    void clear() {
+        storage_.clear();
+        holder_.reset();
+        update();
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+
+    T &operator[](size_t i) { return data_[i]; }
+    const T &operator[](size_t i) const { return data_[i]; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+
+    // Same as for std::vector
+    void BinWrite(std::ostream &os) const {
+        io::binary::BinWrite(os, size_);
+        for (const T &v : *this)
+            io::binary::BinWrite(os, v);
+    }
+
+    void BinRead(std::istream &is) {
+        clear();
+        resize(io::binary::BinRead<size_t>(is));
+        for (T &v : *this)
+            io::binary::BinRead(is, v);
+    }
+
+  private:
+    void update() {
+        data_ = storage_.data();
+        size_ = storage_.size();
+    }
+
+    std::vector<T> storage_;
+    std::shared_ptr<void> holder_;
+    T *data_;
+    size_t size_;
+};
+
+}
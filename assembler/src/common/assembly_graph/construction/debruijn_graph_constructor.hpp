@@ -10,8 +10,13 @@
 #include "assembly_graph/core/construction_helper.hpp"
 #include "utils/extension_index/kmer_extension_index.hpp"
 #include "utils/parallel/openmp_wrapper.h"
-#include "utils/parallel/parallel_wrapper.hpp"
+
+#include <folly/SmallLocks.h>
+
+#include <algorithm>
+#include <atomic>
 #include <numeric>
+#include <shared_mutex>
 
 namespace debruijn_graph {
 
@@ -179,6 +184,77 @@ private:
     DECL_LOGGER("DeBruijnGraphConstructor")
 };
 
+// Edge sequences are kept in the chunks they were extracted in, so no concatenated copy is made
+typedef std::vector<std::vector<Sequence>> SequenceChunks;
+
+/*
+ * Concurrent set of the k-mers of the extension index given by their indices
+ */
+class ConcurrentKmerSet {
+public:
+    explicit ConcurrentKmerSet(size_t size = 0)
+            : data_((size + 63) / 64) {}
+
+    bool empty() const { return data_.empty(); }
+
+    void insert(size_t idx) {
+        auto &entry = data_[idx >> 6];
+        uint64_t bit = uint64_t(1) << (idx & 63);
+        // The same k-mers are usually inserted several times
+        if (!(entry.load(std::memory_order_relaxed) & bit))
+            entry.fetch_or(bit, std::memory_order_relaxed);
+    }
+
+    bool contains(size_t idx) const {
+        return data_[idx >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (idx & 63));
+    }
+
+    /**
+     * @brief  Numbers the k-mers in the order of their indices. Must not be called concurrently with insert().
+     * @return the size of the set
+     */
+    size_t BuildRanks() {
+        ranks_.resize((data_.size() + RANK_WORDS - 1) / RANK_WORDS);
+        size_t rank = 0;
+        for (size_t i = 0; i < data_.size(); ++i) {
+            if (i % RANK_WORDS == 0)
+                ranks_[i / RANK_WORDS] = rank;
+            rank += __builtin_popcountll(data_[i].load(std::memory_order_relaxed));
+        }
+        return rank;
+    }
+
+    // Number of the k-mers in the set with the lesser indices
+    size_t rank(size_t idx) const {
+        size_t word = idx >> 6;
+        size_t res = ranks_[word / RANK_WORDS];
+        for (size_t i = word - word % RANK_WORDS; i < word; ++i)
+            res += __builtin_popcountll(data_[i].load(std::memory_order_relaxed));
+        uint64_t lesser = data_[word].load(std::memory_order_relaxed) & ((uint64_t(1) << (idx & 63)) - 1);
+        return res + __builtin_popcountll(lesser);
+    }
+
+    // Calls f(idx, rank) for every k-mer in the set, in parallel
+    template<class F>
+    void ForEach(const F &f) const {
+#       pragma omp parallel for schedule(guided)
+        for (size_t block = 0; block < ranks_.size(); ++block) {
+            size_t rank = ranks_[block];
+            size_t end = std::min(data_.size(), (block + 1) * RANK_WORDS);
+            for (size_t i = block * RANK_WORDS; i < end; ++i) {
+                for (uint64_t word = data_[i].load(std::memory_order_relaxed); word; word &= word - 1)
+                    f(i * 64 + __builtin_ctzll(word), rank++);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t RANK_WORDS = 8;
+
+    std::vector<std::atomic<uint64_t>> data_;
+    std::vector<size_t> ranks_;
+};
+
 class UnbranchingPathExtractor {
 private:
     typedef utils::DeBruijnExtensionIndex<> Index;
@@ -189,6 +265,8 @@ private:
 
     Index &origin_;
     size_t kmer_size_;
+    // K-mers lying on the extracted paths, filled only when the perfect loops are collected
+    ConcurrentKmerSet visited_;
 
     bool IsJunction(KeyWithHash kwh) const {
         return IsJunction(origin_.get_value(kwh));
@@ -233,13 +311,20 @@ private:
         return false;
     }
 
-    Sequence ConstructSequenceWithEdge(DeEdge edge, SequenceBuilder &builder) const {
+    void Visit(const KeyWithHash &kwh) {
+        if (!visited_.empty())
+            visited_.insert(kwh.idx());
+    }
+
+    Sequence ConstructSequenceWithEdge(DeEdge edge, SequenceBuilder &builder) {
         builder.clear(); // We reuse the buffer to reduce malloc traffic
         builder.append(edge.start.key());
         builder.append(edge.end[kmer_size_ - 1]);
+        Visit(edge.end);
         DeEdge initial = edge;
         while (StepRightIfPossible(edge) && edge != initial) {
             builder.append(edge.end[kmer_size_ - 1]);
+            Visit(edge.end);
         }
         return builder.BuildSequence();
     }
@@ -252,7 +337,7 @@ private:
     }
 
 //  TODO Think about what happends to self rc perfect loops
-    std::vector<Sequence> ConstructLoopFromVertex(const KeyWithHash &kh, SequenceBuilder &builder) const {
+    std::vector<Sequence> ConstructLoopFromVertex(const KeyWithHash &kh, SequenceBuilder &builder) {
         DeEdge break_point(kh, origin_.GetUniqueOutgoing(kh));
         Sequence s = ConstructSequenceWithEdge(break_point, builder);
         Kmer kmer = s.start<Kmer>(kmer_size_ + 1) >> 'A';
@@ -265,7 +350,7 @@ private:
     }
 
     void CalculateSequences(kmer_iterator &it,
-                            std::vector<Sequence> &sequences) const {
+                            std::vector<Sequence> &sequences) {
         SequenceBuilder builder;
         std::vector<DeEdge> start_edges;
         start_edges.reserve(8);
@@ -285,61 +370,58 @@ private:
         }
     }
 
-    void CleanCondensed(const Sequence &sequence) {
-        Kmer kmer = sequence.start<Kmer>(kmer_size_);
-        KeyWithHash kwh = origin_.ConstructKWH(kmer);
-        origin_.IsolateVertex(kwh);
-        for (size_t pos = kmer_size_; pos < sequence.size(); pos++) {
-            kwh = kwh << sequence[pos];
-            origin_.IsolateVertex(kwh);
-        }
-    }
+    // Walks the perfect loop through kh marking its k-mers. Returns the canonical k-mer with the least index,
+    // so the loop is constructed the same way whichever of its k-mers is reached first.
+    KeyWithHash VisitLoop(const KeyWithHash &kh) {
+        KeyWithHash res = kh, cur = kh;
+        do {
+            visited_.insert(cur.idx());
+            if (cur.idx() < res.idx())
+                res = cur;
+            cur = origin_.GetUniqueOutgoing(cur);
+        } while (cur != kh);
 
-    void CleanCondensed(const std::vector<Sequence> &sequences) {
-#       pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < sequences.size(); ++i) {
-            CleanCondensed(sequences[i]);
-            CleanCondensed(!sequences[i]);
-        }
+        return res.is_minimal() ? res : !res;
     }
 
     // This methods collects all loops that were not extracted by finding
-    // unbranching paths because there are no junctions on loops.
-    const std::vector<Sequence> CollectLoops(unsigned nchunks) {
+    // unbranching paths because there are no junctions on loops. These are
+    // exactly the k-mers not visited by the unbranching paths.
+    SequenceChunks CollectLoops(unsigned nchunks) {
         INFO("Collecting perfect loops");
         auto its = origin_.kmer_begin(nchunks);
-        std::vector<std::vector<KeyWithHash> > starts(its.size());
+        std::vector<std::vector<std::pair<size_t, Sequence>>> loops(its.size());
 
-#       pragma omp parallel for schedule(guided)
+#       pragma omp parallel for schedule(dynamic, 1)
         for (size_t i = 0; i < its.size(); ++i) {
-            auto &it = its[i];
-            for (; it.good(); ++it) {
+            SequenceBuilder builder;
+            for (auto &it = its[i]; it.good(); ++it) {
                 KeyWithHash kh = origin_.ConstructKWH(Kmer(kmer_size_, *it));
-                if (!IsJunction(kh))
-                    starts[i].push_back(kh);
-            }
-        }
-
-        std::vector<Sequence> result;
-        SequenceBuilder builder;
-        for (const auto& entry : starts) {
-            for (const auto& kwh : entry) {
-                if (IsJunction(kwh))
+                if (visited_.contains(kh.idx()) || IsJunction(kh))
                     continue;
 
-                for (Sequence s : ConstructLoopFromVertex(kwh, builder)) {
+                KeyWithHash start = VisitLoop(kh);
+                for (Sequence s : ConstructLoopFromVertex(start, builder)) {
                     Sequence s_rc = !s;
-                    if (s < s_rc)
-                        result.push_back(s_rc);
-                    else
-                        result.push_back(s);
-
-                    CleanCondensed(s);
-                    CleanCondensed(s_rc);
+                    loops[i].emplace_back(start.idx(), s < s_rc ? s_rc : s);
                 }
             }
         }
-        INFO("Collecting perfect loops finished. " << result.size() << " loops collected");
+
+        // Loops reached concurrently from several k-mers are collected more than once
+        std::vector<std::pair<size_t, Sequence>> merged;
+        for (auto &chunk : loops) {
+            merged.insert(merged.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end()));
+            std::vector<std::pair<size_t, Sequence>>().swap(chunk);
+        }
+        std::sort(merged.begin(), merged.end());
+        merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+        SequenceChunks result(1);
+        result[0].reserve(merged.size());
+        for (auto &entry : merged)
+            result[0].push_back(std::move(entry.second));
+        INFO("Collecting perfect loops finished. " << result[0].size() << " loops collected");
         return result;
     }
 
@@ -347,13 +429,12 @@ public:
     UnbranchingPathExtractor(Index &origin, size_t k)
             : origin_(origin), kmer_size_(k) {}
 
-    //TODO very large vector is returned. But I hate to make all those artificial changes that can fix it.
-    const std::vector<Sequence> ExtractUnbranchingPaths(unsigned nchunks) const {
+    SequenceChunks ExtractUnbranchingPaths(unsigned nchunks) {
         auto its = origin_.kmer_begin(nchunks);
 
         INFO("Extracting unbranching paths");
-        std::vector<std::vector<Sequence>> sequences(its.size());
-#       pragma omp parallel for schedule(guided)
+        SequenceChunks sequences(its.size());
+#       pragma omp parallel for schedule(dynamic, 1)
         for (size_t i = 0; i < its.size(); ++i)
             CalculateSequences(its[i], sequences[i]);
 
@@ -362,109 +443,122 @@ public:
                                       [](size_t val, const std::vector<Sequence> &s) {
                                           return val + s.size();
                                       });
-        sequences[0].reserve(snum);
-        for (size_t i = 1; i < sequences.size(); ++i) {
-            sequences[0].insert(sequences[0].end(),
-                                std::make_move_iterator(sequences[i].begin()), std::make_move_iterator(sequences[i].end()));
-            sequences[i].clear();
-            sequences[i].shrink_to_fit();
-        }
-
-        INFO("Extracting unbranching paths finished. " << sequences[0].size() << " sequences extracted");
-        return sequences[0];
+        INFO("Extracting unbranching paths finished. " << snum << " sequences extracted");
+        return sequences;
     }
 
-    const std::vector<Sequence> ExtractUnbranchingPathsAndLoops(unsigned nchunks) {
-        std::vector<Sequence> result = ExtractUnbranchingPaths(nchunks);
-        CleanCondensed(result);
-        std::vector<Sequence> loops = CollectLoops(nchunks);
+    SequenceChunks ExtractUnbranchingPathsAndLoops(unsigned nchunks) {
+        visited_ = ConcurrentKmerSet(origin_.size());
+        SequenceChunks result = ExtractUnbranchingPaths(nchunks);
+        SequenceChunks loops = CollectLoops(nchunks);
         result.insert(result.end(),
                       std::make_move_iterator(loops.begin()), std::make_move_iterator(loops.end()));
+        visited_ = ConcurrentKmerSet();
         return result;
     }
 
+    /**
+     * @brief  Passes the paths to process(sequences, offset) chunk by chunk as soon as they are extracted,
+     *         so they are never kept all together. The chunks are processed concurrently in the order of
+     *         extraction, offset being the number of paths in the preceding chunks.
+     * @return the number of paths
+     */
+    template<class Processor>
+    size_t ExtractUnbranchingPaths(unsigned nchunks, const Processor &process) {
+        auto its = origin_.kmer_begin(nchunks);
+
+        INFO("Extracting unbranching paths");
+        size_t total = 0;
+#       pragma omp parallel for schedule(dynamic, 1) ordered
+        for (size_t i = 0; i < its.size(); ++i) {
+            std::vector<Sequence> sequences;
+            CalculateSequences(its[i], sequences);
+
+            size_t offset;
+#           pragma omp ordered
+            {
+                offset = total;
+                total += sequences.size();
+            }
+            process(sequences, offset);
+        }
+
+        INFO("Extracting unbranching paths finished. " << total << " sequences extracted");
+        return total;
+    }
+
+    template<class Processor>
+    size_t ExtractUnbranchingPathsAndLoops(unsigned nchunks, const Processor &process) {
+        visited_ = ConcurrentKmerSet(origin_.size());
+        size_t total = ExtractUnbranchingPaths(nchunks, process);
+        SequenceChunks loops = CollectLoops(nchunks);
+        process(loops[0], total);
+        total += loops[0].size();
+        visited_ = ConcurrentKmerSet();
+        return total;
+    }
+
 private:
     DECL_LOGGER("UnbranchingPathExtractor")
 };
 
+/*
+ * Builds the graph from the edge sequences. Vertices are the canonical k-mers at the ends of the edges:
+ * they are collected in the set indexed by the extension index and numbered in the order of the indices.
+ */
 template<class Graph>
 class FastGraphFromSequencesConstructor {
 private:
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::HelperT Helper;
     typedef RtSeq Kmer;
     typedef utils::DeBruijnExtensionIndex<> Index;
     size_t kmer_size_;
     Index &origin_;
 
-    class LinkRecord {
-    private:
-        size_t hash_and_mask_;
-        EdgeId edge_;
-
-        size_t BitBool(bool flag) const {
-            if (flag)
-                return 1;
-            return 0;
-        }
-
-    public:
-        size_t GetHash() const { return hash_and_mask_ >> 2; }
-        bool IsRC() const { return hash_and_mask_ & 2; }
-        bool IsStart() const { return hash_and_mask_ & 1; }
-        EdgeId GetEdge() const { return edge_; }
-        bool IsInvalid() { return hash_and_mask_ + 1 == 0 && edge_ == EdgeId(); }
-
-        LinkRecord(size_t hash, EdgeId edge, bool is_start, bool is_rc)
-                : hash_and_mask_((hash << 2) | (BitBool(is_rc) << 1)| BitBool(is_start)), edge_(edge) { }
-
-        LinkRecord()
-                : hash_and_mask_(-1ul) {}
-
-
-        bool operator<(const LinkRecord &other) const {
-            if (this->hash_and_mask_ == other.hash_and_mask_)
-                return this->edge_ < other.edge_;
-            return this->hash_and_mask_ < other.hash_and_mask_;
-        }
-    };
-
-    LinkRecord StartLink(const EdgeId &edge, const Sequence &sequence) const {
-        Kmer kmer(kmer_size_, sequence);
+    // Index of the canonical k-mer of the vertex and whether the edge is linked to its conjugate
+    std::pair<size_t, bool> VertexKmer(const Kmer &kmer) const {
         Kmer kmer_rc = !kmer;
         if (kmer < kmer_rc)
-            return LinkRecord(origin_.ConstructKWH(kmer).idx(), edge, true, false);
+            return { origin_.ConstructKWH(kmer).idx(), false };
         else
-            return LinkRecord(origin_.ConstructKWH(kmer_rc).idx(), edge, true, true);
+            return { origin_.ConstructKWH(kmer_rc).idx(), true };
     }
 
-    LinkRecord EndLink(const EdgeId &edge, const Sequence &sequence) const {
-        Kmer kmer(kmer_size_, sequence, sequence.size() - kmer_size_);
-        Kmer kmer_rc = !kmer;
-        if (kmer < kmer_rc)
-            return LinkRecord(origin_.ConstructKWH(kmer).idx(), edge, false, false);
-        else
-            return LinkRecord(origin_.ConstructKWH(kmer_rc).idx(), edge, false, true);
+    Kmer StartKmer(const Sequence &sequence) const {
+        return Kmer(kmer_size_, sequence);
+    }
+
+    Kmer EndKmer(const Sequence &sequence) const {
+        return Kmer(kmer_size_, sequence, sequence.size() - kmer_size_);
     }
 
-    void CollectLinkRecords(typename Graph::HelperT &helper, const Graph &graph,
-                            std::vector<LinkRecord> &records, const std::vector<Sequence> &sequences) const {
-        size_t size = sequences.size();
+    // Every path is walked from the junctions on both of its strands (self-conjugate ones only once)
+    size_t CountPathWalks() const {
+        size_t res = 0;
+        auto values = origin_.value_begin();
+#       pragma omp parallel for reduction(+:res)
+        for (size_t i = 0; i < origin_.size(); ++i) {
+            const utils::InOutMask &mask = values[i];
+            if (mask.IsJunction())
+                res += mask.OutgoingEdgeCount() + mask.IncomingEdgeCount();
+        }
+        return res;
+    }
+
+    void AddEdges(Helper &helper, const Graph &graph, const std::vector<Sequence> &sequences, size_t offset,
+                  ConcurrentKmerSet &vertices) const {
         uint64_t min_id = graph.min_id();
-        records.resize(size * 2, LinkRecord(0, EdgeId(), false, false));
-#       pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < size; ++i) {
-            size_t j = i << 1;
-            EdgeId edge = helper.AddEdge(DeBruijnEdgeData(sequences[i]), min_id + j);
-            records[j] = StartLink(edge, sequences[i]);
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            EdgeId edge = helper.AddEdge(DeBruijnEdgeData(graph.master().Own(sequences[i])), min_id + 2 * (offset + i));
+            vertices.insert(VertexKmer(StartKmer(sequences[i])).first);
             if (graph.conjugate(edge) != edge)
-                records[j + 1] = EndLink(edge, sequences[i]);
-            else
-                records[j + 1] = LinkRecord();
+                vertices.insert(VertexKmer(EndKmer(sequences[i])).first);
         }
     }
 
-    void LinkEdge(typename Graph::HelperT &helper, const Graph &graph, const VertexId v,
+    void LinkEdge(Helper &helper, const Graph &graph, const VertexId v,
                   const EdgeId edge, const bool is_start, const bool is_rc) const {
         VertexId v1 = v;
         if (is_rc)
@@ -476,44 +570,96 @@ private:
             helper.LinkIncomingEdge(v1, edge);
     }
 
-public:
-    FastGraphFromSequencesConstructor(size_t k, Index &origin)
-            : kmer_size_(k), origin_(origin) {}
-
-    void ConstructGraph(Graph &graph, const std::vector<Sequence> &sequences) const {
-        typename Graph::HelperT helper = graph.GetConstructionHelper();
-
-        std::vector<LinkRecord> records;
-        INFO("Total " << 2*sequences.size() << " edges to create");
-        graph.ereserve(size_t(2.01*sequences.size()));
-        INFO("Collecting link records")
-        CollectLinkRecords(helper, graph, records, sequences);
-        INFO("Ordering link records")
-        parallel::sort(records.begin(), records.end());
-        INFO("Sorting done");
-        std::vector<size_t> vertex_pos;
-        for (size_t i = 0; i < records.size(); i++) {
-            if (i != 0 && records[i].GetHash() == records[i - 1].GetHash())
-                continue;
-            if (records[i].IsInvalid())
-                continue;
-            vertex_pos.push_back(i);
-        }
-        size_t size = vertex_pos.size();
+    void ConnectVertices(Helper &helper, Graph &graph, size_t count, ConcurrentKmerSet &vertices) const {
+        size_t size = vertices.BuildRanks();
         INFO("Total " << size << " vertices to create");
         graph.vreserve(size_t(2.01*size));
+        uint64_t min_id = graph.min_id();
+        vertices.ForEach([&](size_t, size_t rank) {
+            helper.CreateVertex(DeBruijnVertexData(), min_id + 2 * rank);
+        });
 
         INFO("Connecting the graph");
-        uint64_t min_id = graph.min_id();
+        // Edges of the same vertex are linked concurrently
+        std::vector<folly::MicroSpinLock> locks(1 << 16);
+        auto link = [&](EdgeId edge, const Kmer &kmer, bool is_start) {
+            auto vertex = VertexKmer(kmer);
+            size_t rank = vertices.rank(vertex.first);
+            folly::MSLGuard guard(locks[rank % locks.size()]);
+            LinkEdge(helper, graph, VertexId(min_id + 2 * rank), edge, is_start, vertex.second);
+        };
+
 #       pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < size; i++) {
-            size_t pos = vertex_pos[i];
+        for (size_t i = 0; i < count; ++i) {
+            EdgeId edge(min_id + 2 * i);
+            const Sequence &sequence = graph.EdgeNucls(edge);
+            link(edge, StartKmer(sequence), true);
+            if (graph.conjugate(edge) != edge)
+                link(edge, EndKmer(sequence), false);
+        }
+    }
 
-            VertexId v = helper.CreateVertex(DeBruijnVertexData(), min_id + 2*i);
-            for (size_t j = pos; j < records.size() && records[j].GetHash() == records[pos].GetHash(); ++j) {
-                LinkEdge(helper, graph, v, records[j].GetEdge(), records[j].IsStart(), records[j].IsRC());
-            }
+public:
+    FastGraphFromSequencesConstructor(size_t k, Index &origin)
+            : kmer_size_(k), origin_(origin) {}
+
+    void ConstructGraph(Graph &graph, SequenceChunks &&chunks) const {
+        Helper helper = graph.GetConstructionHelper();
+
+        std::vector<size_t> offsets(chunks.size() + 1, 0);
+        for (size_t c = 0; c < chunks.size(); ++c)
+            offsets[c + 1] = offsets[c] + chunks[c].size();
+
+        size_t count = offsets.back();
+        INFO("Total " << 2*count << " edges to create");
+        graph.ereserve(size_t(2.01*count));
+        ConcurrentKmerSet vertices(origin_.size());
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            AddEdges(helper, graph, chunks[c], offsets[c], vertices);
+            // Edges own the sequences now
+            std::vector<Sequence>().swap(chunks[c]);
         }
+
+        ConnectVertices(helper, graph, count, vertices);
+    }
+
+    /**
+     * @brief  Turns the paths into the edges as soon as they are extracted, so the sequences of all paths
+     *         are never kept together.
+     */
+    void ConstructGraph(Graph &graph, UnbranchingPathExtractor &extractor,
+                        unsigned nchunks, bool keep_perfect_loops) const {
+        Helper helper = graph.GetConstructionHelper();
+        ConcurrentKmerSet vertices(origin_.size());
+
+        // There are as many edges as the walks unless there are self-conjugate paths. Storage is grown if
+        // needed, while no edges are being added.
+        size_t walks = CountPathWalks();
+        graph.ereserve(walks + walks / 64 + 64);
+        std::shared_timed_mutex storage_mutex;
+        auto process = [&](const std::vector<Sequence> &sequences, size_t offset) {
+            size_t ids = 2 * (offset + sequences.size());
+            bool reserved;
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(storage_mutex);
+                reserved = graph.ereserved() >= ids;
+            }
+            if (!reserved) {
+                std::lock_guard<std::shared_timed_mutex> lock(storage_mutex);
+                if (graph.ereserved() < ids)
+                    graph.ereserve(std::max(ids, 2 * graph.ereserved()));
+            }
+
+            std::shared_lock<std::shared_timed_mutex> lock(storage_mutex);
+            AddEdges(helper, graph, sequences, offset, vertices);
+        };
+
+        size_t count = keep_perfect_loops ?
+                       extractor.ExtractUnbranchingPathsAndLoops(nchunks, process) :
+                       extractor.ExtractUnbranchingPaths(nchunks, process);
+        INFO("Total " << 2*count << " edges created");
+        ConnectVertices(helper, graph, count, vertices);
     }
 };
 
@@ -538,13 +684,10 @@ public:
     }
 
     void ConstructGraph(bool keep_perfect_loops) {
-        std::vector<Sequence> edge_sequences;
         unsigned nchunks = 16 * omp_get_max_threads();
-        if (keep_perfect_loops)
-            edge_sequences = UnbranchingPathExtractor(origin_, kmer_size_).ExtractUnbranchingPathsAndLoops(nchunks);
-        else
-            edge_sequences = UnbranchingPathExtractor(origin_, kmer_size_).ExtractUnbranchingPaths(nchunks);
-        FastGraphFromSequencesConstructor<Graph>(kmer_size_, origin_).ConstructGraph(graph_, edge_sequences);
+        UnbranchingPathExtractor extractor(origin_, kmer_size_);
+        FastGraphFromSequencesConstructor<Graph>(kmer_size_, origin_).ConstructGraph(graph_, extractor, nchunks,
+                                                                                     keep_perfect_loops);
     }
 
 private:
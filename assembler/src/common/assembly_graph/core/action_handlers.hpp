@@ -8,6 +8,7 @@
 #ifndef __OMNI_ACTION_HANDLERS_HPP__
 #define __OMNI_ACTION_HANDLERS_HPP__
 
+#include "id_renumbering.hpp"
 #include "utils/verify.hpp"
 #include "utils/logger/logger.hpp"
 
@@ -119,6 +120,21 @@ public:
     virtual void HandleSplit(EdgeId /*old_edge*/, EdgeId /*new_edge_1*/,
                              EdgeId /*new_edge_2*/) { }
 
+    /**
+     * Event which is triggered when the graph is compacted and all the vertices and edges get
+     * new ids. Handler should translate all the ids it stores.
+     * @param renumbering translation of the old ids to the new ones
+     */
+    virtual void HandleRenumbering(const IdRenumbering<VertexId, EdgeId> & /*renumbering*/) { }
+
+    /**
+     * Every descendant supporting HandleRenumbering (or not storing any ids) should override this
+     * method, otherwise graph compaction is not possible while the handler exists.
+     */
+    virtual bool IsRenumberable() const {
+        return false;
+    }
+
     /**
      * Every thread safe descendant should override this method for correct concurrent graph processing.
      */
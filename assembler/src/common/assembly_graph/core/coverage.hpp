@@ -92,6 +92,13 @@ class CoverageIndex : public GraphActionHandler<Graph> {
         }
     }
 
+    /*
+     * Coverage is stored in the edge data
+     */
+    bool IsRenumberable() const override {
+        return true;
+    }
+
     void Save(EdgeId e, std::ostream& out) const {
         out << fmt::format("{:.6f}", coverage(e));
     }
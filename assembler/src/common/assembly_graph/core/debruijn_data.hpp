@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <set>
+#include <memory>
 #include <cstring>
 #include <cstdint>
 
@@ -97,13 +98,26 @@ public:
 class DeBruijnDataMaster {
 private:
     const size_t k_;
+    // Optional storage of the edge nucleotides, shared by the copies of the master
+    std::shared_ptr<SequenceArena> arena_;
 
 public:
     typedef DeBruijnVertexData VertexData;
     typedef DeBruijnEdgeData EdgeData;
 
-    DeBruijnDataMaster(size_t k) :
-            k_(k) {
+    DeBruijnDataMaster(size_t k, std::shared_ptr<SequenceArena> arena = nullptr) :
+            k_(k), arena_(std::move(arena)) {
+    }
+
+    /**
+     * @brief  Returns the sequence to be stored in the edge, it is copied to the arena if one is used.
+     */
+    Sequence Own(const Sequence &nucls) const {
+        return arena_ ? Sequence(nucls, *arena_) : nucls;
+    }
+
+    const SequenceArena *arena() const {
+        return arena_.get();
     }
 
     const EdgeData MergeData(const std::vector<const EdgeData*>& to_merge, bool safe_merging = true) const;
@@ -148,7 +162,7 @@ inline const DeBruijnEdgeData DeBruijnDataMaster::MergeData(const std::vector<co
     for (auto it = to_merge.begin(); it != to_merge.end(); ++it) {
         ss.push_back((*it)->nucls());
     }
-    return EdgeData(MergeOverlappingSequences(ss, k_, safe_merging));
+    return EdgeData(Own(MergeOverlappingSequences(ss, k_, safe_merging)));
 }
 
 inline std::pair<DeBruijnVertexData, std::pair<DeBruijnEdgeData, DeBruijnEdgeData>> DeBruijnDataMaster::SplitData(const EdgeData& edge,
@@ -30,8 +30,12 @@ private:
     CoverageIndex<DeBruijnGraph> coverage_index_;
 
 public:
-    DeBruijnGraph(size_t k) :
-            base(k), coverage_index_(*this) {
+    /**
+     * @param sequence_arena store the edge nucleotides in the arena owned by the graph
+     */
+    DeBruijnGraph(size_t k, bool sequence_arena = false) :
+            base(DeBruijnDataMaster(k, sequence_arena ? SequenceArena::create() : nullptr)),
+            coverage_index_(*this) {
     }
 
     CoverageIndex<DeBruijnGraph>& coverage_index() {
@@ -62,7 +66,7 @@ public:
 
     EdgeId AddEdge(VertexId from, VertexId to, const Sequence &nucls) {
         VERIFY(nucls.size() > k());
-        return AddEdge(from, to, EdgeData(nucls));
+        return AddEdge(from, to, EdgeData(master().Own(nucls)));
     }
 
     size_t k() const {
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "id_distributor.hpp"
+#include "id_renumbering.hpp"
 #include "utils/verify.hpp"
 #include "utils/logger/logger.hpp"
 #include "utils/stl_utils.hpp"
@@ -21,6 +22,7 @@
 #include <btree/safe_btree_set.h>
 
 #include <atomic>
+#include <deque>
 #include <vector>
 #include <set>
 
@@ -325,6 +327,16 @@ private:
         uint64_t reserved() const { return id_distributor_.size(); }
         void clear_state() { id_distributor_.clear_state(); }
 
+        void swap(IdStorage &that) {
+            size_t size = size_;
+            size_ = that.size_.load();
+            that.size_ = size;
+            std::swap(bias_, that.bias_);
+            std::swap(storage_, that.storage_);
+            std::swap(storage_size_, that.storage_size_);
+            std::swap(id_distributor_, that.id_distributor_);
+        }
+
       private:
         std::atomic<size_t> size_;
         uint64_t bias_;
@@ -593,6 +605,52 @@ private:
         estorage_.erase(e.int_id());
     }
 
+    IdRenumbering<VertexId, EdgeId> TraversalOrder() const {
+        IdRenumbering<VertexId, EdgeId> renumbering(vstorage_.max_id(), estorage_.max_id());
+        uint64_t next_vid = ID_BIAS, next_eid = ID_BIAS;
+        auto number_vertex = [&](VertexId v) {
+            if (renumbering(v))
+                return false;
+            renumbering.set(v, next_vid++);
+            if (conjugate(v) != v)
+                renumbering.set(conjugate(v), next_vid++);
+            return true;
+        };
+        auto number_edge = [&](EdgeId e) {
+            if (renumbering(e))
+                return;
+            renumbering.set(e, next_eid++);
+            if (conjugate(e) != e)
+                renumbering.set(conjugate(e), next_eid++);
+        };
+
+        // Conjugate vertices are visited together, so outgoing edges of both
+        // cover all the edges incident to the vertex
+        std::deque<VertexId> queue;
+        for (VertexId start : *this) {
+            if (!number_vertex(start))
+                continue;
+            queue.push_back(start);
+            while (!queue.empty()) {
+                VertexId v = queue.front();
+                queue.pop_front();
+                for (VertexId u : { v, conjugate(v) }) {
+                    for (EdgeId e : OutgoingEdges(u)) {
+                        number_edge(e);
+                        if (number_vertex(EdgeEnd(e)))
+                            queue.push_back(EdgeEnd(e));
+                    }
+                }
+            }
+        }
+
+        // Edges without vertices
+        for (EdgeId e : edges())
+            number_edge(e);
+
+        return renumbering;
+    }
+
     bool AdditionalCompressCondition(VertexId v) const {
         return !(EdgeEnd(GetUniqueOutgoingEdge(v)) == conjugate(v) &&
                  EdgeStart(GetUniqueIncomingEdge(v)) == conjugate(v));
@@ -685,6 +743,54 @@ public:
     size_t vreserved() const { return vstorage_.reserved(); }
     size_t ereserved() const { return estorage_.reserved(); }
 
+    /**
+     * Renumbers vertices and edges in the breadth-first traversal order and
+     * rebuilds the storages in this order, so that the records (and the
+     * adjacency lists) of neighbouring elements are placed close to each
+     * other. Conjugate elements get consecutive ids.
+     * @return translation of the old ids to the new ones
+     */
+    IdRenumbering<VertexId, EdgeId> Compact() {
+        auto renumbering = TraversalOrder();
+
+        std::vector<VertexId> vertex_order(vstorage_.max_id());
+        for (VertexId v : *this)
+            vertex_order[renumbering(v).int_id()] = v;
+        std::vector<EdgeId> edge_order(estorage_.max_id());
+        for (EdgeId e : edges())
+            edge_order[renumbering(e).int_id()] = e;
+
+        size_t vcount = size(), ecount = e_size();
+        VertexStorage vstorage(ID_BIAS);
+        vstorage.reserve(vcount);
+        for (uint64_t id = ID_BIAS; id < ID_BIAS + vcount; ++id) {
+            auto &old = vertex(vertex_order[id]);
+            vstorage.emplace(id, old.data());
+            auto &v = vstorage.at(id);
+            v.set_conjugate(renumbering(old.conjugate()));
+            v.outgoing_edges_.reserve(old.outgoing_edges_.size());
+            for (EdgeId e : old.outgoing_edges_)
+                v.outgoing_edges_.push_back(renumbering(e));
+            std::sort(v.outgoing_edges_.begin(), v.outgoing_edges_.end());
+            old.outgoing_edges_.clear();
+            vstorage_.erase(vertex_order[id].int_id());
+        }
+
+        EdgeStorage estorage(ID_BIAS);
+        estorage.reserve(ecount);
+        for (uint64_t id = ID_BIAS; id < ID_BIAS + ecount; ++id) {
+            auto &old = edge(edge_order[id]);
+            estorage.emplace(id, renumbering(old.end()), old.data());
+            estorage.at(id).set_conjugate(renumbering(old.conjugate()));
+            estorage_.erase(edge_order[id].int_id());
+        }
+
+        vstorage_.swap(vstorage);
+        estorage_.swap(estorage);
+
+        return renumbering;
+    }
+
     uint64_t min_id() const noexcept { return ID_BIAS; }
 
     bool contains(VertexId vertex) const {
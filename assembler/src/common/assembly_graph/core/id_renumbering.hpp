@@ -0,0 +1,45 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace omnigraph {
+
+/**
+ * Translation of graph element ids produced by graph compaction. Ids of the
+ * elements which were not present in the graph are translated to the null id.
+ */
+template<typename VertexId, typename EdgeId>
+class IdRenumbering {
+    std::vector<uint64_t> vertices_;
+    std::vector<uint64_t> edges_;
+
+  public:
+    IdRenumbering(size_t vertex_id_bound, size_t edge_id_bound)
+            : vertices_(vertex_id_bound, 0), edges_(edge_id_bound, 0) {}
+
+    void set(VertexId from, VertexId to) {
+        vertices_[from.int_id()] = to.int_id();
+    }
+
+    void set(EdgeId from, EdgeId to) {
+        edges_[from.int_id()] = to.int_id();
+    }
+
+    VertexId operator()(VertexId v) const {
+        return v.int_id() < vertices_.size() ? vertices_[v.int_id()] : 0;
+    }
+
+    EdgeId operator()(EdgeId e) const {
+        return e.int_id() < edges_.size() ? edges_[e.int_id()] : 0;
+    }
+};
+
+}
@@ -11,6 +11,7 @@
 #include "graph_core.hpp"
 #include "graph_iterators.hpp"
 
+#include <memory>
 #include <vector>
 #include <set>
 #include <cstring>
@@ -150,11 +151,40 @@ public:
 
     EdgeId MergePath(const std::vector<EdgeId> &path, bool safe_merging = true);
 
+    /*
+     * Batched versions of DeleteEdge and MergePath. Edges (paths) of a batch
+     * should not share vertices. Every handler is notified about the whole
+     * batch at once (handlers reporting IsThreadSafe() receive the events in
+     * parallel), graph structure is altered after all notifications.
+     */
+    void DeleteEdges(const std::vector<EdgeId> &edges);
+
+    std::vector<EdgeId> MergePaths(const std::vector<std::vector<EdgeId>> &paths, bool safe_merging = true);
+
     std::pair<EdgeId, EdgeId> SplitEdge(EdgeId edge, size_t position);
 
+    /*
+     * Renumbers the graph elements in the traversal order (see GraphCore::Compact)
+     * and translates the ids stored by handlers. Compaction is not performed (and
+     * false is returned) if some handler does not support renumbering.
+     */
+    bool Compact();
+
     EdgeId GlueEdges(EdgeId edge1, EdgeId edge2);
 
 private:
+    template<class F>
+    void DeliverBulk(Handler &handler, size_t n, const F &f) const {
+        if (handler.IsThreadSafe()) {
+#           pragma omp parallel for schedule(guided)
+            for (size_t i = 0; i < n; ++i)
+                f(handler, i);
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                f(handler, i);
+        }
+    }
+
     DECL_LOGGER("ObservableGraph")
 };
 
@@ -204,6 +234,20 @@ void ObservableGraph<DataMaster>::DeleteEdge(EdgeId e) {
     base::HiddenDeleteEdge(e);
 }
 
+template<class DataMaster>
+void ObservableGraph<DataMaster>::DeleteEdges(const std::vector<EdgeId> &edges) {
+    for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
+        if ((*it)->IsAttached()) {
+            DeliverBulk(**it, edges.size(), [&](Handler &handler, size_t i) {
+                applier_->ApplyDelete(handler, edges[i]);
+            });
+        }
+    }
+
+    for (EdgeId e : edges)
+        base::HiddenDeleteEdge(e);
+}
+
 template<class DataMaster>
 void ObservableGraph<DataMaster>::DeleteAllOutgoing(VertexId v) {
     while (base::OutgoingEdgeCount(v) > 0) {
@@ -471,6 +515,91 @@ typename ObservableGraph<DataMaster>::EdgeId
     return new_edge;
 }
 
+template<class DataMaster>
+std::vector<typename ObservableGraph<DataMaster>::EdgeId>
+        ObservableGraph<DataMaster>::MergePaths(const std::vector<std::vector<EdgeId>> &paths, bool safe_merging) {
+    size_t n = paths.size();
+    std::vector<std::vector<EdgeId>> corrected_paths(n);
+    std::vector<std::vector<EdgeId>> edges_to_delete(n);
+    std::vector<std::vector<VertexId>> vertices_to_delete(n);
+    std::vector<std::unique_ptr<EdgeData>> merged(n);
+
+    // Sequence merging is the expensive part and does not touch the graph
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < n; ++i) {
+        VERIFY(!paths[i].empty());
+        corrected_paths[i] = CorrectMergePath(paths[i]);
+        std::vector<const EdgeData *> to_merge;
+        for (EdgeId e : corrected_paths[i])
+            to_merge.push_back(&(base::data(e)));
+        merged[i].reset(new EdgeData(base::master().MergeData(to_merge, safe_merging)));
+        edges_to_delete[i] = EdgesToDelete(corrected_paths[i]);
+        vertices_to_delete[i] = VerticesToDelete(corrected_paths[i]);
+    }
+
+    std::vector<EdgeId> new_edges(n);
+    for (size_t i = 0; i < n; ++i) {
+        const auto &path = corrected_paths[i];
+        new_edges[i] = base::HiddenAddEdge(base::EdgeStart(path.front()), base::EdgeEnd(path.back()), *merged[i]);
+        merged[i].reset();
+    }
+
+    // Same event order as MergePath has, but for the whole batch
+    for (Handler* handler_ptr : action_handler_list_) {
+        if (handler_ptr->IsAttached()) {
+            DeliverBulk(*handler_ptr, n, [&](Handler &handler, size_t i) {
+                applier_->ApplyMerge(handler, corrected_paths[i], new_edges[i]);
+            });
+        }
+    }
+    for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
+        if ((*it)->IsAttached()) {
+            DeliverBulk(**it, n, [&](Handler &handler, size_t i) {
+                for (EdgeId e : edges_to_delete[i])
+                    applier_->ApplyDelete(handler, e);
+            });
+        }
+    }
+    for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
+        if ((*it)->IsAttached()) {
+            DeliverBulk(**it, n, [&](Handler &handler, size_t i) {
+                for (VertexId v : vertices_to_delete[i])
+                    applier_->ApplyDelete(handler, v);
+            });
+        }
+    }
+    for (Handler* handler_ptr : action_handler_list_) {
+        if (handler_ptr->IsAttached()) {
+            DeliverBulk(*handler_ptr, n, [&](Handler &handler, size_t i) {
+                applier_->ApplyAdd(handler, new_edges[i]);
+            });
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        base::HiddenDeletePath(edges_to_delete[i], vertices_to_delete[i]);
+
+    return new_edges;
+}
+
+template<class DataMaster>
+bool ObservableGraph<DataMaster>::Compact() {
+    for (Handler* handler_ptr : action_handler_list_) {
+        if (!handler_ptr->IsRenumberable()) {
+            INFO("Graph can not be compacted, handler " << handler_ptr->name() << " does not support renumbering");
+            return false;
+        }
+    }
+
+    auto renumbering = base::Compact();
+    for (Handler* handler_ptr : action_handler_list_) {
+        TRACE("Renumbering in handler " << handler_ptr->name());
+        handler_ptr->HandleRenumbering(renumbering);
+    }
+
+    return true;
+}
+
 template<class DataMaster>
 std::pair<typename ObservableGraph<DataMaster>::EdgeId, typename ObservableGraph<DataMaster>::EdgeId>
         ObservableGraph<DataMaster>::SplitEdge(EdgeId edge, size_t position) {
@@ -11,6 +11,8 @@
 #include "assembly_graph/graph_support/detail_coverage.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <vector>
+
 namespace debruijn_graph {
 
 template<class Graph, class PHM>
@@ -43,18 +45,29 @@ class GraphCoverageFiller {
 
     size_t FillCoverageFromEdges(EdgeRange &r) {
         size_t seqs = 0;
+        // K-mers are looked up in batches, see PerfectHashMap::ResolveKWH()
+        const size_t batch = PHM::KMerIndexT::LOOKUP_BATCH;
+        std::vector<typename PHM::KeyWithHash> kwhs;
+        kwhs.reserve(batch);
         for (auto &it = r.begin(); it != r.end() && seqs < 100000; ++it) {
             EdgeId e = *it;
             const Sequence &seq = g_.EdgeNucls(e);
                 
             seqs += 1;
             RtSeq kmer = seq.start<RtSeq>(this->k_) >> 'A';
-            for (size_t j = this->k_ - 1; j < seq.size(); ++j) {
-                kmer <<= seq[j];
-
-                auto kwh = phm_.ConstructKWH(kmer);
-                uint32_t cov = phm_.get_value(kwh, utils::InvertableStoring::trivial_inverter());
-                inc_coverage(e, j - this->k_ + 1, cov);
+            for (size_t j = this->k_ - 1; j < seq.size(); ) {
+                size_t offset = j - this->k_ + 1;
+                kwhs.clear();
+                for (; j < seq.size() && kwhs.size() < batch; ++j) {
+                    kmer <<= seq[j];
+                    kwhs.push_back(phm_.ConstructKWH(kmer));
+                }
+
+                phm_.ResolveKWH(kwhs.data(), kwhs.size());
+                for (size_t i = 0; i < kwhs.size(); ++i) {
+                    uint32_t cov = phm_.get_value(kwhs[i], utils::InvertableStoring::trivial_inverter());
+                    inc_coverage(e, offset + i, cov);
+                }
             }
         }
         
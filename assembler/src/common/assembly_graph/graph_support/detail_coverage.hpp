@@ -167,6 +167,10 @@ public:
         return true;
     }
 
+    bool IsRenumberable() const override {
+        return true;
+    }
+
 private:
     DECL_LOGGER("FlankingCoverage");
 };
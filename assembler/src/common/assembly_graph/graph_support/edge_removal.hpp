@@ -67,6 +67,85 @@ private:
     DECL_LOGGER("EdgeRemover");
 };
 
+/*
+ * Removes a batch of edges at once, producing the same graph as a sequence of
+ * EdgeRemover::DeleteEdge calls. Edges of the batch are expected to have
+ * non-intersecting neighbourhoods, so that compression of the ends of one
+ * edge never involves another edge of the batch.
+ */
+template<class Graph>
+class BatchEdgeRemover {
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+    typedef std::function<void(EdgeId)> HandlerF;
+
+    Graph& g_;
+    HandlerF removal_handler_;
+
+    void AddVertex(VertexId v, std::set<VertexId> &seen, std::vector<VertexId> &vertices) const {
+        if (seen.count(v) || seen.count(g_.conjugate(v)))
+            return;
+        seen.insert(v);
+        vertices.push_back(v);
+    }
+
+public:
+    BatchEdgeRemover(Graph& g, HandlerF removal_handler = nullptr)
+            : g_(g),
+              removal_handler_(removal_handler) {
+    }
+
+    void DeleteEdges(const std::vector<EdgeId> &edges) {
+        if (edges.empty())
+            return;
+
+        std::set<VertexId> seen;
+        std::vector<VertexId> vertices;
+        for (EdgeId e : edges) {
+            TRACE("Deletion of edge " << g_.str(e));
+            VertexId start = g_.EdgeStart(e);
+            VertexId end = g_.EdgeEnd(e);
+            if (!g_.RelatedVertices(start, end))
+                AddVertex(end, seen, vertices);
+            AddVertex(start, seen, vertices);
+            if (removal_handler_)
+                removal_handler_(e);
+        }
+        g_.DeleteEdges(edges);
+
+        // Compressions of distinct vertices commute unless they share an
+        // edge, such vertices are postponed and compressed one by one
+        std::vector<std::vector<EdgeId>> paths;
+        std::vector<VertexId> postponed;
+        std::set<EdgeId> used;
+        for (VertexId v : vertices) {
+            if (g_.IsDeadStart(v) && g_.IsDeadEnd(v)) {
+                g_.DeleteVertex(v);
+                continue;
+            }
+            if (!g_.CanCompressVertex(v))
+                continue;
+
+            EdgeId in = g_.GetUniqueIncomingEdge(v), out = g_.GetUniqueOutgoingEdge(v);
+            if (used.count(in) || used.count(out)) {
+                postponed.push_back(v);
+                continue;
+            }
+            for (EdgeId e : { in, out, g_.conjugate(in), g_.conjugate(out) })
+                used.insert(e);
+            paths.push_back({ in, out });
+        }
+        TRACE("Compressing " << paths.size() << " vertices in bulk");
+        g_.MergePaths(paths);
+
+        for (VertexId v : postponed)
+            g_.CompressVertex(v);
+    }
+
+private:
+    DECL_LOGGER("BatchEdgeRemover");
+};
+
 //todo rewrite with SmartSetIterator
 template<class Graph>
 class ComponentRemover {
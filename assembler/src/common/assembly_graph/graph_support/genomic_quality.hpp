@@ -111,6 +111,17 @@ public:
         }
     }
 
+    void HandleRenumbering(const omnigraph::IdRenumbering<VertexId, EdgeId> &renumbering) override {
+        std::map<EdgeId, size_t> quality;
+        for (const auto &e_q : quality_)
+            quality[renumbering(e_q.first)] = e_q.second;
+        std::swap(quality_, quality);
+    }
+
+    bool IsRenumberable() const override {
+        return true;
+    }
+
     double quality(EdgeId edge) const {
         auto it = quality_.find(edge);
         if (it == quality_.end())
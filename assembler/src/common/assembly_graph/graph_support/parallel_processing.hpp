@@ -14,6 +14,9 @@
 #include "utils/perf/timetracer.hpp"
 #include "utils/logger/logger.hpp"
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace omnigraph {
 
 template<class Graph, class ElementId>
@@ -332,6 +335,30 @@ protected:
         it_.push(el);
     }
 
+    SmartSetIterator<Graph, ElementId, Priority> &queue() {
+        return it_;
+    }
+
+    /**
+     * Processes the elements in the queue one by one in the order of priority
+     * @return number of trigger events
+     */
+    virtual size_t ProcessQueue() {
+        size_t triggered = 0;
+        for (; !it_.IsEnd(); ++it_) {
+            ElementId el = *it_;
+            if (!Proceed(el)) {
+                TRACE("Proceed condition turned false on element " << this->g().str(el));
+                it_.ReleaseCurrent();
+                break;
+            }
+            TRACE("Processing edge " << this->g().str(el));
+            if (Process(el))
+                triggered++;
+        }
+        return triggered;
+    }
+
     virtual bool Process(ElementId el) = 0;
     virtual bool Proceed(ElementId /*el*/) const { return true; }
     virtual void PrepareIteration(double /*iter_run_progress*/ = 1.) {}
@@ -372,19 +399,8 @@ public:
         //PrepareIteration(std::min(curr_iteration_, total_iteration_estimate_ - 1), total_iteration_estimate_);
         PrepareIteration(iter_run_progress);
 
-        size_t triggered = 0;
         TRACE("Start processing");
-        for (; !it_.IsEnd(); ++it_) {
-            ElementId el = *it_;
-            if (!Proceed(el)) {
-                TRACE("Proceed condition turned false on element " << this->g().str(el));
-                it_.ReleaseCurrent();
-                break;
-            }
-            TRACE("Processing edge " << this->g().str(el));
-            if (Process(el))
-                triggered++;
-        }
+        size_t triggered = ProcessQueue();
         TRACE("Finished processing. Triggered = " << triggered);
         if (!tracking_)
             it_.Detach();
@@ -402,10 +418,113 @@ class ParallelEdgeRemovingAlgorithm : public PersistentProcessingAlgorithm<Graph
         typename Graph::EdgeId,
         Priority> {
     typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
     typedef PersistentProcessingAlgorithm<Graph, EdgeId, Priority> base;
 
     const func::TypedPredicate<EdgeId> remove_condition_;
     EdgeRemover<Graph> edge_remover_;
+    BatchEdgeRemover<Graph> batch_remover_;
+    bool concurrent_;
+
+    VertexId Canonical(VertexId v) const {
+        return std::min(v, this->g().conjugate(v));
+    }
+
+    void AddAdjacent(VertexId v, std::vector<VertexId> &vertices) const {
+        const Graph &g = this->g();
+        vertices.push_back(Canonical(v));
+        for (EdgeId in : g.IncomingEdges(v))
+            vertices.push_back(Canonical(g.EdgeStart(in)));
+        for (EdgeId out : g.OutgoingEdges(v))
+            vertices.push_back(Canonical(g.EdgeEnd(out)));
+    }
+
+    // Vertices which could be altered by the removal of the edge and the
+    // subsequent compression of its ends, together with the vertices adjacent
+    // to the ends of the edges the compression could create
+    void Neighbourhood(EdgeId e, std::vector<VertexId> &vertices) const {
+        const Graph &g = this->g();
+        vertices.clear();
+        for (VertexId v : { g.EdgeStart(e), g.EdgeEnd(e) }) {
+            vertices.push_back(Canonical(v));
+            for (EdgeId in : g.IncomingEdges(v))
+                AddAdjacent(g.EdgeStart(in), vertices);
+            for (EdgeId out : g.OutgoingEdges(v))
+                AddAdjacent(g.EdgeEnd(out), vertices);
+        }
+    }
+
+    /*
+     * Takes a batch of candidates with non-intersecting neighbourhoods in the
+     * order of priority. A candidate which cannot be taken reserves its
+     * neighbourhood as well, so the removal of a candidate and the compression
+     * of its ends do not change the edges adjacent to the later candidates of
+     * the batch, neither do the removals of the edges created by the
+     * compression. The edges created by the compression are processed after
+     * the batch though, so the result might differ from the sequential one
+     * if their removals cascade further. The batches do not depend on the
+     * number of threads, so the result is deterministic anyway.
+     */
+    bool CollectBatch(std::vector<EdgeId> &batch) {
+        auto &queue = this->queue();
+        std::unordered_set<VertexId> reserved;
+        std::vector<EdgeId> postponed;
+        std::vector<VertexId> neighbourhood;
+        bool proceed = true;
+        for (; !queue.IsEnd(); ++queue) {
+            EdgeId e = *queue;
+            if (!this->Proceed(e)) {
+                queue.ReleaseCurrent();
+                proceed = false;
+                break;
+            }
+
+            Neighbourhood(e, neighbourhood);
+            std::sort(neighbourhood.begin(), neighbourhood.end());
+            neighbourhood.erase(std::unique(neighbourhood.begin(), neighbourhood.end()),
+                                neighbourhood.end());
+            bool independent = true;
+            for (VertexId v : neighbourhood) {
+                if (!reserved.insert(v).second)
+                    independent = false;
+            }
+            (independent ? batch : postponed).push_back(e);
+        }
+
+        for (EdgeId e : postponed)
+            queue.push(e);
+
+        return proceed;
+    }
+
+    size_t ProcessQueue() override {
+        if (!concurrent_)
+            return base::ProcessQueue();
+
+        size_t triggered = 0;
+        bool proceed = true;
+        std::vector<EdgeId> batch;
+        while (proceed && !this->queue().IsEnd()) {
+            batch.clear();
+            proceed = CollectBatch(batch);
+            TRACE("Batch of " << batch.size() << " edges");
+
+            std::vector<char> to_remove(batch.size());
+            #pragma omp parallel for schedule(guided)
+            for (size_t i = 0; i < batch.size(); ++i)
+                to_remove[i] = remove_condition_(batch[i]);
+
+            std::vector<EdgeId> removed;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (to_remove[i])
+                    removed.push_back(batch[i]);
+            }
+
+            batch_remover_.DeleteEdges(removed);
+            triggered += removed.size();
+        }
+        return triggered;
+    }
 
 protected:
 
@@ -432,7 +551,22 @@ public:
                    std::make_shared<ParallelInterestingElementFinder<Graph>>(remove_condition, chunk_cnt),
                    canonical_only, priority, track_changes),
                    remove_condition_(remove_condition),
-                   edge_remover_(g, removal_handler) {
+                   edge_remover_(g, removal_handler),
+                   batch_remover_(g, removal_handler),
+                   concurrent_(false) {
+    }
+
+    /**
+     * In concurrent mode the queue is processed in batches of independent
+     * edges: removal conditions are checked in parallel and the batch is
+     * removed with bulk graph updates. For removal conditions which only look
+     * at the edge and the adjacent ones (tips, isolated edges, etc) the result
+     * matches the sequential mode unless the removals cascade through several
+     * compressions, see CollectBatch. It does not depend on the number of
+     * threads.
+     */
+    void set_concurrent(bool concurrent) {
+        concurrent_ = concurrent;
     }
 
 private:
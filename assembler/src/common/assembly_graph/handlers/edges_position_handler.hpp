@@ -214,6 +214,17 @@ public:
         edges_positions_.erase(e);
     }
 
+    void HandleRenumbering(const IdRenumbering<VertexId, EdgeId> &renumbering) override {
+        std::map<EdgeId, std::map<std::string, RangeSet>> edges_positions;
+        for (auto &entry : edges_positions_)
+            edges_positions[renumbering(entry.first)] = std::move(entry.second);
+        std::swap(edges_positions_, edges_positions);
+    }
+
+    bool IsRenumberable() const override {
+        return true;
+    }
+
     void clear() {
         edges_positions_.clear();
     }
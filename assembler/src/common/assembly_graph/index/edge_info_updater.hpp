@@ -14,6 +14,8 @@
 
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <vector>
+
 namespace debruijn_graph {
 
 template<typename Graph>
@@ -32,17 +34,37 @@ class EdgeInfoUpdater {
         return false;
     }
 
+    // K-mers are looked up in batches, see PerfectHashMap::ResolveKWH()
     template<class Index>
     void UpdateKMers(const Sequence &nucls, EdgeId e, Index &index) {
         VERIFY(nucls.size() >= index.k());
+        const size_t batch = Index::KMerIndexT::LOOKUP_BATCH;
+        std::vector<typename Index::KeyWithHash> kwhs;
+        std::vector<size_t> offsets;
+        kwhs.reserve(batch);
+        offsets.reserve(batch);
+
+        auto flush = [&]() {
+            index.ResolveKWH(kwhs.data(), kwhs.size());
+            for (size_t i = 0; i < kwhs.size(); ++i)
+                index.PutInIndex(kwhs[i], e, offsets[i]);
+            kwhs.clear();
+            offsets.clear();
+        };
+
         typename Index::KeyWithHash kwh = index.ConstructKWH(typename Index::KMer(index.k(), nucls));
-        if (kwh.is_minimal())
-            index.PutInIndex(kwh, e, 0);
-        for (size_t i = index.k(), n = nucls.size(); i < n; ++i) {
+        for (size_t i = index.k(), n = nucls.size(); ; ++i) {
+            if (kwh.is_minimal()) {
+                kwhs.push_back(kwh);
+                offsets.push_back(i - index.k());
+                if (kwhs.size() == batch)
+                    flush();
+            }
+            if (i == n)
+                break;
             kwh <<= nucls[i];
-            if (kwh.is_minimal())
-                index.PutInIndex(kwh, e, i - index.k() + 1);
         }
+        flush();
     }
 
     template<class Index>
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "adt/mappable_vector.hpp"
 #include "sequence/rtseq.hpp"
 #include "utils/ph_map/perfect_hash_map.hpp"
 #include "utils/ph_map/kmer_maps.hpp"
@@ -62,6 +63,12 @@ class EdgeInfo {
     }
     bool removed() const { return offset() == TOMBSTONE; }
 
+    template<class Renumbering>
+    void renumber(const Renumbering &renumbering) {
+        if (valid())
+            edge_id_ = IdHolder(renumbering(edge()).int_id());
+    }
+
     bool valid() const {
         return !clean() && !removed();
     }
@@ -100,12 +107,15 @@ struct GraphInverter {
 };
 
 
+// Values might be mapped from a file, see PerfectHashMap::Map()
 template<class Graph, class IdHolder = typename Graph::EdgeId, class StoringType = utils::DefaultStoring>
 class KmerFreeEdgeIndex : public utils::PerfectHashMap<RtSeq,
                                                        EdgeInfo<typename Graph::EdgeId, IdHolder>,
-                                                       kmers::kmer_index_traits<RtSeq>, StoringType> {
+                                                       kmers::kmer_index_traits<RtSeq>, StoringType,
+                                                       adt::mappable_vector<EdgeInfo<typename Graph::EdgeId, IdHolder>>> {
   typedef utils::PerfectHashMap<RtSeq, EdgeInfo<typename Graph::EdgeId, IdHolder>,
-                                kmers::kmer_index_traits<RtSeq>, StoringType> base;
+                                kmers::kmer_index_traits<RtSeq>, StoringType,
+                                adt::mappable_vector<EdgeInfo<typename Graph::EdgeId, IdHolder>>> base;
   const Graph &graph_;
 
 public:
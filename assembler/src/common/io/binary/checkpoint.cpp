@@ -0,0 +1,434 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "checkpoint.hpp"
+
+#include "utils/filesystem/file_opener.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+#include "utils/verify.hpp"
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace io {
+
+namespace binary {
+
+namespace {
+
+// "SPCHUNKS" in little endian
+constexpr uint64_t CHUNKED_MAGIC = 0x534b4e5548435053ull;
+
+struct ChunkHeader {
+    // Zero size marks the end of the file
+    uint32_t size;
+    // Equals to size for the chunks stored uncompressed
+    uint32_t stored_size;
+    uint64_t checksum;
+};
+
+typedef std::vector<std::vector<char>> Chunks;
+
+// Compresses the batches of threads chunks in parallel and writes them, the
+// chunks are freed once written
+void WriteChunks(std::ostream &os, Chunks &chunks, const ChunkedFormat &format, unsigned threads) {
+    for (size_t start = 0; start < chunks.size(); start += threads) {
+        size_t end = std::min(chunks.size(), start + threads);
+        std::vector<ChunkHeader> headers(end - start);
+        Chunks compressed(end - start);
+#       pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+        for (size_t i = start; i < end; ++i) {
+            const auto &chunk = chunks[i];
+            auto &header = headers[i - start];
+            header.size = header.stored_size = uint32_t(chunk.size());
+            header.checksum = XXH3_64bits(chunk.data(), chunk.size());
+            if (format.level <= 0)
+                continue;
+
+            auto &out = compressed[i - start];
+            uLongf size = compressBound(chunk.size());
+            out.resize(size);
+            if (compress2((Bytef*)out.data(), &size, (const Bytef*)chunk.data(), chunk.size(), format.level) == Z_OK &&
+                size < chunk.size()) {
+                out.resize(size);
+                header.stored_size = uint32_t(size);
+            } else {
+                std::vector<char>().swap(out);
+            }
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            const auto &header = headers[i - start];
+            const auto &data = header.stored_size < header.size ? compressed[i - start] : chunks[i];
+            os.write((const char*)&header, sizeof(header));
+            os.write(data.data(), header.stored_size);
+            std::vector<char>().swap(chunks[i]);
+        }
+    }
+}
+
+void WriteMagic(std::ostream &os) {
+    os.write((const char*)&CHUNKED_MAGIC, sizeof(CHUNKED_MAGIC));
+}
+
+void WriteEnd(std::ostream &os) {
+    ChunkHeader last = { 0, 0, 0 };
+    os.write((const char*)&last, sizeof(last));
+}
+
+void WriteChunked(std::ostream &os, Chunks &chunks, const ChunkedFormat &format, unsigned threads) {
+    WriteMagic(os);
+    WriteChunks(os, chunks, format, threads);
+    WriteEnd(os);
+}
+
+ChunkedFormat output_format;
+
+}
+
+/**
+ * @brief  Collects the written data into the chunks of the fixed size.
+ */
+class ChunkBuffer : public std::streambuf {
+public:
+    explicit ChunkBuffer(size_t chunk_size)
+            : chunk_size_(chunk_size) {}
+
+    Chunks &chunks() {
+        Finish();
+        return chunks_;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        Finish();
+        chunks_.emplace_back(chunk_size_);
+        setp(chunks_.back().data(), chunks_.back().data() + chunk_size_);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    void Finish() {
+        if (!pbase())
+            return;
+
+        auto &chunk = chunks_.back();
+        chunk.resize(pptr() - pbase());
+        chunk.shrink_to_fit();
+        if (chunk.empty())
+            chunks_.pop_back();
+        setp(nullptr, nullptr);
+    }
+
+    size_t chunk_size_;
+    Chunks chunks_;
+};
+
+/**
+ * @brief  Writes the chunked file on the fly, only a batch of chunks (one per thread) is kept in memory.
+ */
+class ChunkedOutBuf : public std::streambuf {
+public:
+    ChunkedOutBuf(std::ostream &os, const ChunkedFormat &format)
+            : os_(os), format_(format),
+              // Files of a graph pack are saved in parallel, so nested ones are compressed sequentially
+              threads_(omp_in_parallel() ? 1 : unsigned(omp_get_max_threads())) {
+        WriteMagic(os_);
+    }
+
+    void Finish() {
+        Trim();
+        WriteChunks(os_, chunks_, format_, threads_);
+        chunks_.clear();
+        WriteEnd(os_);
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        Trim();
+        if (chunks_.size() >= threads_) {
+            WriteChunks(os_, chunks_, format_, threads_);
+            chunks_.clear();
+        }
+        chunks_.emplace_back(format_.chunk_size);
+        setp(chunks_.back().data(), chunks_.back().data() + format_.chunk_size);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    void Trim() {
+        if (!pbase())
+            return;
+
+        auto &chunk = chunks_.back();
+        chunk.resize(pptr() - pbase());
+        if (chunk.empty())
+            chunks_.pop_back();
+        setp(nullptr, nullptr);
+    }
+
+    std::ostream &os_;
+    ChunkedFormat format_;
+    unsigned threads_;
+    Chunks chunks_;
+};
+
+/**
+ * @brief  Reads the chunked file, the batches of chunks are decompressed in parallel.
+ */
+class ChunkedInBuf : public std::streambuf {
+public:
+    ChunkedInBuf(std::istream &is, const std::string &filename)
+            : is_(is), filename_(filename), current_(0), finished_(false) {}
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        if (current_ + 1 < chunks_.size()) {
+            ++current_;
+        } else if (!ReadBatch()) {
+            return traits_type::eof();
+        }
+
+        auto &chunk = chunks_[current_];
+        setg(chunk.data(), chunk.data(), chunk.data() + chunk.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    void Read(void *data, size_t size) {
+        if (!is_.read((char*)data, size))
+            throw std::ios_base::failure("Truncated file '" + filename_ + '\'');
+    }
+
+    bool ReadBatch() {
+        chunks_.clear();
+        current_ = 0;
+
+        std::vector<ChunkHeader> headers;
+        Chunks stored;
+        size_t threads = omp_get_max_threads();
+        while (!finished_ && headers.size() < threads) {
+            ChunkHeader header;
+            Read(&header, sizeof(header));
+            if (!header.size) {
+                finished_ = true;
+                break;
+            }
+            if (header.stored_size > header.size)
+                throw std::ios_base::failure("Damaged chunk header in '" + filename_ + '\'');
+
+            stored.emplace_back(header.stored_size);
+            Read(stored.back().data(), header.stored_size);
+            headers.push_back(header);
+        }
+
+        chunks_.resize(headers.size());
+        std::vector<char> valid(headers.size());
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < headers.size(); ++i) {
+            const auto &header = headers[i];
+            auto &chunk = chunks_[i];
+            if (header.stored_size == header.size) {
+                chunk.swap(stored[i]);
+            } else {
+                chunk.resize(header.size);
+                uLongf size = header.size;
+                if (uncompress((Bytef*)chunk.data(), &size, (const Bytef*)stored[i].data(), header.stored_size) != Z_OK ||
+                    size != header.size)
+                    continue;
+            }
+            valid[i] = XXH3_64bits(chunk.data(), chunk.size()) == header.checksum;
+        }
+
+        if (std::find(valid.begin(), valid.end(), false) != valid.end())
+            throw std::ios_base::failure("Checksum mismatch in '" + filename_ + '\'');
+
+        return !chunks_.empty();
+    }
+
+    std::istream &is_;
+    std::string filename_;
+    Chunks chunks_;
+    size_t current_;
+    bool finished_;
+};
+
+OutputFile::OutputFile(const std::string &filename, bool chunked)
+        : filename_(filename) {
+    if (CheckpointWriter *writer = CheckpointWriter::active()) {
+        stream_ = &writer->Create(filename, chunked);
+        return;
+    }
+
+    file_.open(filename + ".tmp", std::ios::binary);
+    stream_ = &file_;
+    if (chunked && file_) {
+        buf_.reset(new ChunkedOutBuf(file_, output_format));
+        chunked_.reset(new std::ostream(buf_.get()));
+        stream_ = chunked_.get();
+    }
+}
+
+OutputFile::~OutputFile() {
+    if (!file_.is_open())
+        return;
+
+    // Not closed explicitly (e.g. the saving failed), the previous file is kept
+    file_.close();
+    std::remove((filename_ + ".tmp").c_str());
+}
+
+void OutputFile::Close() {
+    if (!file_.is_open())
+        return;
+
+    std::string tmp_filename = filename_ + ".tmp";
+    if (buf_) {
+        CHECK_FATAL_ERROR(*chunked_, "Failed to write " << tmp_filename);
+        buf_->Finish();
+    }
+    file_.close();
+    CHECK_FATAL_ERROR(file_, "Failed to write " << tmp_filename);
+    // The previous file might be still mapped, so it is replaced instead of being overwritten
+    CHECK_FATAL_ERROR(std::rename(tmp_filename.c_str(), filename_.c_str()) == 0,
+                      "Failed to rename " << tmp_filename << " to " << filename_);
+}
+
+void OutputFile::set_format(const ChunkedFormat &format) {
+    output_format = format;
+}
+
+InputFile::InputFile(const std::string &filename)
+        : file_(fs::open_file(filename, std::ios::binary)) {
+    uint64_t magic = 0;
+    if (file_.rdbuf()->sgetn((char*)&magic, sizeof(magic)) != sizeof(magic) || magic != CHUNKED_MAGIC) {
+        file_.rdbuf()->pubseekpos(0);
+        return;
+    }
+
+    buf_.reset(new ChunkedInBuf(file_, filename));
+    chunked_.reset(new std::istream(buf_.get()));
+    chunked_->exceptions(std::ios_base::failbit | std::ios_base::badbit);
+}
+
+InputFile::~InputFile() = default;
+
+struct CheckpointWriter::File {
+    File(const std::string &filename, bool chunked, size_t chunk_size)
+            : filename(filename), chunked(chunked), buf(chunk_size), stream(&buf) {}
+
+    std::string filename;
+    bool chunked;
+    ChunkBuffer buf;
+    std::ostream stream;
+};
+
+CheckpointWriter *CheckpointWriter::active_ = nullptr;
+
+CheckpointWriter::Scope::Scope(CheckpointWriter &writer) {
+    VERIFY(!active_);
+    // Files of the previous checkpoint are not yet written
+    writer.Wait();
+    active_ = &writer;
+}
+
+CheckpointWriter::Scope::~Scope() {
+    active_ = nullptr;
+}
+
+CheckpointWriter::CheckpointWriter(const ChunkedFormat &format, bool background)
+        : format_(format), background_(background), threads_(1) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    Wait();
+}
+
+std::ostream &CheckpointWriter::Create(const std::string &filename, bool chunked) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.emplace_back(new File(filename, chunked, format_.chunk_size));
+    return files_.back()->stream;
+}
+
+void CheckpointWriter::Commit(std::function<void()> on_done) {
+    Wait();
+    // Background writer compresses on a single thread, so it does not compete
+    // with the threads of the next stage
+    threads_ = background_ ? 1 : omp_get_max_threads();
+    if (!background_) {
+        WriteAll();
+        if (on_done)
+            on_done();
+        return;
+    }
+
+    thread_ = std::thread([this, on_done] {
+        WriteAll();
+        if (on_done)
+            on_done();
+    });
+}
+
+void CheckpointWriter::Wait() {
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void CheckpointWriter::WriteAll() {
+    if (files_.empty())
+        return;
+
+    utils::perf_counter pc;
+    size_t raw = 0, written = 0;
+    for (auto &file : files_) {
+        std::string tmp_filename = file->filename + ".tmp";
+        {
+            std::ofstream os(tmp_filename, std::ios::binary);
+            auto &chunks = file->buf.chunks();
+            for (const auto &chunk : chunks)
+                raw += chunk.size();
+
+            if (file->chunked) {
+                WriteChunked(os, chunks, format_, threads_);
+            } else {
+                for (auto &chunk : chunks) {
+                    os.write(chunk.data(), chunk.size());
+                    std::vector<char>().swap(chunk);
+                }
+            }
+            CHECK_FATAL_ERROR(os, "Failed to write " << tmp_filename);
+            written += size_t(os.tellp());
+        }
+        CHECK_FATAL_ERROR(std::rename(tmp_filename.c_str(), file->filename.c_str()) == 0,
+                          "Failed to rename " << tmp_filename << " to " << file->filename);
+        file.reset();
+    }
+
+    INFO("Checkpoint of " << files_.size() << " files written in " << pc.time() << " s, "
+         << (raw >> 20) << " MB stored in " << (written >> 20) << " MB");
+    files_.clear();
+}
+
+} // namespace binary
+
+} // namespace io
@@ -0,0 +1,136 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace io {
+
+namespace binary {
+
+/**
+ * @brief  Layout of the chunked files: a magic followed by the chunks of at most chunk_size bytes, every one
+ *         compressed independently (or stored as is) and protected by the checksum of its content.
+ *         Chunks are (de)compressed in parallel.
+ */
+struct ChunkedFormat {
+    // zlib compression level, 0 stores the chunks uncompressed
+    int level = 1;
+    size_t chunk_size = 4 << 20;
+};
+
+class ChunkBuffer;
+class ChunkedInBuf;
+class ChunkedOutBuf;
+class CheckpointWriter;
+
+/**
+ * @brief  Output stream of a saved component file. It is written via a temporary file (chunked ones are
+ *         compressed on the fly) unless a CheckpointWriter is active, which then collects the content in memory.
+ */
+class OutputFile {
+public:
+    explicit OutputFile(const std::string &filename, bool chunked = true);
+    /**
+     * @brief  Removes the temporary file if the file was not closed, so the previous one is kept.
+     */
+    ~OutputFile();
+
+    std::ostream &stream() { return *stream_; }
+
+    /**
+     * @brief  Finishes the file, so it replaces the previous one.
+     */
+    void Close();
+
+    /**
+     * @brief  Sets the layout of the chunked files written without a CheckpointWriter.
+     */
+    static void set_format(const ChunkedFormat &format);
+
+private:
+    std::string filename_;
+    std::ofstream file_;
+    std::unique_ptr<ChunkedOutBuf> buf_;
+    std::unique_ptr<std::ostream> chunked_;
+    std::ostream *stream_;
+};
+
+/**
+ * @brief  Input stream of a saved component file either in the chunked layout or a plain one.
+ *         Throws std::ios_base::failure if the file is missing, truncated or damaged.
+ */
+class InputFile {
+public:
+    explicit InputFile(const std::string &filename);
+    ~InputFile();
+
+    std::istream &stream() { return chunked_ ? *chunked_ : file_; }
+
+private:
+    std::ifstream file_;
+    std::unique_ptr<ChunkedInBuf> buf_;
+    std::unique_ptr<std::istream> chunked_;
+};
+
+/**
+ * @brief  Collects the files of a checkpoint in memory, so the graph pack could be modified by the next stage
+ *         while they are compressed and written in the background. Used only if the background writing is
+ *         enabled, otherwise the files are written directly by OutputFile.
+ */
+class CheckpointWriter {
+public:
+    /**
+     * @brief  Redirects the files created by OutputFile to the writer while alive.
+     */
+    class Scope {
+    public:
+        explicit Scope(CheckpointWriter &writer);
+        ~Scope();
+    };
+
+    CheckpointWriter(const ChunkedFormat &format, bool background);
+    ~CheckpointWriter();
+
+    std::ostream &Create(const std::string &filename, bool chunked);
+
+    /**
+     * @brief  Writes the collected files (in the background if enabled) and then calls on_done.
+     */
+    void Commit(std::function<void()> on_done = nullptr);
+
+    /**
+     * @brief  Waits for the files being written.
+     */
+    void Wait();
+
+    static CheckpointWriter *active() { return active_; }
+
+private:
+    struct File;
+
+    void WriteAll();
+
+    ChunkedFormat format_;
+    bool background_;
+    unsigned threads_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<File>> files_;
+    std::thread thread_;
+
+    static CheckpointWriter *active_;
+};
+
+} // namespace binary
+
+} // namespace io
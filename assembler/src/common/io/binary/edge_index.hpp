@@ -7,20 +7,60 @@
 #pragma once
 
 #include "io_base.hpp"
+#include "mapped.hpp"
 #include "modules/alignment/edge_index.hpp"
 
 namespace io {
 
 namespace binary {
 
+/**
+ * @brief  Saves the edge index into a file in the layout it could be used from in place (see EdgeIndex::Map),
+ *         so loading a checkpoint does not read the whole index. Stream (de)serialization is unchanged.
+ */
 template<typename Graph>
 class EdgeIndexIO : public IOSingle<debruijn_graph::EdgeIndex<Graph>> {
+    // "SPIDXMAP" in little endian
+    static constexpr uint64_t MAPPED_MAGIC = 0x50414d5844495053ull;
+
 public:
     typedef debruijn_graph::EdgeIndex<Graph> Type;
     EdgeIndexIO()
             : IOSingle<Type>("edge index", ".kmidx") {
     }
 
+    void Save(const std::string &basename, const Type &value) override {
+        std::string filename = basename + this->ext_;
+        // Not chunked, since the file is mapped in place
+        OutputFile file(filename, /*chunked*/ false);
+        VERIFY(file.stream());
+        AlignedWriter writer(file.stream());
+        uint64_t magic = MAPPED_MAGIC;
+        uint32_t k = (uint32_t)value.k();
+        writer.write((const char*)&magic, sizeof(magic)).write((const char*)&k, sizeof(k));
+        value.SaveAligned(writer);
+        CHECK_FATAL_ERROR(writer, "Failed to write " << filename);
+        file.Close();
+    }
+
+    /**
+     * @brief  Maps the index saved by Save(). The files written by SaveImpl() are deserialized as before.
+     */
+    bool Load(const std::string &basename, Type &value) override {
+        std::string filename = basename + this->ext_;
+        if (!IsMapped(filename))
+            return IOSingle<Type>::Load(basename, value);
+
+        MappedReader reader(std::make_shared<MappedFile>(filename));
+        uint64_t magic;
+        uint32_t k_;
+        reader.read((char*)&magic, sizeof(magic)).read((char*)&k_, sizeof(k_));
+        CHECK_FATAL_ERROR(k_ == value.k(), "Cannot read edge index, different Ks");
+        value.clear();
+        value.Map(reader);
+        return true;
+    }
+
     void SaveImpl(BinOStream &str, const Type &value) override {
         str << (uint32_t)value.k() << value;
     }
@@ -32,6 +72,14 @@ public:
         value.clear();
         str >> value;
     }
+
+private:
+    static bool IsMapped(const std::string &filename) {
+        std::ifstream file(filename, std::ios::binary);
+        uint64_t magic = 0;
+        file.read((char*)&magic, sizeof(magic));
+        return file && magic == MAPPED_MAGIC;
+    }
 };
 
 template<typename Graph>
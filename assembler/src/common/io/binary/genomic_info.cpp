@@ -5,8 +5,7 @@
 //***************************************************************************
 
 #include "genomic_info.hpp"
-
-#include "utils/filesystem/file_opener.hpp"
+#include "checkpoint.hpp"
 
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/Errc.h"
@@ -49,14 +48,15 @@ void GenomicInfo::yamlize(yaml::IO &io) {
 }
 
 bool GenomicInfo::Load(const std::string &filename) {
-    auto ifs = fs::open_file(filename, std::ios::binary);
-    BinRead(ifs);
+    io::binary::InputFile file(filename);
+    BinRead(file.stream());
     return true;
 }
 
 void GenomicInfo::Save(const std::string &filename) const {
-    std::ofstream ofs(filename, std::ios::binary);
-    BinWrite(ofs);
+    io::binary::OutputFile file(filename);
+    BinWrite(file.stream());
+    file.Close();
 }
 
 bool GenomicInfo::BinWrite(std::ostream &os) const {
@@ -17,21 +17,57 @@
 #include "positions.hpp"
 #include "trusted_paths.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <exception>
+#include <functional>
+
 namespace io {
 
 namespace binary {
 
 namespace {
 
+/**
+ * @brief  Components are stored in separate files, so they are (de)serialized in parallel.
+ *         The first exception thrown is rethrown after all of them are processed.
+ */
+class ParallelTasks {
+    std::vector<std::function<void()>> tasks;
+public:
+    void Add(std::function<void()> task) {
+        tasks.push_back(std::move(task));
+    }
+
+    void Run() {
+        std::vector<std::exception_ptr> errors(tasks.size());
+#       pragma omp parallel for schedule(dynamic, 1) if (tasks.size() > 1)
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            try {
+                tasks[i]();
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+        tasks.clear();
+
+        for (const auto &error : errors) {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+};
+
 class Saver {
     const std::string &basename;
     const BasePackIO::Type &gp;
-    std::ofstream infoStream;
+    OutputFile infoFile;
+    ParallelTasks tasks;
 public:
     Saver(const std::string &basename, const BasePackIO::Type &gp)
         : basename(basename)
         , gp(gp)
-        , infoStream(basename + ".att")
+        , infoFile(basename + ".att", /*chunked*/ false)
     {}
 
     /**
@@ -41,12 +77,26 @@ public:
     template<class T>
     void Save() {
         const auto &component = gp.get<T>();
-        io::binary::BinWrite<char>(infoStream, component.IsAttached());
+        io::binary::BinWrite<char>(infoFile.stream(), component.IsAttached());
         if (component.IsAttached()) {
-            typename IOTraits<T>::Type io;
-            io.Save(basename, component); 
+            tasks.Add([this, &component] {
+                typename IOTraits<T>::Type io;
+                io.Save(basename, component);
+            });
         }
     }
+
+    void Add(std::function<void()> task) {
+        tasks.Add(std::move(task));
+    }
+
+    /**
+     * @brief  Saves the components added.
+     */
+    void Run() {
+        infoFile.Close();
+        tasks.Run();
+    }
 };
 
 class BinWriter {
@@ -76,12 +126,14 @@ public:
 class Loader {
     const std::string &basename;
     BasePackIO::Type &gp;
-    std::ifstream infoStream;
+    InputFile infoFile;
+    ParallelTasks tasks;
+    std::vector<std::function<void()>> attach;
 public:
     Loader(const std::string &basename, BasePackIO::Type &gp)
         : basename(basename)
         , gp(gp)
-        , infoStream(fs::open_file(basename + ".att", std::ios::binary))
+        , infoFile(basename + ".att")
     {}
 
     /**
@@ -90,17 +142,29 @@ public:
     template<class T>
     void Load() {
         INFO("Trying to load " << typeid(T).name());
-        if (!io::binary::BinRead<char>(infoStream)) {
+        if (!io::binary::BinRead<char>(infoFile.stream())) {
             INFO("Not attached, skipping");
             return;
         }
         auto &component = gp.get_mutable<T>();
         if (component.IsAttached())
             component.Detach();
-        typename IOTraits<T>::Type io;
-        bool loaded = io.Load(basename, component);
-        VERIFY(loaded);
-        component.Attach();
+        tasks.Add([this, &component] {
+            typename IOTraits<T>::Type io;
+            bool loaded = io.Load(basename, component);
+            VERIFY(loaded);
+        });
+        attach.emplace_back([&component] { component.Attach(); });
+    }
+
+    /**
+     * @brief  Loads the components added. They are attached to the graph afterwards,
+     *         since the graph handlers are not thread-safe.
+     */
+    void Run() {
+        tasks.Run();
+        for (const auto &f : attach)
+            f();
     }
 };
 
@@ -134,21 +198,23 @@ public:
 };
 
 /**
- * @brief  Saves the component.
+ * @brief  Adds the saving of the component.
  */
 template<typename T>
-void SaveComponent(const std::string &basename, const BasePackIO::Type &gp, const std::string &name = "") {
+void SaveComponent(ParallelTasks &tasks, const std::string &basename, const BasePackIO::Type &gp,
+                   const std::string &name = "") {
     const auto &component = gp.get<T>(name);
-    io::binary::Save(basename, component);
+    tasks.Add([basename, &component] { io::binary::Save(basename, component); });
 }
 
 /**
- * @brief  Loads an arbitrary component.
+ * @brief  Adds the loading of an arbitrary component.
  */
 template<typename T>
-void LoadComponent(const std::string &basename, BasePackIO::Type &gp, const std::string &name = "") {
+void LoadComponent(ParallelTasks &tasks, const std::string &basename, BasePackIO::Type &gp,
+                   const std::string &name = "") {
     auto &component = gp.get_mutable<T>(name);
-    io::binary::Load(basename, component);
+    tasks.Add([basename, &component] { io::binary::Load(basename, component); });
 }
 
 /**
@@ -180,7 +246,7 @@ void BasePackIO::Save(const std::string &basename, const Type &gp) {
     if (gp.invalidated<Graph>()) {
         //1. Save basic graph with coverage
         const auto &g = gp.get<Graph>();
-        graph_io_.Save(basename, g);
+        saver.Add([&] { graph_io_.Save(basename, g); });
     }
 
     //2. Save edge positions
@@ -194,6 +260,8 @@ void BasePackIO::Save(const std::string &basename, const Type &gp) {
 
     //5. Save flanking coverage
     saver.Save<FlankingCoverage<Graph>>();
+
+    saver.Run();
 }
 
 bool BasePackIO::Load(const std::string &basename, Type &gp) {
@@ -202,7 +270,7 @@ bool BasePackIO::Load(const std::string &basename, Type &gp) {
     using namespace omnigraph;
     using namespace debruijn_graph;
 
-    //1. Load basic graph with coverage
+    //1. Load basic graph with coverage, the rest refers to its edges
     auto &g = gp.get_mutable<Graph>();
     graph_io_.Load(basename, g);
 
@@ -218,6 +286,8 @@ bool BasePackIO::Load(const std::string &basename, Type &gp) {
     //5. Load flanking coverage
     loader.Load<FlankingCoverage<Graph>>();
 
+    loader.Run();
+
     return true;
 }
 
@@ -274,26 +344,29 @@ void FullPackIO::Save(const std::string &basename, const Type &gp) {
     //1. Save basic graph pack
     base::Save(basename, gp);
 
+    ParallelTasks tasks;
     //2. Save unclustered paired indices
-    SaveComponent<UnclusteredPairedInfoIndicesT<Graph>>(basename, gp);
+    SaveComponent<UnclusteredPairedInfoIndicesT<Graph>>(tasks, basename, gp);
 
     //3. Save clustered indices
-    SaveComponent<PairedInfoIndicesT<Graph>>(basename + "_cl", gp, "clustered_indices");
+    SaveComponent<PairedInfoIndicesT<Graph>>(tasks, basename + "_cl", gp, "clustered_indices");
 
     //4. Save scaffolding indices
-    SaveComponent<PairedInfoIndicesT<Graph>>(basename + "_scf", gp, "scaffolding_indices");
+    SaveComponent<PairedInfoIndicesT<Graph>>(tasks, basename + "_scf", gp, "scaffolding_indices");
 
     //5. Save long reads
-    SaveComponent<LongReadContainer<Graph>>(basename, gp);
+    SaveComponent<LongReadContainer<Graph>>(tasks, basename, gp);
 
     //6. Save genomic info
-    SaveComponent<GenomicInfo>(basename, gp);
+    SaveComponent<GenomicInfo>(tasks, basename, gp);
 
     //7. Save SS coverage
-    SaveComponent<SSCoverageContainer>(basename, gp);
+    SaveComponent<SSCoverageContainer>(tasks, basename, gp);
 
     //8. Save trusted paths
-    SaveComponent<path_extend::TrustedPathsContainer>(basename, gp);
+    SaveComponent<path_extend::TrustedPathsContainer>(tasks, basename, gp);
+
+    tasks.Run();
 }
 
 bool FullPackIO::Load(const std::string &basename, Type &gp) {
@@ -303,27 +376,30 @@ bool FullPackIO::Load(const std::string &basename, Type &gp) {
     //1. Load basic graph pack
     base::Load(basename, gp);
 
+    ParallelTasks tasks;
     //2. Load paired indices
     using namespace omnigraph::de;
-    LoadComponent<UnclusteredPairedInfoIndicesT<Graph>>(basename, gp);
+    LoadComponent<UnclusteredPairedInfoIndicesT<Graph>>(tasks, basename, gp);
 
     //3. Load clustered indices
-    LoadComponent<PairedInfoIndicesT<Graph>>(basename + "_cl", gp, "clustered_indices");
+    LoadComponent<PairedInfoIndicesT<Graph>>(tasks, basename + "_cl", gp, "clustered_indices");
 
     //4. Load scaffolding indices
-    LoadComponent<PairedInfoIndicesT<Graph>>(basename + "_scf", gp, "scaffolding_indices");
+    LoadComponent<PairedInfoIndicesT<Graph>>(tasks, basename + "_scf", gp, "scaffolding_indices");
 
     //5. Load long reads
-    LoadComponent<LongReadContainer<Graph>>(basename, gp);
+    LoadComponent<LongReadContainer<Graph>>(tasks, basename, gp);
 
     //6. Load genomic info
-    LoadComponent<GenomicInfo>(basename, gp);
+    LoadComponent<GenomicInfo>(tasks, basename, gp);
 
     //7. Load SS coverage
-    LoadComponent<SSCoverageContainer>(basename, gp);
+    LoadComponent<SSCoverageContainer>(tasks, basename, gp);
 
     //8. Load trusted paths
-    LoadComponent<path_extend::TrustedPathsContainer>(basename, gp);
+    LoadComponent<path_extend::TrustedPathsContainer>(tasks, basename, gp);
+
+    tasks.Run();
 
     return true;
 }
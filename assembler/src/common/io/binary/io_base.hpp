@@ -7,6 +7,7 @@
 #pragma once
 
 #include "binary.hpp"
+#include "checkpoint.hpp"
 #include "utils/logger/logger.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/file_opener.hpp"
@@ -99,11 +100,12 @@ public:
 
     void Save(const std::string &basename, const T &value) override {
         std::string filename = basename + this->ext_;
-        std::ofstream file(filename, std::ios::binary);
+        OutputFile file(filename);
         DEBUG("Saving " << this->name_ << " into " << filename);
-        VERIFY(file);
-        BinOStream writer(file);
+        VERIFY(file.stream());
+        BinOStream writer(file.stream());
         this->SaveImpl(writer, value);
+        file.Close();
     }
 
     void SaveEmpty(const std::string &basename) {
@@ -119,14 +121,14 @@ public:
      */
     bool Load(const std::string &basename, T &value) override {
         std::string filename = basename + this->ext_;
-        auto file = fs::open_file(filename, std::ios::binary);
+        InputFile file(filename);
         //check file is empty
-        if (file.peek() == std::ifstream::traits_type::eof()) {
+        if (file.stream().peek() == std::ifstream::traits_type::eof()) {
             return false;
         }
-        CHECK_FATAL_ERROR(file, "Failed to read " << filename);
+        CHECK_FATAL_ERROR(file.stream(), "Failed to read " << filename);
         DEBUG("Loading " << this->name_ << " from " << filename);
-        BinIStream reader(file);
+        BinIStream reader(file.stream());
         this->LoadImpl(reader, value);
         return true;
     }
@@ -169,9 +171,10 @@ public:
         return file_is_present;
     }
 
-private:
+protected:
     const char *name_, *ext_;
 
+private:
     virtual void SaveImpl(BinOStream &str, const T &value) = 0;
     virtual void LoadImpl(BinIStream &str, T &value) = 0;
 
@@ -0,0 +1,146 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/logger/logger.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace io {
+
+namespace binary {
+
+// Arrays are aligned to the cache line with respect to the file start
+static constexpr size_t MAPPED_ALIGNMENT = 64;
+
+/**
+ * @brief  A file mapped into memory as a whole. The pages are read lazily on the first access.
+ *         The mapping is private: the memory could be modified, but the changes are never
+ *         carried to the file.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &filename)
+            : filename_(filename), data_(nullptr), size_(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        CHECK_FATAL_ERROR(fd != -1, "open(2) failed. Reason: " << strerror(errno) << ". File: " << filename);
+
+        struct stat buf;
+        CHECK_FATAL_ERROR(fstat(fd, &buf) == 0, "fstat(2) failed. Reason: " << strerror(errno) << ". File: " << filename);
+        size_ = buf.st_size;
+        if (size_) {
+            void *res = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            CHECK_FATAL_ERROR(res != MAP_FAILED, "mmap(2) failed. Reason: " << strerror(errno) << ". File: " << filename);
+            data_ = static_cast<char*>(res);
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_)
+            munmap(data_, size_);
+    }
+
+    const std::string &filename() const { return filename_; }
+    char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    std::string filename_;
+    char *data_;
+    size_t size_;
+};
+
+/**
+ * @brief  Writes the data in the layout MappedReader could use in place.
+ */
+class AlignedWriter {
+public:
+    explicit AlignedWriter(std::ostream &os)
+            : os_(os), pos_(0) {}
+
+    AlignedWriter &write(const char *data, std::streamsize size) {
+        os_.write(data, size);
+        pos_ += size;
+        return *this;
+    }
+
+    template<class T>
+    AlignedWriter &array(const T *data, size_t size) {
+        static_assert(std::is_trivially_copyable<T>::value, "Array elements should be trivially copyable");
+        static const char padding[MAPPED_ALIGNMENT] = {};
+        write(padding, (MAPPED_ALIGNMENT - pos_ % MAPPED_ALIGNMENT) % MAPPED_ALIGNMENT);
+        return write(reinterpret_cast<const char*>(data), sizeof(T) * size);
+    }
+
+    explicit operator bool() const {
+        return (bool)os_;
+    }
+
+private:
+    std::ostream &os_;
+    size_t pos_;
+};
+
+/**
+ * @brief  Reads the data written by AlignedWriter from the mapped file. Arrays are not copied,
+ *         the pointers into the mapped memory are returned instead.
+ */
+class MappedReader {
+public:
+    explicit MappedReader(std::shared_ptr<MappedFile> file)
+            : file_(std::move(file)), pos_(0) {}
+
+    MappedReader &read(char *data, std::streamsize size) {
+        check(size);
+        memcpy(data, file_->data() + pos_, size);
+        pos_ += size;
+        return *this;
+    }
+
+    template<class T>
+    T *array(size_t size) {
+        static_assert(std::is_trivially_copyable<T>::value, "Array elements should be trivially copyable");
+        pos_ += (MAPPED_ALIGNMENT - pos_ % MAPPED_ALIGNMENT) % MAPPED_ALIGNMENT;
+        check(sizeof(T) * size);
+        T *res = reinterpret_cast<T*>(file_->data() + pos_);
+        pos_ += sizeof(T) * size;
+        return res;
+    }
+
+    /**
+     * @brief  The mapping should outlive all the arrays obtained from the reader.
+     */
+    const std::shared_ptr<MappedFile> &file() const {
+        return file_;
+    }
+
+private:
+    void check(size_t size) const {
+        CHECK_FATAL_ERROR(pos_ + size <= file_->size(), "File " << file_->filename() << " is truncated");
+    }
+
+    std::shared_ptr<MappedFile> file_;
+    size_t pos_;
+};
+
+} // namespace binary
+
+} // namespace io
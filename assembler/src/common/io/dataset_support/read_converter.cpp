@@ -12,9 +12,11 @@
 #include "io/reads/multifile_reader.hpp"
 #include "io/reads/converting_reader_wrapper.hpp"
 #include "io/reads/edge_sequences_reader.hpp"
+#include "io/reads/gz_reader.hpp"
 
 #include "utils/filesystem/file_opener.hpp"
 #include "utils/logger/logger.hpp"
+#include "utils/perf/perfcounter.hpp"
 
 #include "threadpool/threadpool.hpp"
 
@@ -70,6 +72,8 @@ void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
     info.close();
 
     INFO("Converting reads to binary format for library #" << data.lib_index << " (takes a while)");
+    DecompressionStats decompression = DecompressionStats::Current();
+    utils::perf_counter pc;
     INFO("Converting paired reads");
     BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix);
 
@@ -99,6 +103,9 @@ void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
     data.read_count = read_stat.read_count;
     data.total_nucls = read_stat.total_len;
 
+    DecompressionStats::Report("Library #" + std::to_string(data.lib_index),
+                               DecompressionStats::Current() - decompression, pc.time());
+
     WriteBinaryInfo(data.binary_reads_info.bin_reads_info_file, data);
 }
 
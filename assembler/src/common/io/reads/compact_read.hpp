@@ -0,0 +1,277 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "single_read.hpp"
+#include "file_read_flags.hpp"
+
+#include "sequence/sequence.hpp"
+#include "sequence/sequence_tools.hpp"
+#include "sequence/quality.hpp"
+#include "sequence/nucl_kernels.hpp"
+#include "utils/verify.hpp"
+
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+namespace io {
+
+/*
+ * Character storage shared by a batch of CompactReads: names, qualities and
+ * sequences which cannot be 2-bit packed (containing N's, etc.)
+ */
+class ReadTextBuffer final : public llvm::ThreadSafeRefCountedBase<ReadTextBuffer> {
+public:
+    explicit ReadTextBuffer(size_t capacity)
+            : data_(new char[capacity]), capacity_(capacity), used_(0) {}
+
+    bool fits(size_t size) const {
+        return used_ + size <= capacity_;
+    }
+
+    size_t append(const char *s, size_t size) {
+        VERIFY(fits(size));
+        size_t offset = used_;
+        memcpy(data_.get() + used_, s, size);
+        used_ += size;
+        return offset;
+    }
+
+    const char *data() const {
+        return data_.get();
+    }
+
+private:
+    std::unique_ptr<char[]> data_;
+    size_t capacity_;
+    size_t used_;
+};
+
+/*
+ * Single read that does not own its data: the sequence is a 2-bit packed view
+ * into the batch buffer of the parser, name and quality are views into the
+ * batch text buffer materialized only on request. Copying of a read is cheap
+ * and never allocates, batch buffers are released when the last read
+ * referring them dies.
+ */
+class CompactRead {
+public:
+    CompactRead()
+            : seq_(EmptySequence()), text_(), name_offset_(0), name_size_(0),
+              qual_offset_(0), raw_offset_(0),
+              left_offset_(0), right_offset_(0),
+              qual_base_(0), valid_(false), has_qual_(false), has_raw_(false), rc_(false) {}
+
+    bool IsValid() const {
+        return valid_;
+    }
+
+    /*
+     * Packed sequence. For invalid reads non-ACGT nucleotides are replaced
+     * by arbitrary ones (the same as for SingleRead::sequence()).
+     */
+    Sequence sequence(bool rc = false) const {
+        return rc ? !seq_ : seq_;
+    }
+
+    size_t size() const {
+        return seq_.size();
+    }
+
+    size_t nucl_count() const {
+        return size();
+    }
+
+    size_t qual_size() const {
+        return has_qual_ ? size() : 0;
+    }
+
+    std::string name() const {
+        if (!name_size_)
+            return "";
+
+        std::string name(text_->data() + name_offset_, name_size_);
+        if (!rc_)
+            return name;
+
+        // Follow SingleRead::operator! convention
+        if (name.length() >= 3 && name.compare(name.length() - 3, 3, "_RC") == 0)
+            return name.substr(0, name.length() - 3);
+        return name + "_RC";
+    }
+
+    std::string GetSequenceString() const {
+        if (!has_raw_)
+            return seq_.str();
+
+        std::string raw(text_->data() + raw_offset_, size());
+        return rc_ ? ReverseComplement(raw) : raw;
+    }
+
+    std::string GetQualityString() const {
+        if (!has_qual_)
+            return "";
+
+        std::string qual(text_->data() + qual_offset_, size());
+        for (auto &q : qual)
+            q = char(q - qual_base_);
+        if (rc_)
+            std::reverse(qual.begin(), qual.end());
+        return qual;
+    }
+
+    Quality quality() const {
+        VERIFY(valid_);
+        return Quality(GetQualityString());
+    }
+
+    CompactRead operator!() const {
+        CompactRead res(*this);
+        res.seq_ = !seq_;
+        res.rc_ = !rc_;
+        std::swap(res.left_offset_, res.right_offset_);
+        return res;
+    }
+
+    SequenceOffsetT GetLeftOffset() const {
+        return left_offset_;
+    }
+
+    SequenceOffsetT GetRightOffset() const {
+        return right_offset_;
+    }
+
+    SingleRead ToSingleRead() const {
+        return SingleRead(name(), GetSequenceString(), GetQualityString(),
+                          left_offset_, right_offset_, valid_);
+    }
+
+    bool BinWrite(std::ostream &file, bool rc = false) const {
+        sequence(rc).BinWrite(file);
+        if (rc) {
+            file.write((const char *) &right_offset_, sizeof(right_offset_));
+            file.write((const char *) &left_offset_, sizeof(left_offset_));
+        } else {
+            file.write((const char *) &left_offset_, sizeof(left_offset_));
+            file.write((const char *) &right_offset_, sizeof(right_offset_));
+        }
+        return !file.fail();
+    }
+
+private:
+    friend class CompactReadBatcher;
+
+    // Shared, so default-constructed reads do not allocate either
+    static const Sequence &EmptySequence() {
+        static const Sequence empty;
+        return empty;
+    }
+
+    explicit CompactRead(const Sequence &seq)
+            : seq_(seq), text_(), name_offset_(0), name_size_(0),
+              qual_offset_(0), raw_offset_(0),
+              left_offset_(0), right_offset_(0),
+              qual_base_(0), valid_(false), has_qual_(false), has_raw_(false), rc_(false) {}
+
+    Sequence seq_;
+    llvm::IntrusiveRefCntPtr<ReadTextBuffer> text_;
+
+    uint32_t name_offset_;
+    uint32_t name_size_;
+    // Quality and raw sequence are both of size() characters
+    uint32_t qual_offset_;
+    uint32_t raw_offset_;
+
+    //Left and right offsets with respect to original sequence
+    SequenceOffsetT left_offset_;
+    SequenceOffsetT right_offset_;
+
+    uint8_t qual_base_;
+    bool valid_ : 1;
+    bool has_qual_ : 1;
+    bool has_raw_ : 1;
+    bool rc_ : 1;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const CompactRead &read) {
+    os << "Compact read name=" << (read.name().length() ? read.name() : "(empty)") << " sequence=" << read.GetSequenceString() << std::endl;
+    return os;
+}
+
+/*
+ * Packs reads into the batch buffers shared between CompactReads. New buffers
+ * are allocated once the current ones are full, so the amortized number of
+ * allocations per read is essentially zero.
+ */
+class CompactReadBatcher {
+public:
+    const static size_t DefaultNucls = size_t(1) << 22;
+    const static size_t DefaultText = size_t(1) << 22;
+
+    explicit CompactReadBatcher(size_t nucls_capacity = DefaultNucls,
+                                size_t text_capacity = DefaultText)
+            : nucls_capacity_(nucls_capacity), text_capacity_(text_capacity) {}
+
+    CompactRead Add(const char *name, size_t name_size,
+                    const char *seq, size_t size,
+                    const char *qual, size_t qual_size,
+                    uint8_t qual_base, bool validate) {
+        CHECK_FATAL_ERROR(!qual_size || qual_size == size,
+                          "Invalid read: length of sequence should equal to length of quality line");
+
+        if (!seqs_ || !seqs_->fits(size)) {
+            size_t capacity = std::max(nucls_capacity_, size);
+            seqs_.reset(new SequenceBatchBuilder(capacity));
+        }
+        CompactRead read(seqs_->append(seq, size));
+
+        bool valid_nucls = nucl_kernels::IsValid(seq, size);
+        read.valid_ = validate && valid_nucls;
+        read.has_raw_ = !valid_nucls;
+        read.has_qual_ = qual_size != 0;
+        read.qual_base_ = qual_base;
+
+        size_t text_size = name_size + qual_size + (read.has_raw_ ? size : 0);
+        if (text_size) {
+            if (!text_ || !text_->fits(text_size))
+                text_ = new ReadTextBuffer(std::max(text_capacity_, text_size));
+            read.text_ = text_;
+            read.name_size_ = uint32_t(name_size);
+            read.name_offset_ = uint32_t(text_->append(name, name_size));
+            if (read.has_qual_)
+                read.qual_offset_ = uint32_t(text_->append(qual, qual_size));
+            if (read.has_raw_)
+                read.raw_offset_ = uint32_t(text_->append(seq, size));
+        }
+
+        return read;
+    }
+
+    CompactRead Add(const SingleRead &read) {
+        const std::string &name = read.name();
+        const std::string &seq = read.GetSequenceString();
+        const std::string &qual = read.GetQualityString();
+        CompactRead res = Add(name.data(), name.size(),
+                              seq.data(), seq.size(),
+                              qual.data(), qual.size(),
+                              0, read.IsValid());
+        res.left_offset_ = read.GetLeftOffset();
+        res.right_offset_ = read.GetRightOffset();
+        return res;
+    }
+
+private:
+    size_t nucls_capacity_;
+    size_t text_capacity_;
+    std::unique_ptr<SequenceBatchBuilder> seqs_;
+    llvm::IntrusiveRefCntPtr<ReadTextBuffer> text_;
+};
+
+}
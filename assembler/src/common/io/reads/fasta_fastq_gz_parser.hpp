@@ -8,6 +8,7 @@
 #pragma once
 
 #include "single_read.hpp"
+#include "gz_reader.hpp"
 
 #include "utils/verify.hpp"
 #include "io/reads/parser.hpp"
@@ -16,18 +17,22 @@
 
 #include "kseq/kseq.h"
 
-#include <zlib.h>
+#include <memory>
 #include <string>
 
 namespace io {
 
 namespace fastafastqgz {
+inline int gzreader_read(GzReader *reader, void *buf, unsigned len) {
+    return reader->read(buf, len);
+}
+
 // STEP 1: declare the type of file handler and the read() function
 // Silence bogus gcc warnings
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
 // STEP 1: declare the type of file handler and the read() function
-KSEQ_INIT(gzFile, gzread)
+KSEQ_INIT(GzReader*, gzreader_read)
 #pragma GCC diagnostic pop
 }
 
@@ -79,6 +84,29 @@ public:
         return *this;
     }
 
+    /*
+     * Read CompactRead from stream packing kseq buffers straight into the
+     * batch buffers.
+     *
+     * @param read The CompactRead that will store read data.
+     *
+     * @return Reference to this stream.
+     */
+    /* virtual */
+    FastaFastqGzParser& operator>>(CompactRead& read) {
+        if (!is_open_ || eof_)
+            return *this;
+
+        bool use_quality = seq_->qual.s && flags_.use_name && flags_.use_quality;
+        read = compact_batcher_.Add(seq_->name.s, flags_.use_name ? seq_->name.l : 0,
+                                    seq_->seq.s, seq_->seq.l,
+                                    seq_->qual.s, use_quality ? seq_->qual.l : 0,
+                                    uint8_t(flags_.offset), flags_.validate);
+
+        ReadAhead();
+        return *this;
+    }
+
     /*
      * Close the stream.
      */
@@ -90,7 +118,7 @@ public:
         // STEP 5: destroy seq
         fastafastqgz::kseq_destroy(seq_);
         // STEP 6: close the file handler
-        gzclose(fp_);
+        fp_.reset();
         is_open_ = false;
         eof_ = true;
     }
@@ -99,7 +127,7 @@ private:
     /*
      * @variable File that is associated with gzipped data file.
      */
-    gzFile fp_;
+    std::unique_ptr<GzReader> fp_;
     /*
      * @variable Data element that stores last SingleRead got from
      * stream.
@@ -112,13 +140,14 @@ private:
     /* virtual */
     void open() {
         // STEP 2: open the file handler
-        fp_ = gzopen(filename_.c_str(), "r");
-        if (!fp_) {
+        fp_.reset(new GzReader(filename_));
+        if (!fp_->is_open()) {
+            fp_.reset();
             is_open_ = false;
             return;
         }
         // STEP 3: initialize seq
-        seq_ = fastafastqgz::kseq_init(fp_);
+        seq_ = fastafastqgz::kseq_init(fp_.get());
         eof_ = false;
         is_open_ = true;
         ReadAhead();
@@ -80,6 +80,20 @@ public:
         return *this;
     }
 
+    /*
+     * Read CompactRead from stream.
+     *
+     * @param read The CompactRead that will store read data.
+     *
+     * @return Reference to this stream.
+     */
+    FileReadStream &operator>>(CompactRead &read) {
+        if (parser_)
+            (*parser_) >> read;
+
+        return *this;
+    }
+
     /*
      * Close the stream.
      */
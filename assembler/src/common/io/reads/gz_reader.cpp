@@ -0,0 +1,334 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "gz_reader.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include "threadpool/threadpool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace io {
+
+namespace {
+
+// Number of read-ahead buffers
+const size_t RING_SIZE = 4;
+// Size of the read-ahead buffer for ordinary gzip
+const size_t GZIP_CHUNK_SIZE = 1 << 20;
+// BGZF blocks are <= 64 Kb, so this gives ~4 Mb chunks
+const size_t BGZF_CHUNK_BLOCKS = 64;
+// BGZF blocks inflated by a single task
+const size_t BGZF_TASK_BLOCKS = 8;
+
+std::atomic<uint64_t> total_compressed{0};
+std::atomic<uint64_t> total_uncompressed{0};
+std::atomic<uint64_t> total_cpu_time_ns{0};
+
+uint64_t ThreadCPUTimeNs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+uint32_t ReadLE32(const char *p) {
+    const unsigned char *u = reinterpret_cast<const unsigned char*>(p);
+    return uint32_t(u[0]) | uint32_t(u[1]) << 8 | uint32_t(u[2]) << 16 | uint32_t(u[3]) << 24;
+}
+
+uint16_t ReadLE16(const char *p) {
+    const unsigned char *u = reinterpret_cast<const unsigned char*>(p);
+    return uint16_t(u[0] | u[1] << 8);
+}
+
+// Size of the BGZF block (from the BC extra subfield), 0 if there is no such subfield
+size_t BGZFBlockSize(const char *extra, size_t xlen) {
+    for (size_t pos = 0; pos + 4 <= xlen; ) {
+        size_t slen = ReadLE16(extra + pos + 2);
+        if (extra[pos] == 'B' && extra[pos + 1] == 'C' && slen == 2 && pos + 6 <= xlen)
+            return size_t(ReadLE16(extra + pos + 4)) + 1;
+        pos += 4 + slen;
+    }
+    return 0;
+}
+
+const size_t GZIP_HEADER_SIZE = 12; // Fixed part of gzip header + XLEN
+const size_t GZIP_FOOTER_SIZE = 8;  // CRC32 + ISIZE
+
+bool IsGzipHeader(const char *header, size_t size) {
+    return size >= 2 && (unsigned char)header[0] == 0x1f && (unsigned char)header[1] == 0x8b;
+}
+
+bool IsBGZFHeader(const char *header, size_t size) {
+    if (size < GZIP_HEADER_SIZE || !IsGzipHeader(header, size) ||
+        header[2] != 8 || !(header[3] & 4))
+        return false;
+
+    size_t xlen = ReadLE16(header + 10);
+    return BGZFBlockSize(header + GZIP_HEADER_SIZE, std::min(xlen, size - GZIP_HEADER_SIZE)) != 0;
+}
+
+// Shared between all the readers, so the number of inflating threads does
+// not depend on the number of files opened simultaneously
+ThreadPool::ThreadPool &InflatePool() {
+    static ThreadPool::ThreadPool pool(std::max(1, omp_get_max_threads()));
+    return pool;
+}
+
+}
+
+DecompressionStats DecompressionStats::Current() {
+    DecompressionStats res;
+    res.compressed = total_compressed;
+    res.uncompressed = total_uncompressed;
+    res.cpu_time = double(total_cpu_time_ns) / 1e9;
+    return res;
+}
+
+void DecompressionStats::Report(const std::string &title, const DecompressionStats &stats, double wall_time) {
+    if (!stats.uncompressed)
+        return;
+
+    INFO(title << ": decompressed " << stats.compressed / 1024 / 1024 << " Mb into "
+         << stats.uncompressed / 1024 / 1024 << " Mb, "
+         << (wall_time > 0 ? double(stats.uncompressed) / 1024 / 1024 / wall_time : 0) << " Mb/s, "
+         << "inflate CPU time " << stats.cpu_time << " s ("
+         << (wall_time > 0 ? 100 * stats.cpu_time / wall_time : 0) << "% of wall time)");
+}
+
+GzReader::GzReader(const std::string &filename)
+        : filename_(filename), format_(Format::Plain), is_open_(false), eof_(false),
+          gz_(nullptr), raw_(nullptr), current_(0), inflater_(nullptr), stop_(false), gz_offset_(0) {
+    raw_ = fopen(filename_.c_str(), "rb");
+    if (!raw_)
+        return;
+
+    char header[64];
+    size_t header_size = fread(header, 1, sizeof(header), raw_);
+    if (IsBGZFHeader(header, header_size))
+        format_ = Format::BGZF;
+    else if (IsGzipHeader(header, header_size))
+        format_ = Format::Gzip;
+
+    fseeko(raw_, 0, SEEK_SET);
+
+    if (format_ != Format::BGZF) {
+        fclose(raw_);
+        raw_ = nullptr;
+
+        gz_ = gzopen(filename_.c_str(), "rb");
+        if (!gz_)
+            return;
+        gzbuffer(gz_, 1 << 17);
+    }
+
+    is_open_ = true;
+    if (format_ == Format::Plain)
+        return;
+
+    DEBUG("Reading " << filename_ << (format_ == Format::BGZF ? " as BGZF" : " as gzip"));
+    reader_.reset(new ThreadPool::ThreadPool(1));
+    if (format_ == Format::BGZF)
+        inflater_ = &InflatePool();
+
+    ring_ = std::vector<Chunk>(RING_SIZE);
+    for (auto &chunk : ring_)
+        Submit(chunk);
+}
+
+GzReader::~GzReader() {
+    close();
+}
+
+void GzReader::Submit(Chunk &chunk) {
+    chunk.pos = chunk.size = 0;
+    // Tasks are executed in the order of submission, since there is a single reader thread
+    chunk.filled = reader_->run([this, &chunk] {
+        if (stop_)
+            return;
+
+        if (format_ == Format::BGZF)
+            FillBGZF(chunk);
+        else
+            FillGzip(chunk);
+    });
+}
+
+bool GzReader::Wait(Chunk &chunk) {
+    chunk.filled.get();
+    for (auto &f : chunk.inflated)
+        f.get();
+    chunk.inflated.clear();
+
+    // Accounted once consumed, so the totals are up to date while the file is open
+    total_compressed += chunk.compressed;
+    total_uncompressed += chunk.size;
+    return chunk.size != 0;
+}
+
+void GzReader::FillGzip(Chunk &chunk) {
+    uint64_t start = ThreadCPUTimeNs();
+    chunk.data.resize(GZIP_CHUNK_SIZE);
+    int res = gzread(gz_, chunk.data.data(), unsigned(chunk.data.size()));
+    if (res < 0) {
+        int errnum;
+        FATAL_ERROR("Error while decompressing " << filename_ << ": " << gzerror(gz_, &errnum));
+    }
+    chunk.size = size_t(res);
+    uint64_t offset = uint64_t(gzoffset(gz_));
+    chunk.compressed = offset - gz_offset_;
+    gz_offset_ = offset;
+    total_cpu_time_ns += ThreadCPUTimeNs() - start;
+}
+
+bool GzReader::ReadBGZFBlock(Chunk &chunk) {
+    size_t start = chunk.raw.size();
+    chunk.raw.resize(start + GZIP_HEADER_SIZE);
+    size_t read = fread(chunk.raw.data() + start, 1, GZIP_HEADER_SIZE, raw_);
+    if (read == 0) {
+        chunk.raw.resize(start);
+        return false;
+    }
+
+    const char *header = chunk.raw.data() + start;
+    CHECK_FATAL_ERROR(read == GZIP_HEADER_SIZE && IsGzipHeader(header, read) && (header[3] & 4),
+                      "Corrupted BGZF block in " << filename_);
+    size_t xlen = ReadLE16(header + 10);
+
+    chunk.raw.resize(start + GZIP_HEADER_SIZE + xlen);
+    CHECK_FATAL_ERROR(fread(chunk.raw.data() + start + GZIP_HEADER_SIZE, 1, xlen, raw_) == xlen,
+                      "Truncated BGZF block in " << filename_);
+    size_t block_size = BGZFBlockSize(chunk.raw.data() + start + GZIP_HEADER_SIZE, xlen);
+    CHECK_FATAL_ERROR(block_size >= GZIP_HEADER_SIZE + xlen + GZIP_FOOTER_SIZE,
+                      "Corrupted BGZF block in " << filename_);
+
+    size_t rest = block_size - GZIP_HEADER_SIZE - xlen;
+    chunk.raw.resize(start + block_size);
+    CHECK_FATAL_ERROR(fread(chunk.raw.data() + start + GZIP_HEADER_SIZE + xlen, 1, rest, raw_) == rest,
+                      "Truncated BGZF block in " << filename_);
+
+    const char *footer = chunk.raw.data() + start + block_size - GZIP_FOOTER_SIZE;
+    Block block;
+    block.raw_offset = start + GZIP_HEADER_SIZE + xlen;
+    block.raw_size = rest - GZIP_FOOTER_SIZE;
+    block.crc = ReadLE32(footer);
+    block.offset = chunk.size;
+    block.size = ReadLE32(footer + 4);
+    chunk.blocks.push_back(block);
+    chunk.size += block.size;
+
+    return true;
+}
+
+void GzReader::FillBGZF(Chunk &chunk) {
+    chunk.raw.clear();
+    chunk.blocks.clear();
+
+    // Skip over empty (e.g. EOF marker) blocks
+    while (chunk.blocks.size() < BGZF_CHUNK_BLOCKS || chunk.size == 0) {
+        if (!ReadBGZFBlock(chunk))
+            break;
+    }
+
+    chunk.compressed = chunk.raw.size();
+    chunk.data.resize(chunk.size);
+    for (size_t i = 0; i < chunk.blocks.size(); i += BGZF_TASK_BLOCKS) {
+        size_t to = std::min(i + BGZF_TASK_BLOCKS, chunk.blocks.size());
+        chunk.inflated.push_back(inflater_->run([this, &chunk, i, to] { InflateBGZF(chunk, i, to); }));
+    }
+}
+
+void GzReader::InflateBGZF(Chunk &chunk, size_t from, size_t to) {
+    uint64_t start = ThreadCPUTimeNs();
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    int init = inflateInit2(&strm, -MAX_WBITS);
+    VERIFY_MSG(init == Z_OK, "Cannot initialize zlib");
+    for (size_t i = from; i < to; ++i) {
+        const Block &block = chunk.blocks[i];
+        inflateReset(&strm);
+        strm.next_in = reinterpret_cast<Bytef*>(chunk.raw.data() + block.raw_offset);
+        strm.avail_in = uInt(block.raw_size);
+        strm.next_out = reinterpret_cast<Bytef*>(chunk.data.data() + block.offset);
+        strm.avail_out = uInt(block.size);
+        int res = inflate(&strm, Z_FINISH);
+        CHECK_FATAL_ERROR(res == Z_STREAM_END && strm.total_out == block.size,
+                          "Error while decompressing BGZF block in " << filename_);
+        CHECK_FATAL_ERROR(crc32(crc32(0L, Z_NULL, 0), strm.next_out - block.size, uInt(block.size)) == block.crc,
+                          "CRC mismatch in BGZF block in " << filename_);
+    }
+    inflateEnd(&strm);
+
+    total_cpu_time_ns += ThreadCPUTimeNs() - start;
+}
+
+int GzReader::read(void *buf, unsigned len) {
+    if (!is_open_ || eof_)
+        return 0;
+
+    if (format_ == Format::Plain) {
+        int res = gzread(gz_, buf, len);
+        if (res < 0) {
+            int errnum;
+            FATAL_ERROR("Error while reading " << filename_ << ": " << gzerror(gz_, &errnum));
+        }
+        return res;
+    }
+
+    char *out = static_cast<char*>(buf);
+    size_t copied = 0;
+    while (copied < len) {
+        Chunk &chunk = ring_[current_];
+        // The chunk becomes current once it is completely filled
+        if (chunk.filled.valid() && !Wait(chunk)) {
+            eof_ = true;
+            break;
+        }
+
+        size_t n = std::min(size_t(len) - copied, chunk.size - chunk.pos);
+        memcpy(out + copied, chunk.data.data() + chunk.pos, n);
+        chunk.pos += n;
+        copied += n;
+
+        if (chunk.pos == chunk.size) {
+            Submit(chunk);
+            current_ = (current_ + 1) % ring_.size();
+        }
+    }
+
+    return int(copied);
+}
+
+void GzReader::close() {
+    if (!is_open_)
+        return;
+
+    stop_ = true;
+    for (auto &chunk : ring_) {
+        if (chunk.filled.valid())
+            chunk.filled.wait();
+        for (auto &f : chunk.inflated)
+            f.wait();
+    }
+    reader_.reset();
+    ring_.clear();
+
+    if (gz_)
+        gzclose(gz_);
+    if (raw_)
+        fclose(raw_);
+    gz_ = nullptr;
+    raw_ = nullptr;
+    is_open_ = false;
+}
+
+}
@@ -0,0 +1,121 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <zlib.h>
+
+#include <atomic>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ThreadPool {
+class ThreadPool;
+}
+
+namespace io {
+
+/*
+ * Process-wide decompression counters. Snapshot them around some work to
+ * get throughput and CPU use of decompression for it.
+ */
+struct DecompressionStats {
+    uint64_t compressed = 0;
+    uint64_t uncompressed = 0;
+    // CPU time spent in inflate (summed over all threads)
+    double cpu_time = 0;
+
+    DecompressionStats operator-(const DecompressionStats &rhs) const {
+        DecompressionStats res;
+        res.compressed = compressed - rhs.compressed;
+        res.uncompressed = uncompressed - rhs.uncompressed;
+        res.cpu_time = cpu_time - rhs.cpu_time;
+        return res;
+    }
+
+    static DecompressionStats Current();
+    static void Report(const std::string &title, const DecompressionStats &stats, double wall_time);
+};
+
+/*
+ * Reader for (possibly) gzipped files with read-ahead:
+ *  - plain files are read synchronously;
+ *  - ordinary gzip is inflated on a dedicated background thread into a ring
+ *    of buffers;
+ *  - BGZF (bgzip, BAM-style blocked gzip) blocks are inflated in parallel
+ *    on a shared thread pool, while raw blocks are read on the background
+ *    thread.
+ * The read() interface mimics gzread() so the reader could be plugged into kseq.
+ */
+class GzReader {
+public:
+    enum class Format {
+        Plain,
+        Gzip,
+        BGZF
+    };
+
+    explicit GzReader(const std::string &filename);
+    ~GzReader();
+
+    GzReader(const GzReader&) = delete;
+    GzReader &operator=(const GzReader&) = delete;
+
+    bool is_open() const { return is_open_; }
+    Format format() const { return format_; }
+
+    // Reads up to len bytes into buf, returns 0 on EOF
+    int read(void *buf, unsigned len);
+
+    void close();
+
+private:
+    struct Block {
+        size_t raw_offset, raw_size;
+        size_t offset, size;
+        uint32_t crc;
+    };
+
+    struct Chunk {
+        std::vector<char> raw;
+        std::vector<Block> blocks;
+        std::vector<char> data;
+        size_t size = 0, pos = 0;
+        // Size of the compressed data the chunk was inflated from
+        size_t compressed = 0;
+        std::future<void> filled;
+        std::vector<std::future<void>> inflated;
+    };
+
+    void Submit(Chunk &chunk);
+    bool Wait(Chunk &chunk);
+    void FillGzip(Chunk &chunk);
+    void FillBGZF(Chunk &chunk);
+    bool ReadBGZFBlock(Chunk &chunk);
+    void InflateBGZF(Chunk &chunk, size_t from, size_t to);
+
+    std::string filename_;
+    Format format_;
+    bool is_open_;
+    bool eof_;
+
+    gzFile gz_;
+    FILE *raw_;
+
+    std::vector<Chunk> ring_;
+    size_t current_;
+    std::unique_ptr<ThreadPool::ThreadPool> reader_;
+    ThreadPool::ThreadPool *inflater_;
+    std::atomic<bool> stop_;
+
+    // Compressed offset of the ordinary gzip stream after the last filled chunk
+    uint64_t gz_offset_;
+};
+
+}
@@ -31,6 +31,18 @@ SingleStream EasyStream(const std::string& filename, bool followed_by_rc,
     return reader;
 }
 
+CompactSingleStream CompactStream(const std::string& filename, bool followed_by_rc,
+                                  FileReadFlags flags,
+                                  ThreadPool::ThreadPool *pool) {
+    CompactSingleStream reader = (pool ?
+                                  CompactSingleStream(AsyncReadStream<CompactRead>(FileReadStream(filename, flags), *pool)) :
+                                  CompactSingleStream(FileReadStream(filename, flags)));
+    if (followed_by_rc)
+        reader = RCWrap<CompactRead>(std::move(reader));
+
+    return reader;
+}
+
 PairedStream EasyWrapPairedStream(PairedStream stream,
                                   bool followed_by_rc,
                                   LibraryOrientation orientation,
@@ -9,6 +9,7 @@
 
 #include "read_stream_vector.hpp"
 #include "single_read.hpp"
+#include "compact_read.hpp"
 #include "paired_read.hpp"
 
 #include "pipeline/library_fwd.hpp"
@@ -32,10 +33,18 @@ typedef ReadStreamList<SingleReadSeq> BinarySingleStreams;
 typedef ReadStream<PairedReadSeq> BinaryPairedStream;
 typedef ReadStreamList<PairedReadSeq> BinaryPairedStreams;
 
+typedef ReadStream<CompactRead> CompactSingleStream;
+typedef ReadStreamList<CompactRead> CompactSingleStreams;
+
 SingleStream EasyStream(const std::string& filename, bool followed_by_rc,
                         bool handle_Ns = true,
                         FileReadFlags flags = FileReadFlags(),
                         ThreadPool::ThreadPool *pool = nullptr);
+// Reads are packed right from the parser buffers, invalid reads are passed as
+// is (with IsValid() == false) since there is no LongestValidWrapper for them
+CompactSingleStream CompactStream(const std::string& filename, bool followed_by_rc,
+                                  FileReadFlags flags = FileReadFlags(),
+                                  ThreadPool::ThreadPool *pool = nullptr);
 PairedStream EasyWrapPairedStream(PairedStream stream,
                                   bool followed_by_rc,
                                   LibraryOrientation orientation, bool handle_Ns=true);
@@ -27,6 +27,7 @@
 #define COMMON_IO_PARSER_HPP
 
 #include "single_read.hpp"
+#include "compact_read.hpp"
 #include "file_read_flags.hpp"
 #include <string>
 
@@ -78,6 +79,25 @@ public:
      */
     virtual Parser &operator>>(SingleRead &read) = 0;
 
+    /*
+     * Read CompactRead from stream. Parsers that are able to pack their
+     * input directly should override this, by default the read is
+     * converted from SingleRead.
+     *
+     * @param read The CompactRead that will store read data.
+     *
+     * @return Reference to this stream.
+     */
+    virtual Parser &operator>>(CompactRead &read) {
+        if (!is_open_ || eof_)
+            return *this;
+
+        SingleRead single;
+        *this >> single;
+        read = compact_batcher_.Add(single);
+        return *this;
+    }
+
     /*
      * Close the stream.
      */
@@ -109,6 +129,10 @@ protected:
      * reached.
      */
     bool eof_;
+    /*
+     * @variable Batch buffers for CompactReads
+     */
+    CompactReadBatcher compact_batcher_;
 
 private:
     /*
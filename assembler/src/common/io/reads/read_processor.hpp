@@ -11,7 +11,11 @@
 #include "io/reads/mpmc_bounded.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <sched.h>
 
 #pragma GCC diagnostic push
@@ -65,6 +69,28 @@ private:
         }
     }
 
+    static unsigned RoundUpPow2(unsigned n) {
+        unsigned bufsize = n - 1;
+        bufsize = (bufsize >> 1) | bufsize;
+        bufsize = (bufsize >> 2) | bufsize;
+        bufsize = (bufsize >> 4) | bufsize;
+        bufsize = (bufsize >> 8) | bufsize;
+        bufsize = (bufsize >> 16) | bufsize;
+        return bufsize + 1;
+    }
+
+    // Fixed-capacity arena of reads. Batches are recycled between producers and
+    // consumers, so read objects (and their string storage) are reused instead
+    // of being allocated for every read.
+    template<class Read>
+    struct ReadBatch {
+        std::vector<Read> reads;
+        size_t size = 0;
+
+        explicit ReadBatch(size_t capacity)
+                : reads(capacity) {}
+    };
+
 public:
     ReadProcessor(unsigned nthreads)
             : nthreads_(nthreads), read_(0), processed_(0) { }
@@ -134,6 +160,139 @@ public:
         return stop;
     }
 
+    // Multi-producer mode. Streams are distributed between nproducers parsing
+    // threads (stream i is read by producer i % nproducers), so several files
+    // or block-split chunks of one file (e.g. binary read streams opened with
+    // several chunks) are parsed concurrently. The producers are taken out of
+    // the nthreads, the rest of the threads consume the reads delivered in
+    // pooled batches. If there are no threads left for the producers, or fewer
+    // threads are granted (nested region, thread limit, no OpenMP), the
+    // consumers parse the streams themselves one batch at a time. Op is called
+    // as op(ReadT&) and only from threads with omp_get_thread_num() < nthreads.
+    template<class Streams, class Op>
+    bool RunParallel(Streams &streams, Op &op, unsigned nproducers,
+                     size_t batch_size = 1024) {
+        using ReadT = typename Streams::ReadT;
+        using Batch = ReadBatch<ReadT>;
+
+        unsigned nthreads = std::max(1u, nthreads_);
+        nproducers = std::min(nproducers, unsigned(streams.size()));
+        if (nproducers >= nthreads)
+            nproducers = 0;
+        unsigned nconsumers = nthreads - nproducers;
+
+        // Enough batches to keep every thread busy with one spare per thread
+        unsigned nbatches = RoundUpPow2(2 * nthreads);
+        std::vector<std::unique_ptr<Batch>> pool;
+        mpmc_bounded_queue<Batch*> free_queue(nbatches), full_queue(nbatches);
+        for (unsigned i = 0; i < nbatches; ++i) {
+            pool.emplace_back(new Batch(batch_size));
+            free_queue.enqueue(pool.back().get());
+        }
+
+        std::atomic<bool> stop(false);
+        auto consume = [&](Batch *batch) {
+#       pragma omp atomic
+            processed_ += batch->size;
+
+            bool res = false;
+            for (size_t i = 0; i < batch->size; ++i)
+                res |= op(batch->reads[i]);
+
+            if (res)
+                stop.store(true, std::memory_order_relaxed);
+        };
+
+        // Producer threads actually granted, the streams are shared between
+        // the consumers under the lock if there are none
+        unsigned ngranted = 0;
+        std::atomic<unsigned> producers_left(0);
+        std::mutex streams_lock;
+        size_t next_stream = 0;
+#   pragma omp parallel shared(streams, op, pool, free_queue, full_queue, producers_left, stop, ngranted, streams_lock, next_stream) num_threads(nthreads)
+        {
+#       pragma omp single
+            {
+                unsigned nthreads_granted = unsigned(omp_get_num_threads());
+                ngranted = nthreads_granted > nconsumers ? nthreads_granted - nconsumers : 0;
+                producers_left = ngranted;
+            }
+
+            unsigned thread_id = omp_get_thread_num();
+            if (!ngranted) {
+                Batch *batch;
+                while (!free_queue.dequeue(batch))
+                    sched_yield();
+
+                while (!stop.load(std::memory_order_relaxed)) {
+                    batch->size = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(streams_lock);
+                        while (batch->size < batch->reads.size() && next_stream < streams.size()) {
+                            auto &stream = streams[next_stream];
+                            if (stream.eof())
+                                ++next_stream;
+                            else
+                                stream >> batch->reads[batch->size++];
+                        }
+                    }
+                    if (!batch->size)
+                        break;
+
+#               pragma omp atomic
+                    read_ += batch->size;
+
+                    consume(batch);
+                }
+            } else if (thread_id >= nconsumers) {
+                unsigned producer_id = thread_id - nconsumers;
+                for (size_t i = producer_id; i < streams.size(); i += ngranted) {
+                    auto &stream = streams[i];
+                    while (!stream.eof() && !stop.load(std::memory_order_relaxed)) {
+                        Batch *batch;
+                        while (!free_queue.dequeue(batch))
+                            sched_yield();
+
+                        batch->size = 0;
+                        while (batch->size < batch->reads.size() && !stream.eof())
+                            stream >> batch->reads[batch->size++];
+
+#           pragma omp atomic
+                        read_ += batch->size;
+
+                        while (!full_queue.enqueue(batch))
+                            sched_yield();
+                    }
+                }
+
+                // The last producer to finish closes the queue
+                if (producers_left.fetch_sub(1) == 1)
+                    full_queue.close();
+            } else {
+                Batch *batch;
+                while (1) {
+                    if (!full_queue.dequeue(batch)) {
+                        // Queue might be closed right after the last batch was
+                        // enqueued, so check it once again after seeing it closed
+                        if (!full_queue.is_closed()) {
+                            sched_yield();
+                            continue;
+                        }
+                        if (!full_queue.dequeue(batch))
+                            break;
+                    }
+
+                    consume(batch);
+
+                    while (!free_queue.enqueue(batch))
+                        sched_yield();
+                }
+            }
+        }
+
+        return stop;
+    }
+
     template<class Reader, class Op, class Writer>
     void Run(Reader &irs, Op &op, Writer &writer) {
         using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
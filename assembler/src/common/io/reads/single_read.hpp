@@ -11,6 +11,7 @@
 #include "sequence/quality.hpp"
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
+#include "sequence/nucl_kernels.hpp"
 #include "sequence/sequence_tools.hpp"
 #include "utils/verify.hpp"
 #include "utils/stl_utils.hpp"
@@ -168,12 +169,7 @@ public:
     }
 
     static bool IsValid(const std::string &seq) {
-        size_t sz = seq.size();
-        for (size_t i = 0; i < sz; ++i) {
-            if (!is_nucl(seq[i]))
-                return false;
-        }
-        return true;
+        return nucl_kernels::IsValid(seq.data(), seq.size());
     }
 
     SequenceOffsetT GetLeftOffset() const {
@@ -32,6 +32,8 @@ public:
         close();
     }
 
+    using Parser::operator>>;
+
     BAMParser& operator>>(SingleRead& read) {
         if (!is_open_ || eof_)
             return *this;
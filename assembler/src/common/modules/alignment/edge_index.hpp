@@ -31,6 +31,7 @@ class EdgeIndex: public omnigraph::GraphActionHandler<Graph> {
     using InnerIndex64 = KmerFreeEdgeIndex<Graph, uint64_t>;
 
     typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
 public:
     typedef RtSeq KMer;
     static constexpr size_t NOT_FOUND = size_t(-1);
@@ -93,6 +94,15 @@ private:
         inner_index_ = index;
     }
 
+    template<class Index>
+    void Renumber(Index *index, const omnigraph::IdRenumbering<VertexId, EdgeId> &renumbering) {
+        if (!index)
+            return;
+
+        for (auto it = index->value_begin(); it != index->value_end(); ++it)
+            it->renumber(renumbering);
+    }
+
     template<class Writer, class Index>
     void BinWrite(const Index *index, Writer &writer) const {
         index->BinWrite(writer);
@@ -105,6 +115,18 @@ private:
         inner_index_ = index;
     }
 
+    template<class Writer, class Index>
+    void SaveAligned(const Index *index, Writer &writer) const {
+        index->SaveAligned(writer);
+    }
+
+    template<class Reader, class Index>
+    void Map(Index *, Reader &reader) {
+        auto index = new Index(this->g());
+        index->Map(reader);
+        inner_index_ = index;
+    }
+
 public:
     EdgeIndex(const Graph& g, const std::string &workdir)
             : omnigraph::GraphActionHandler<Graph>(g, "EdgeIndex"),
@@ -141,6 +163,14 @@ public:
         DISPATCH_TO(DeleteKmers, e);
     }
 
+    void HandleRenumbering(const omnigraph::IdRenumbering<VertexId, EdgeId> &renumbering) override {
+        DISPATCH_TO(Renumber, renumbering);
+    }
+
+    bool IsRenumberable() const override {
+        return true;
+    }
+
     bool contains(const KMer& kmer) const {
         DISPATCH_TO(contains, kmer);
     }
@@ -193,6 +223,27 @@ public:
         DISPATCH_TO(BinRead, reader);
     }
 
+    /**
+     * Saves the index in the layout Map() could use in place, see io::binary::AlignedWriter
+     */
+    template<class Writer>
+    void SaveAligned(Writer &writer) const {
+        writer.write((const char*)&large_index_, sizeof(large_index_));
+        DISPATCH_TO(SaveAligned, writer);
+    }
+
+    /**
+     * Uses the index saved by SaveAligned() right in the mapped memory: nothing
+     * is deserialized and the pages are read lazily on the first access.
+     * Modified pages become private copies, the file is never changed.
+     */
+    template<class Reader>
+    void Map(Reader &reader) {
+        VERIFY(inner_index_ == nullptr);
+        reader.read((char*)&large_index_, sizeof(large_index_));
+        DISPATCH_TO(Map, reader);
+    }
+
 };
 
 #undef DISPATCH_TO
@@ -149,6 +149,10 @@ public:
         RemapKmers(this->g().EdgeNucls(edge1), this->g().EdgeNucls(edge2));
     }
 
+    bool IsRenumberable() const override {
+        return true;
+    }
+
     const RawSeqData* GetRoot(const Kmer &kmer) const {
         const RawSeqData *answer = nullptr;
         const RawSeqData *rawval = mapping_.find(kmer);
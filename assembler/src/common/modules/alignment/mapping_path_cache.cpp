@@ -0,0 +1,149 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "mapping_path_cache.hpp"
+
+#include "io/binary/binary.hpp"
+#include "utils/filesystem/path_helper.hpp"
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
+#include <algorithm>
+
+namespace debruijn_graph {
+
+static const uint64_t CACHE_VERSION = 1;
+static const size_t NOT_PROCESSED = -1ul;
+
+uint64_t GraphFingerprint(const Graph &g) {
+    uint64_t res = g.k();
+    for (EdgeId e : g.edges()) {
+        const Sequence &nucls = g.EdgeNucls(e);
+        uint64_t data[] = { e.int_id(), g.EdgeStart(e).int_id(), g.EdgeEnd(e).int_id(), nucls.size() };
+        res = XXH3_64bits_withSeed(data, sizeof(data), res);
+        res = nucls.GetHash(res);
+    }
+    return res;
+}
+
+MappingPathCache::Cursor::Cursor(MappingPathCache &cache, size_t stream)
+        : cache_(cache), stream_(stream), count_(0) {
+    VERIFY(stream < cache_.counts_.size());
+    file_.open(cache_.stream_file(stream),
+               std::ios::binary | (cache_.replaying_ ? std::ios::in : std::ios::out | std::ios::trunc));
+    VERIFY_MSG(file_.is_open(), "Cannot open mapping cache file " << cache_.stream_file(stream));
+}
+
+MappingPathCache::Cursor::~Cursor() {
+    if (cache_.replaying_) {
+        VERIFY_MSG(count_ == cache_.counts_[stream_],
+                   "Mapping cache " << cache_.stream_file(stream_) << " does not match the read stream");
+    } else {
+        file_.flush();
+        if (file_)
+            cache_.counts_[stream_] = count_;
+    }
+}
+
+// Ranges are stored as start / length pairs to keep the LEB128-encoded
+// values small. Quality is stored only if it is not the default one.
+void MappingPathCache::Cursor::Write(const MappingPath<EdgeId> &path) {
+    io::binary::BinOStream str(file_);
+    str << path.size();
+    for (size_t i = 0; i < path.size(); ++i) {
+        MappingRange range = path.mapping_at(i);
+        bool default_quality = range.quality == 1.0;
+        str << path.edge_at(i).int_id()
+            << range.initial_range.start_pos << range.initial_range.size()
+            << range.mapped_range.start_pos << range.mapped_range.size()
+            << default_quality;
+        if (!default_quality)
+            str << range.quality;
+    }
+}
+
+MappingPath<EdgeId> MappingPathCache::Cursor::Read() {
+    io::binary::BinIStream str(file_);
+    size_t size = str.Read<size_t>();
+    std::vector<EdgeId> edges(size);
+    std::vector<MappingRange> ranges(size);
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t id;
+        size_t initial_start, initial_size, mapped_start, mapped_size;
+        bool default_quality;
+        str >> id >> initial_start >> initial_size >> mapped_start >> mapped_size >> default_quality;
+        edges[i] = id;
+        ranges[i] = MappingRange(initial_start, initial_start + initial_size,
+                                 mapped_start, mapped_start + mapped_size,
+                                 default_quality ? 1.0 : str.Read<double>());
+    }
+    VERIFY_MSG(str, "Mapping cache " << cache_.stream_file(stream_) << " is truncated");
+    return MappingPath<EdgeId>(edges, ranges);
+}
+
+MappingPathCache::MappingPathCache(const std::string &prefix, const Graph &g)
+        : prefix_(prefix), fingerprint_(GraphFingerprint(g)), replaying_(false) {}
+
+std::string MappingPathCache::stream_file(size_t stream) const {
+    return prefix_ + "_" + std::to_string(stream) + ".mpc";
+}
+
+std::string MappingPathCache::info_file() const {
+    return prefix_ + ".mpc";
+}
+
+void MappingPathCache::Start(size_t streams) {
+    replaying_ = Load() && counts_.size() == streams;
+    if (replaying_) {
+        INFO("Replaying stored read mappings from " << prefix_);
+        return;
+    }
+
+    // Stored paths become invalid as soon as we start overwriting them
+    fs::remove_if_exists(info_file());
+    counts_.assign(streams, NOT_PROCESSED);
+}
+
+void MappingPathCache::Finish() {
+    if (replaying_ ||
+        std::count(counts_.begin(), counts_.end(), NOT_PROCESSED))
+        return;
+
+    Save();
+}
+
+void MappingPathCache::Remove(const std::string &prefix) {
+    fs::remove_if_exists(prefix + ".mpc");
+    for (size_t stream = 0; fs::check_existence(prefix + "_" + std::to_string(stream) + ".mpc"); ++stream)
+        fs::remove_if_exists(prefix + "_" + std::to_string(stream) + ".mpc");
+}
+
+bool MappingPathCache::Load() {
+    std::ifstream file(info_file(), std::ios::binary);
+    if (!file)
+        return false;
+
+    io::binary::BinIStream str(file);
+    uint64_t version, fingerprint;
+    str >> version >> fingerprint;
+    if (!str || version != CACHE_VERSION || fingerprint != fingerprint_) {
+        INFO("Stored read mappings from " << prefix_ << " are outdated");
+        return false;
+    }
+
+    str >> counts_;
+    return (bool)str;
+}
+
+void MappingPathCache::Save() const {
+    std::ofstream file(info_file(), std::ios::binary);
+    io::binary::BinOStream str(file);
+    str << CACHE_VERSION << fingerprint_ << counts_;
+    VERIFY_MSG(str, "Cannot save mapping cache " << info_file());
+}
+
+}
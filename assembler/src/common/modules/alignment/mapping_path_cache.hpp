@@ -0,0 +1,105 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/paths/mapping_path.hpp"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace debruijn_graph {
+
+using omnigraph::MappingPath;
+using omnigraph::MappingRange;
+
+/**
+ * Hash of the graph topology, edge ids and edge sequences. Mappings obtained
+ * for the graphs with equal fingerprints are interchangeable.
+ */
+uint64_t GraphFingerprint(const Graph &g);
+
+/**
+ * On-disk storage of the mapping paths of library reads. Paths are stored per
+ * read stream in the order the reads are read, so the stages processing the
+ * same streams over the same graph may replay them instead of mapping the
+ * reads once again. Stored paths are discarded as soon as the graph changes.
+ */
+class MappingPathCache {
+  public:
+    /**
+     * Provides the paths of the reads of a single stream.
+     */
+    class Cursor {
+      public:
+        Cursor(MappingPathCache &cache, size_t stream);
+        ~Cursor();
+
+        /**
+         * Returns the next stored path when replaying, otherwise obtains
+         * the path with map() and stores it.
+         */
+        template<class MapF>
+        MappingPath<EdgeId> Get(const MapF &map) {
+            count_ += 1;
+            if (cache_.replaying_)
+                return Read();
+
+            MappingPath<EdgeId> path = map();
+            Write(path);
+            return path;
+        }
+
+      private:
+        MappingPath<EdgeId> Read();
+        void Write(const MappingPath<EdgeId> &path);
+
+        MappingPathCache &cache_;
+        size_t stream_;
+        size_t count_;
+        std::fstream file_;
+    };
+
+    MappingPathCache(const std::string &prefix, const Graph &g);
+
+    /**
+     * Prepares processing of the given number of streams. Stored paths are
+     * replayed if they were obtained for the same graph and streams, otherwise
+     * the new ones are recorded.
+     */
+    void Start(size_t streams);
+
+    /**
+     * Completes processing. The recorded paths become available for replaying
+     * only if all the streams were processed.
+     */
+    void Finish();
+
+    bool replaying() const { return replaying_; }
+
+    /**
+     * Removes the paths stored with the given prefix.
+     */
+    static void Remove(const std::string &prefix);
+
+  private:
+    std::string stream_file(size_t stream) const;
+    std::string info_file() const;
+
+    bool Load();
+    void Save() const;
+
+    std::string prefix_;
+    uint64_t fingerprint_;
+    bool replaying_;
+    // Number of reads in every stream
+    std::vector<size_t> counts_;
+};
+
+}
@@ -0,0 +1,374 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "sequence_mapper.hpp"
+
+#include "adt/cyclichash.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <deque>
+#include <vector>
+
+namespace debruijn_graph {
+
+namespace minimizers {
+
+// Rolling hash of the consecutive k-mers of a sequence
+class KMerHasher {
+    struct SequenceView {
+        const Sequence &s;
+        size_t pos;
+
+        size_t size() const { return s.size() - pos; }
+        rolling_hash::chartype operator[](size_t i) const { return s[pos + i]; }
+    };
+
+public:
+    explicit KMerHasher(unsigned k)
+            : k_(k), hasher_(k) {}
+
+    // Hash of the k-mer starting at pos
+    rolling_hash::digest hash(const Sequence &s, size_t pos) const {
+        return hasher_(SequenceView{s, pos});
+    }
+
+    // Hash of the k-mer starting at pos + 1 given the one of the k-mer at pos
+    rolling_hash::digest update(const Sequence &s, size_t pos, rolling_hash::digest h) const {
+        return hasher_.hash_update(h, s[pos], s[pos + k_]);
+    }
+
+    // Cyclic hashes of the overlapping k-mers are poorly distributed in the
+    // low bits, so they are mixed before being compared
+    static uint64_t key(rolling_hash::digest h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+private:
+    unsigned k_;
+    rolling_hash::CyclicHash<rolling_hash::NDNASeqHash> hasher_;
+};
+
+// Minimum over the sliding window, the leftmost one among the equal keys
+class SlidingMinimum {
+public:
+    void push(uint64_t key, size_t pos) {
+        while (!q_.empty() && q_.back().first > key)
+            q_.pop_back();
+        q_.emplace_back(key, pos);
+    }
+
+    void pop_before(size_t pos) {
+        while (!q_.empty() && q_.front().second < pos)
+            q_.pop_front();
+    }
+
+    const std::pair<uint64_t, size_t> &min() const { return q_.front(); }
+
+private:
+    std::deque<std::pair<uint64_t, size_t>> q_;
+};
+
+// Calls f(pos, key) for the minimizers of all windows of w consecutive k-mers
+// of the sequence in the increasing order of positions. The windows truncated
+// by the sequence ends are included, so the minimizers of a window spanning
+// several edges are among the minimizers of these edges.
+template<class F>
+void ForEachMinimizer(const Sequence &s, const KMerHasher &hasher, unsigned k, unsigned w, F f) {
+    if (s.size() < k)
+        return;
+
+    size_t kmers = s.size() - k + 1;
+    SlidingMinimum window;
+    size_t last = -1ull;
+    rolling_hash::digest h = hasher.hash(s, 0);
+    for (size_t i = 0; i < kmers + w - 1; ++i) {
+        if (i < kmers) {
+            if (i)
+                h = hasher.update(s, i - 1, h);
+            window.push(KMerHasher::key(h), i);
+        }
+        if (i + 1 >= w)
+            window.pop_before(i + 1 - w);
+
+        const auto &m = window.min();
+        if (m.second != last) {
+            f(m.second, m.first);
+            last = m.second;
+        }
+    }
+}
+
+}
+
+/**
+ * @brief  Positions of the (k+1)-mers sampled from the graph edges (both conjugates) as window minimizers.
+ */
+template<class Graph>
+class MinimizerIndex {
+public:
+    typedef typename Graph::EdgeId EdgeId;
+
+    struct Position {
+        EdgeId edge;
+        size_t offset;
+    };
+
+    MinimizerIndex(const Graph &g, unsigned window = 10)
+            : g_(g), k_(unsigned(g.k() + 1)), window_(window), hasher_(k_) {
+        VERIFY(window_ > 0);
+    }
+
+    void Refill() {
+        map_.clear();
+
+        std::vector<EdgeId> edges(g_.e_size());
+        std::copy(g_.e_begin(), g_.e_end(), edges.begin());
+
+        std::vector<std::vector<std::pair<uint64_t, Position>>> buffers(omp_get_max_threads());
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            auto &buffer = buffers[omp_get_thread_num()];
+            EdgeId e = edges[i];
+            minimizers::ForEachMinimizer(g_.EdgeNucls(e), hasher_, k_, window_,
+                                         [&](size_t pos, uint64_t key) {
+                                             buffer.push_back({key, Position{e, pos}});
+                                         });
+        }
+
+        size_t total = 0;
+        for (const auto &buffer : buffers)
+            total += buffer.size();
+        map_.reserve(total);
+        // Keys colliding with the different k-mers are verified by the mapper, so keeping one of them is safe
+        for (auto &buffer : buffers) {
+            map_.insert(buffer.begin(), buffer.end());
+            std::vector<std::pair<uint64_t, Position>>().swap(buffer);
+        }
+
+        INFO("Minimizer index contains " << map_.size() << " of " << total << " sampled positions");
+    }
+
+    const Position *find(uint64_t key) const {
+        auto it = map_.find(key);
+        return it == map_.end() ? nullptr : &it->second;
+    }
+
+    const Graph &g() const { return g_; }
+    unsigned k() const { return k_; }
+    unsigned window() const { return window_; }
+    const minimizers::KMerHasher &hasher() const { return hasher_; }
+    size_t size() const { return map_.size(); }
+
+private:
+    const Graph &g_;
+    unsigned k_;
+    unsigned window_;
+    minimizers::KMerHasher hasher_;
+    phmap::flat_hash_map<uint64_t, Position> map_;
+};
+
+/**
+ * @brief  Fast short read mapper looking up only the window minimizers of the read. Every verified hit
+ *         is extended along the graph nucleotide by nucleotide in both directions, the same way
+ *         BasicSequenceMapper threads the read, so the error-free reads are mapped identically.
+ *         Unlike BasicSequenceMapper, the k-mers removed by the graph simplification (KmerMapper)
+ *         are not substituted and the read parts shorter than a window between errors may be left unmapped.
+ */
+template<class Graph>
+class MinimizerSequenceMapper : public AbstractSequenceMapper<Graph> {
+    using AbstractSequenceMapper<Graph>::g_;
+
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+    typedef std::vector<MappingRange> RangeMappings;
+    typedef std::vector<std::pair<EdgeId, MappingRange>> Pieces;
+
+    const MinimizerIndex<Graph> &index_;
+    size_t k_;
+
+    bool Matches(const Sequence &s, size_t pos, EdgeId e, size_t offset) const {
+        if (offset >= g_.length(e))
+            return false;
+
+        const Sequence &nucls = g_.EdgeNucls(e);
+        for (size_t i = 0; i < k_; ++i) {
+            if (s[pos + i] != nucls[offset + i])
+                return false;
+        }
+        return true;
+    }
+
+    bool Next(EdgeId e, char c, EdgeId &next) const {
+        for (EdgeId out : g_.OutgoingEdges(g_.EdgeEnd(e))) {
+            if (g_.EdgeNucls(out)[k_ - 1] == c) {
+                next = out;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Prev(EdgeId e, char c, EdgeId &prev) const {
+        for (EdgeId in : g_.IncomingEdges(g_.EdgeStart(e))) {
+            if (g_.EdgeNucls(in)[g_.length(in) - 1] == c) {
+                prev = in;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Read k-mers starting at pos..., mapped to the edge k-mers starting at offset...
+    size_t ExtendRight(const Sequence &s, size_t pos, EdgeId e, size_t offset, Pieces &pieces) const {
+        size_t read_start = pos, edge_start = offset;
+        while (pos + k_ < s.size()) {
+            char c = s[pos + k_];
+            if (offset + 1 < g_.length(e)) {
+                if (g_.EdgeNucls(e)[offset + k_] != c)
+                    break;
+                ++offset;
+            } else {
+                EdgeId next;
+                if (!Next(e, c, next))
+                    break;
+                pieces.emplace_back(e, MappingRange(Range(read_start, pos + 1), Range(edge_start, offset + 1)));
+                e = next;
+                offset = 0;
+                read_start = pos + 1;
+                edge_start = 0;
+            }
+            ++pos;
+        }
+        pieces.emplace_back(e, MappingRange(Range(read_start, pos + 1), Range(edge_start, offset + 1)));
+        return pos + 1;
+    }
+
+    // The same to the left down to the read k-mer at bound, the pieces are collected in the reverse order
+    void ExtendLeft(const Sequence &s, size_t pos, EdgeId e, size_t offset, size_t bound, Pieces &pieces) const {
+        size_t read_end = pos + 1, edge_end = offset + 1;
+        while (pos > bound) {
+            char c = s[pos - 1];
+            if (offset > 0) {
+                if (g_.EdgeNucls(e)[offset - 1] != c)
+                    break;
+                --offset;
+            } else {
+                EdgeId prev;
+                if (!Prev(e, c, prev))
+                    break;
+                pieces.emplace_back(e, MappingRange(Range(pos, read_end), Range(offset, edge_end)));
+                e = prev;
+                offset = g_.length(prev) - 1;
+                read_end = pos;
+                edge_end = offset + 1;
+            }
+            --pos;
+        }
+        pieces.emplace_back(e, MappingRange(Range(pos, read_end), Range(offset, edge_end)));
+    }
+
+    static void Append(EdgeId e, const MappingRange &range,
+                       std::vector<EdgeId> &passed, RangeMappings &range_mappings) {
+        if (!passed.empty() && passed.back() == e &&
+            range_mappings.back().initial_range.end_pos == range.initial_range.start_pos &&
+            range_mappings.back().mapped_range.end_pos == range.mapped_range.start_pos) {
+            range_mappings.back().initial_range.end_pos = range.initial_range.end_pos;
+            range_mappings.back().mapped_range.end_pos = range.mapped_range.end_pos;
+            return;
+        }
+
+        passed.push_back(e);
+        range_mappings.push_back(range);
+    }
+
+    // Maps the read around the hit of its k-mer at pos, the read k-mers before bound are already processed.
+    // Returns the position after the last mapped k-mer or pos if the hit is false.
+    size_t MapAround(const Sequence &s, size_t pos, uint64_t key, size_t bound,
+                     std::vector<EdgeId> &passed, RangeMappings &range_mappings) const {
+        const auto *hit = index_.find(key);
+        if (!hit || !Matches(s, pos, hit->edge, hit->offset))
+            return pos;
+
+        Pieces left, right;
+        ExtendLeft(s, pos, hit->edge, hit->offset, bound, left);
+        size_t end = ExtendRight(s, pos, hit->edge, hit->offset, right);
+
+        // Both start with the piece of the hit k-mer
+        right.front().second.initial_range.start_pos = left.front().second.initial_range.start_pos;
+        right.front().second.mapped_range.start_pos = left.front().second.mapped_range.start_pos;
+        for (size_t i = left.size() - 1; i > 0; --i)
+            Append(left[i].first, left[i].second, passed, range_mappings);
+        for (const auto &piece : right)
+            Append(piece.first, piece.second, passed, range_mappings);
+
+        return end;
+    }
+
+public:
+    MinimizerSequenceMapper(const Graph &g, const MinimizerIndex<Graph> &index)
+            : AbstractSequenceMapper<Graph>(g), index_(index), k_(g.k() + 1) {
+        VERIFY(&index.g() == &g);
+    }
+
+    MappingPath<EdgeId> MapSequence(const Sequence &s,
+                                    bool only_simple = false) const override {
+        if (s.size() < k_)
+            return MappingPath<EdgeId>();
+
+        std::vector<EdgeId> passed;
+        RangeMappings range_mappings;
+
+        const auto &hasher = index_.hasher();
+        size_t kmers = s.size() - k_ + 1, w = index_.window();
+        size_t covered = 0;
+        // Windows are restarted after every mapped part, so the read threaded along
+        // the graph is hashed only up to its first hit
+        for (size_t start = 0; start < kmers; ) {
+            minimizers::SlidingMinimum window;
+            size_t last = -1ull, next = kmers;
+            rolling_hash::digest h = hasher.hash(s, start);
+            for (size_t i = start; i < kmers; ++i) {
+                if (i > start)
+                    h = hasher.update(s, i - 1, h);
+                window.push(minimizers::KMerHasher::key(h), i);
+                if (i + 1 < start + w && i + 1 < kmers)
+                    continue;
+                if (i + 1 >= start + w)
+                    window.pop_before(i + 1 - w);
+
+                auto m = window.min();
+                if (m.second == last)
+                    continue;
+                last = m.second;
+
+                size_t end = MapAround(s, m.second, m.first, covered, passed, range_mappings);
+                if (end > m.second) {
+                    covered = next = end;
+                    break;
+                }
+            }
+            start = next;
+        }
+
+        if (only_simple && passed.size() > 1)
+            return MappingPath<EdgeId>();
+
+        return MappingPath<EdgeId>(passed, range_mappings);
+    }
+
+    DECL_LOGGER("MinimizerSequenceMapper");
+};
+
+}
@@ -0,0 +1,152 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace sensitive_aligner {
+
+/**
+ * @brief  Caches the bounded Dijkstra runs by their start vertex, so the run is shared by all the targets
+ *         reached from the same vertex. The cache is split into the shards with their own locks and keeps at
+ *         most the given number of vertex distances in total, the least recently used runs are evicted.
+ */
+class DistanceCache {
+public:
+    typedef debruijn_graph::Graph Graph;
+    typedef debruijn_graph::VertexId VertexId;
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        // Lookups waiting for the shard lock
+        size_t contended = 0;
+    };
+
+    DistanceCache(const Graph &g, size_t max_path, size_t max_vertices, size_t capacity)
+            : g_(g), max_path_(max_path), max_vertices_(max_vertices),
+              shard_capacity_(std::max<size_t>(1, capacity / SHARDS)),
+              shards_(SHARDS) {}
+
+    /**
+     * @brief  Returns the distance from start_v to end_v or size_t(-1) if end_v is not reached by the bounded
+     *         Dijkstra. The computed run is stored only if update_cache is set.
+     */
+    size_t GetDistance(VertexId start_v, VertexId end_v, bool update_cache = true) const {
+        Shard &shard = shards_[std::hash<VertexId>()(start_v) % SHARDS];
+        std::shared_ptr<const Distances> distances = Find(shard, start_v);
+        if (!distances) {
+            distances = Run(start_v);
+            if (update_cache)
+                Insert(shard, start_v, distances);
+        }
+
+        auto it = std::lower_bound(distances->begin(), distances->end(), end_v,
+                                   [](const Distances::value_type &entry, VertexId v) { return entry.first < v; });
+        return it != distances->end() && it->first == end_v ? it->second : size_t(-1);
+    }
+
+    Stats stats() const {
+        Stats res;
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            res.hits += shard.stats.hits;
+            res.misses += shard.stats.misses;
+            res.evictions += shard.stats.evictions;
+            res.contended += shard.stats.contended;
+        }
+        return res;
+    }
+
+private:
+    static const size_t SHARDS = 64;
+
+    // Reached vertices sorted by their ids
+    typedef std::vector<std::pair<VertexId, size_t>> Distances;
+
+    struct Entry {
+        VertexId start;
+        std::shared_ptr<const Distances> distances;
+    };
+    typedef std::list<Entry> Entries;
+
+    struct Shard {
+        std::mutex mutex;
+        // Most recently used runs go first
+        Entries lru;
+        std::unordered_map<VertexId, Entries::iterator> index;
+        size_t size = 0;
+        Stats stats;
+    };
+
+    static std::unique_lock<std::mutex> Lock(Shard &shard) {
+        std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            lock.lock();
+            shard.stats.contended += 1;
+        }
+        return lock;
+    }
+
+    std::shared_ptr<const Distances> Find(Shard &shard, VertexId start_v) const {
+        auto lock = Lock(shard);
+        auto it = shard.index.find(start_v);
+        if (it == shard.index.end()) {
+            shard.stats.misses += 1;
+            return nullptr;
+        }
+
+        shard.stats.hits += 1;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->distances;
+    }
+
+    void Insert(Shard &shard, VertexId start_v, std::shared_ptr<const Distances> distances) const {
+        auto lock = Lock(shard);
+        // The run might be done concurrently by another thread
+        if (shard.index.count(start_v))
+            return;
+
+        shard.size += distances->size();
+        shard.lru.push_front({ start_v, std::move(distances) });
+        shard.index.emplace(start_v, shard.lru.begin());
+        while (shard.size > shard_capacity_ && shard.lru.size() > 1) {
+            const Entry &last = shard.lru.back();
+            shard.size -= last.distances->size();
+            shard.index.erase(last.start);
+            shard.lru.pop_back();
+            shard.stats.evictions += 1;
+        }
+    }
+
+    std::shared_ptr<const Distances> Run(VertexId start_v) const {
+        auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g_, max_path_, max_vertices_);
+        dijkstra.Run(start_v);
+
+        auto res = std::make_shared<Distances>();
+        for (VertexId v : dijkstra.ReachedVertices())
+            res->emplace_back(v, dijkstra.GetDistance(v));
+        return res;
+    }
+
+    const Graph &g_;
+    const size_t max_path_;
+    const size_t max_vertices_;
+    const size_t shard_capacity_;
+    mutable std::vector<Shard> shards_;
+};
+
+}
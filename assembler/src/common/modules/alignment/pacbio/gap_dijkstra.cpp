@@ -30,59 +30,135 @@ bool DijkstraGraphSequenceBase::IsBetter(int seq_ind, int ed) {
     return false;
 }
 
+uint32_t DijkstraGraphSequenceBase::StateId(const QueueState &state) const {
+    auto it = state_ids_.find(state);
+    return it == state_ids_.end() ? NO_STATE : it->second;
+}
+
+int DijkstraGraphSequenceBase::Score(const QueueState &state) const {
+    uint32_t id = StateId(state);
+    return id == NO_STATE ? 0 : states_[id].score;
+}
+
+void DijkstraGraphSequenceBase::Push(uint32_t id) {
+    const StateInfo &info = states_[id];
+    size_t bucket = (size_t) info.score;
+    if (bucket >= buckets_.size()) {
+        buckets_.resize(bucket + 1);
+    }
+    auto &heap = buckets_[bucket];
+    heap.emplace_back(info.state, id);
+    push_heap(heap.begin(), heap.end(), [](const QueueEntry &a, const QueueEntry &b) { return b.first < a.first; });
+    min_bucket_ = min(min_bucket_, bucket);
+}
+
+uint32_t DijkstraGraphSequenceBase::Pop() {
+    for (; min_bucket_ < buckets_.size(); ++ min_bucket_) {
+        auto &heap = buckets_[min_bucket_];
+        while (heap.size() > 0) {
+            pop_heap(heap.begin(), heap.end(), [](const QueueEntry &a, const QueueEntry &b) { return b.first < a.first; });
+            uint32_t id = heap.back().second;
+            heap.pop_back();
+            StateInfo &info = states_[id];
+            if (info.queued && info.score == (int) min_bucket_) {
+                info.queued = false;
+                -- queued_;
+                return id;
+            }
+        }
+    }
+    VERIFY_MSG(false, "Pop from the empty queue");
+    return NO_STATE;
+}
+
 void DijkstraGraphSequenceBase::Update(const QueueState &state, const QueueState &prev_state, int score) {
-    if (visited_.count(state) > 0) {
-        if (visited_[state] >= score) {
+    uint32_t id = StateId(state);
+    if (id != NO_STATE) {
+        StateInfo &info = states_[id];
+        if (info.score >= score) {
             ++ updates_;
-            q_.erase(make_pair(visited_[state], state));
+            // The entry with the same score is still in its bucket
+            bool pushed = info.queued && info.score == score;
+            if (info.queued) {
+                info.queued = false;
+                -- queued_;
+            }
             if (IsBetter(state.i, score)) {
-                q_.insert(make_pair(score, state));
-                visited_[state] = score;
-                prev_states_[state] = prev_state;
+                info.score = score;
+                info.prev = prev_state.empty() ? NO_STATE : StateId(prev_state);
+                info.queued = true;
+                ++ queued_;
+                if (!pushed) {
+                    Push(id);
+                }
             }
         }
     } else {
         if (IsBetter(state.i, score)) {
             ++ updates_;
-            visited_.insert(make_pair(state, score));
-            prev_states_.insert(make_pair(state, prev_state));
-            q_.insert(make_pair(score, state));
+            id = (uint32_t) states_.size();
+            states_.push_back({state, score, prev_state.empty() ? NO_STATE : StateId(prev_state), true});
+            state_ids_.emplace(state, id);
+            ++ queued_;
+            Push(id);
         }
     }
 }
 
+const std::string &DijkstraGraphSequenceBase::EdgeString(EdgeId e) {
+    auto it = edge_nucls_.find(e);
+    if (it == edge_nucls_.end()) {
+        it = edge_nucls_.emplace(e, g_.EdgeNucls(e).str()).first;
+    }
+    return it->second;
+}
+
+const MyersAligner::Profile &DijkstraGraphSequenceBase::StateProfile(const GraphState &gs) {
+    if (gs.start_pos != 0 || gs.end_pos != (int) g_.length(gs.e)) {
+        string edge_str = g_.EdgeNucls(gs.e).Subseq(gs.start_pos, gs.end_pos).str();
+        state_profile_.Build(edge_str.data(), (int) edge_str.size());
+        return state_profile_;
+    }
+    auto it = edge_profiles_.find(gs.e);
+    if (it == edge_profiles_.end()) {
+        string edge_str = g_.EdgeNucls(gs.e).Subseq(0, gs.end_pos).str();
+        it = edge_profiles_.emplace(gs.e, MyersAligner::Profile(edge_str.data(), (int) edge_str.size())).first;
+    }
+    return it->second;
+}
+
 void DijkstraGraphSequenceBase::AddNewEdge(const GraphState &gs, const QueueState &prev_state, int ed) {
-    string edge_str = g_.EdgeNucls(gs.e).Subseq(gs.start_pos, gs.end_pos).str();
-    if (0 == edge_str.size()) {
+    int edge_len = gs.end_pos - gs.start_pos;
+    if (0 == edge_len) {
         QueueState state(gs, prev_state.i);
         Update(state, prev_state,  ed);
         return;
     }
     if (path_max_length_ - ed >= 0) {
-        if (path_max_length_ - ed >= (int) edge_str.size()) {
+        if (path_max_length_ - ed >= edge_len) {
             QueueState state(gs, prev_state.i);
-            Update(state, prev_state,  ed + (int) edge_str.size());
+            Update(state, prev_state,  ed + edge_len);
         }
     }
     if (ss_.size() - prev_state.i > 0) {
         // len - is a maximum length of substring to align on current edge
         int len = min( (int) g_.length(gs.e) - gs.start_pos + path_max_length_, // length of current edge + maximum insertion size
                        (int) ss_.size() - prev_state.i  ); // length of suffix left
-        string seq_str = ss_.substr(prev_state.i, len);
-        vector<int> positions;
-        vector<int> scores;
         if (path_max_length_ - ed >= 0) {
-            SHWDistanceExtended(seq_str, edge_str, path_max_length_ - ed, positions, scores);
+            positions_.clear();
+            scores_.clear();
+            aligner_.Align(StateProfile(gs), ss_.data() + prev_state.i, len, path_max_length_ - ed,
+                           positions_, scores_);
             int prev_score = numeric_limits<int>::max();
-            for (size_t i = 0; i < positions.size(); ++ i) {
-                if (positions[i] >= 0 && scores[i] >= 0) {
-                    int next_score = i + 1 >= positions.size() || positions[i + 1] < 0 || scores[i + 1] < 0 ?
-                                     numeric_limits<int>::max() : scores[i + 1];
-                    if (scores[i] <= prev_score && scores[i] <= next_score) {
-                        QueueState state(gs, prev_state.i + positions[i] + 1);
-                        Update(state, prev_state, ed + scores[i]);
+            for (size_t i = 0; i < positions_.size(); ++ i) {
+                if (positions_[i] >= 0 && scores_[i] >= 0) {
+                    int next_score = i + 1 >= positions_.size() || positions_[i + 1] < 0 || scores_[i + 1] < 0 ?
+                                     numeric_limits<int>::max() : scores_[i + 1];
+                    if (scores_[i] <= prev_score && scores_[i] <= next_score) {
+                        QueueState state(gs, prev_state.i + positions_[i] + 1);
+                        Update(state, prev_state, ed + scores_[i]);
                     }
-                    prev_score = scores[i];
+                    prev_score = scores_[i];
                 } else {
                     prev_score = numeric_limits<int>::max();
                 }
@@ -92,7 +168,7 @@ void DijkstraGraphSequenceBase::AddNewEdge(const GraphState &gs, const QueueStat
 }
 
 bool DijkstraGraphSequenceBase::QueueLimitsExceeded(size_t iter) {
-    return_code_.queue_limit = q_.size() > queue_limit_;
+    return_code_.queue_limit = queued_ > queue_limit_;
     return_code_.iter_limit = iter > iter_limit_;
     return return_code_.status;
 }
@@ -102,15 +178,15 @@ bool DijkstraGraphSequenceBase::RunDijkstra() {
     size_t iter = 0;
     QueueState cur_state;
     int ed = 0;
-    while (q_.size() > 0 &&
+    while (queued_ > 0 &&
             !QueueLimitsExceeded(iter) &&
             ed <= path_max_length_ &&
             updates_ < gap_cfg_.updates_limit) {
-        cur_state = q_.begin()->second;
-        ed = visited_[cur_state];
+        const StateInfo &info = states_[Pop()];
+        cur_state = info.state;
+        ed = info.score;
         ++ iter;
-        q_.erase(q_.begin());
-        if (visited_.count(end_qstate_) > 0) {
+        if (StateId(end_qstate_) != NO_STATE) {
             found_path = true;
         }
         if (IsEndPosition(cur_state)) {
@@ -135,14 +211,18 @@ void DijkstraGraphSequenceBase::CloseGap() {
     }
     if (found_path) {
         QueueState state(end_qstate_);
+        uint32_t id = StateId(state);
         while (!state.empty()) {
-            min_score_ = visited_[end_qstate_];
-            int start_edge = prev_states_[state].i;
+            min_score_ = Score(end_qstate_);
+            uint32_t prev = id == NO_STATE ? NO_STATE : states_[id].prev;
+            QueueState prev_state = prev == NO_STATE ? QueueState() : states_[prev].state;
+            int start_edge = prev_state.i;
             int end_edge =  state.i;
             mapping_path_.push_back(state.gs.e,
                                     omnigraph::MappingRange(Range(start_edge, end_edge),
                                             Range(state.gs.start_pos, state.gs.end_pos) ));
-            state = prev_states_[state];
+            state = prev_state;
+            id = prev;
         }
         mapping_path_.reverse();
     }
@@ -195,10 +275,10 @@ bool DijkstraEndsReconstructor::AddState(const QueueState &cur_state, EdgeId e,
     VERIFY(ss_.size() >= (size_t) cur_state.i)
     size_t remaining = ss_.size() - cur_state.i;
     if (g_.length(e) + g_.k() + path_max_length_ - ed > remaining && path_max_length_ - ed >= 0) {
-        string seq_str = ss_.substr(cur_state.i);
-        string edge_str = g_.EdgeNucls(e).str();
+        const string &edge_str = EdgeString(e);
         int position = -1;
-        int score = SHWDistance(seq_str, edge_str, path_max_length_ - ed, position);
+        int score = SHWDistance(ss_.data() + cur_state.i, (int) remaining, edge_str.data(), (int) edge_str.size(),
+                                path_max_length_ - ed, position);
         if (score != numeric_limits<int>::max()) {
             path_max_length_ = min(path_max_length_, ed + score);
             QueueState state(GraphState(e, 0, position + 1), (int) ss_.size());
@@ -8,10 +8,13 @@
 
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/paths/mapping_path.hpp"
+#include "modules/alignment/pacbio/myers_aligner.hpp"
 
 #include "sequence/sequence_tools.hpp"
 #include "utils/perf/perfcounter.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace sensitive_aligner {
 
 using debruijn_graph::EdgeId;
@@ -158,7 +161,9 @@ class DijkstraGraphSequenceBase {
         , min_score_(std::numeric_limits<int>::max())
         , queue_limit_(gap_cfg_.queue_limit)
         , iter_limit_(gap_cfg_.iteration_limit)
-        , updates_(0) {
+        , updates_(0)
+        , queued_(0)
+        , min_bucket_(0) {
         best_ed_.resize(ss_.size(), path_max_length_);
         AddNewEdge(GraphState(start_e_, start_p_, (int) g_.length(start_e_)), QueueState(), 0);
     }
@@ -230,18 +235,53 @@ class DijkstraGraphSequenceBase {
     int min_score_;
     DijkstraReturnCode return_code_;
 
+    // Whole nucleotide string of the edge, converted once per run
+    const std::string &EdgeString(EdgeId e);
+
+    // Profile of the graph state nucleotides, the ones of the whole edges are built once per run
+    const MyersAligner::Profile &StateProfile(const GraphState &gs);
+
   private:
     static const int SHORT_SEQ_LENGTH = 100;
     static const int ED_DEVIATION = 20;
+    static const uint32_t NO_STATE = uint32_t(-1);
+
+    struct StateInfo {
+        QueueState state;
+        int score;
+        uint32_t prev;
+        // The state is in the queue with its current score
+        bool queued;
+    };
+
+    typedef std::pair<QueueState, uint32_t> QueueEntry;
+
+    uint32_t StateId(const QueueState &state) const;
+
+    void Push(uint32_t id);
+
+    uint32_t Pop();
+
+    int Score(const QueueState &state) const;
 
-    std::set<std::pair<int, QueueState>> q_;
-    std::unordered_map<QueueState, int> visited_;
-    std::unordered_map<QueueState, QueueState> prev_states_;
+    // All the reached states, they are referred by the indices in the pool
+    std::vector<StateInfo> states_;
+    phmap::flat_hash_map<QueueState, uint32_t, std::hash<QueueState>> state_ids_;
+    // Integer scores are bounded by the path_max_length_, so the queue is bucketed by the score. Every bucket is a
+    // heap ordered as QueueState, the entries of the states updated afterwards are skipped on the extraction.
+    std::vector<std::vector<QueueEntry>> buckets_;
+    phmap::flat_hash_map<EdgeId, std::string> edge_nucls_;
+    phmap::flat_hash_map<EdgeId, MyersAligner::Profile> edge_profiles_;
+    MyersAligner::Profile state_profile_;
+    MyersAligner aligner_;
     std::vector<int> best_ed_;
+    std::vector<int> positions_, scores_;
 
     const size_t queue_limit_;
     const size_t iter_limit_;
     size_t updates_;
+    size_t queued_;
+    size_t min_bucket_;
 };
 
 
@@ -26,6 +26,8 @@ struct GAlignerConfig {
     alignment::BWAIndex::AlignmentMode data_type = alignment::BWAIndex::AlignmentMode::Default; // pacbio, nanopore, 16S
     std::string output_format = "tsv"; // default: tsv
     bool restore_ends = false;
+    // Write the alignments in the order of the input reads
+    bool ordered_output = false;
 
     //path construction
     debruijn_graph::config::pacbio_processor pb;
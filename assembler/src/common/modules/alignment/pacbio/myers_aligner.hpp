@@ -0,0 +1,215 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sensitive_aligner {
+
+/**
+ * @brief  Myers' bit-parallel banded alignment of the nucleotide query against the prefixes of the target, the
+ *         query is advanced in 64-row blocks per target column. Reproduces the edlib EDLIB_MODE_SHW_EXTENDED
+ *         results (see SHWDistanceExtended), but the query profile is built once and reused for all the targets,
+ *         and no memory is allocated per alignment.
+ */
+class MyersAligner {
+public:
+    typedef uint64_t Word;
+
+    // Query profile, the bits of the rows matching the symbol per block. The query is padded up to the block
+    // boundary with the rows matching everything.
+    class Profile {
+    public:
+        Profile() = default;
+
+        Profile(const char *query, int len) {
+            Build(query, len);
+        }
+
+        void Build(const char *query, int len) {
+            VERIFY(len > 0);
+            len_ = len;
+            blocks_ = (len + WORD_SIZE - 1) / WORD_SIZE;
+            peq_.assign(SYMBOLS * blocks_, 0);
+            for (unsigned symbol = 0; symbol < SYMBOLS; ++symbol) {
+                for (int b = 0; b < blocks_; ++b) {
+                    Word &eq = peq_[symbol * blocks_ + b];
+                    for (int r = (b + 1) * WORD_SIZE - 1; r >= b * WORD_SIZE; --r) {
+                        eq <<= 1;
+                        if (r >= len || (symbol != OTHER && Symbol(query[r]) == symbol))
+                            eq += 1;
+                    }
+                }
+            }
+        }
+
+        int length() const { return len_; }
+        int blocks() const { return blocks_; }
+        const Word *eq(unsigned symbol) const { return peq_.data() + symbol * blocks_; }
+
+    private:
+        int len_ = 0;
+        int blocks_ = 0;
+        std::vector<Word> peq_;
+    };
+
+    /**
+     * @brief  Appends the target positions where the whole query ends with at most max_score edits and the
+     *         corresponding scores.
+     */
+    void Align(const Profile &query, const char *target, int target_len, int max_score,
+               std::vector<int> &positions, std::vector<int> &scores) {
+        VERIFY(max_score >= 0);
+        const int max_blocks = query.blocks();
+        const int W = max_blocks * WORD_SIZE - query.length();
+        const int k = max_score;
+
+        int first_block = 0;
+        int last_block = std::min((k + 1 + WORD_SIZE - 1) / WORD_SIZE, max_blocks) - 1;
+        blocks_.resize(max_blocks);
+        Block *bl = blocks_.data();
+        for (int b = 0; b <= last_block; ++b, ++bl) {
+            bl->score = (b + 1) * WORD_SIZE;
+            bl->P = Word(-1);
+            bl->M = 0;
+        }
+
+        for (int c = 0; c < target_len; ++c) {
+            const Word *eq = query.eq(Symbol(target[c]));
+
+            int hout = 1;
+            bl = blocks_.data() + first_block;
+            eq += first_block;
+            for (int b = first_block; b <= last_block; ++b, ++bl, ++eq) {
+                hout = AdvanceBlock(bl->P, bl->M, *eq, hout, bl->P, bl->M);
+                bl->score += hout;
+            }
+            --bl; --eq;
+
+            // Ukkonen band
+            if (last_block < max_blocks - 1 && bl->score - hout <= k &&
+                ((*(eq + 1) & 1) || hout < 0)) {
+                ++last_block; ++bl; ++eq;
+                bl->P = Word(-1);
+                bl->M = 0;
+                bl->score = (bl - 1)->score - hout + WORD_SIZE + AdvanceBlock(bl->P, bl->M, *eq, hout, bl->P, bl->M);
+            } else {
+                while (last_block >= first_block && bl->score >= k + WORD_SIZE) {
+                    --last_block; --bl; --eq;
+                }
+            }
+            if (c % STRONG_REDUCE_NUM == 0) {
+                while (last_block >= 0 && last_block >= first_block && AllCellsLarger(*bl, k)) {
+                    --last_block; --bl; --eq;
+                }
+            }
+            while (first_block <= last_block && blocks_[first_block].score >= k + WORD_SIZE)
+                ++first_block;
+            if (c % STRONG_REDUCE_NUM == 0) {
+                while (first_block <= last_block && AllCellsLarger(blocks_[first_block], k))
+                    ++first_block;
+            }
+
+            if (last_block < first_block)
+                return;
+
+            // The score of the last row is the one of the query end at column c - W
+            if (last_block == max_blocks - 1 && bl->score <= k) {
+                if (c - W >= 0) {
+                    positions.push_back(c - W);
+                    scores.push_back(bl->score);
+                }
+            }
+        }
+
+        if (last_block == max_blocks - 1) {
+            // Results for the last W columns come from the padding rows of the last column
+            int score = bl->score;
+            Word mask = HIGH_BIT;
+            for (int i = 0; i < W; ++i) {
+                if (bl->P & mask) score -= 1;
+                if (bl->M & mask) score += 1;
+                mask >>= 1;
+                if (score <= k && target_len - W + i >= 0) {
+                    positions.push_back(target_len - W + i);
+                    scores.push_back(score);
+                }
+            }
+        }
+    }
+
+private:
+    static const int WORD_SIZE = 64;
+    static const Word HIGH_BIT = Word(1) << (WORD_SIZE - 1);
+    static const int STRONG_REDUCE_NUM = 2048;
+    // A, C, G, T and the symbol matching only the padding
+    static const unsigned SYMBOLS = 5;
+    static const unsigned OTHER = 4;
+
+    struct Block {
+        Word P;
+        Word M;
+        // Score of the last cell of the block
+        int score;
+    };
+
+    static unsigned Symbol(char c) {
+        switch (c) {
+            case 'A': return 0;
+            case 'C': return 1;
+            case 'G': return 2;
+            case 'T': return 3;
+            default: return OTHER;
+        }
+    }
+
+    // Advance_Block of Myers, hin and hout are in {-1, 0, 1}
+    static int AdvanceBlock(Word Pv, Word Mv, Word Eq, int hin, Word &PvOut, Word &MvOut) {
+        Word hin_neg = Word(hin >> 2) & 1;
+
+        Word Xv = Eq | Mv;
+        Eq |= hin_neg;
+        Word Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+
+        Word Ph = Mv | ~(Xh | Pv);
+        Word Mh = Pv & Xh;
+
+        int hout = int((Ph & HIGH_BIT) >> (WORD_SIZE - 1));
+        hout -= int((Mh & HIGH_BIT) >> (WORD_SIZE - 1));
+
+        Ph <<= 1;
+        Mh <<= 1;
+        Mh |= hin_neg;
+        Ph |= Word((hin + 1) >> 1);
+
+        PvOut = Mh | ~(Xv | Ph);
+        MvOut = Ph & Xv;
+
+        return hout;
+    }
+
+    static bool AllCellsLarger(const Block &block, int k) {
+        int score = block.score;
+        Word mask = HIGH_BIT;
+        for (int i = 0; i < WORD_SIZE - 1; ++i) {
+            if (score <= k)
+                return false;
+            if (block.P & mask) score -= 1;
+            if (block.M & mask) score += 1;
+            mask >>= 1;
+        }
+        return score > k;
+    }
+
+    std::vector<Block> blocks_;
+};
+
+}
@@ -20,6 +20,7 @@
 
 #include "modules/alignment/pacbio/pacbio_read_structures.hpp"
 #include "modules/alignment/pacbio/gap_filler.hpp"
+#include "modules/alignment/pacbio/distance_cache.hpp"
 
 namespace sensitive_aligner {
 
@@ -40,7 +41,9 @@ class PacBioMappingIndex {
                        alignment::BWAIndex::AlignmentMode mode)
         : g_(g),
           pb_config_(pb_config),
-          bwa_mapper_(g, mode) {
+          bwa_mapper_(g, mode),
+          distance_cache_(g, pb_config.max_path_in_dijkstra, pb_config.max_vertex_in_dijkstra,
+                          pb_config.distance_cache_size) {
         DEBUG("PB Mapping Index construction started");
         DEBUG("Index constructed");
         read_count_ = 0;
@@ -50,6 +53,9 @@ class PacBioMappingIndex {
         if (pb_config_.rna_filtering) {
             INFO(rna_filtering_count_ << " times RNA alignmnent read filtering worked" );
         }
+        auto stats = distance_cache_.stats();
+        INFO("Distance cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+             << stats.evictions << " evictions, " << stats.contended << " contended lookups");
     }
     std::vector<std::vector<QualityRange>> GetChainingPaths(const io::SingleRead &read) const {
         std::vector<ColoredRange> ranged_colors = GetRangedColors(read);
@@ -94,8 +100,6 @@ class PacBioMappingIndex {
 
     static const size_t DISTANT_IN_GRAPH = 1000;
     static const size_t MAX_VERTICES_IN_DIJKSTRA_FILTERING = 500;
-    //presumably separate class for this and GetDistance
-    mutable std::map<std::pair<VertexId, VertexId>, size_t> distance_cashed_;
     size_t read_count_;
     
     mutable size_t rna_filtering_count_;
@@ -103,6 +107,7 @@ class PacBioMappingIndex {
     debruijn_graph::config::pacbio_processor pb_config_;
 
     alignment::BWAReadMapper<Graph> bwa_mapper_;
+    DistanceCache distance_cache_;
 
     bool similar(const MappingInstance &a, const MappingInstance &b, int a_len, int b_len) const {
         if (b.read_position < a.read_position) {
@@ -400,35 +405,7 @@ class PacBioMappingIndex {
 
     size_t GetDistance(VertexId start_v, VertexId end_v,
                        bool update_cache = true) const {
-        size_t result = size_t(-1);
-        auto vertex_pair = std::make_pair(start_v, end_v);
-        bool not_found;
-        auto distance_it = distance_cashed_.begin();
-        //FIXME should permit multiple readers
-        #pragma omp critical(pac_index)
-        {
-            distance_it = distance_cashed_.find(vertex_pair);
-            not_found = (distance_it == distance_cashed_.end());
-        }
-        if (not_found) {
-            omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra dijkstra(
-                omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_,
-                        pb_config_.max_path_in_dijkstra,
-                        pb_config_.max_vertex_in_dijkstra));
-            dijkstra.Run(start_v);
-            if (dijkstra.DistanceCounted(end_v)) {
-                result = dijkstra.GetDistance(end_v);
-            }
-            if (update_cache) {
-                #pragma omp critical(pac_index)
-                distance_cashed_.insert({vertex_pair, result});
-            }
-        } else {
-            TRACE("taking from cashed");
-            result = distance_it->second;
-        }
-
-        return result;
+        return distance_cache_.GetDistance(start_v, end_v, update_cache);
     }
 
     bool IsConsistent(const QualityRange &a,
@@ -42,13 +42,14 @@ void SequenceMapperNotifier::NotifyMergeBuffer(size_t ilib, size_t ithread) cons
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r,
                                                const SequenceMapperT& mapper,
+                                               MappingPathCache::Cursor *cursor,
                                                size_t ilib,
                                                size_t ithread) const
 {
     const Sequence& read1 = r.first().sequence();
     const Sequence& read2 = r.second().sequence();
-    MappingPath<EdgeId> path1 = mapper.MapSequence(read1);
-    MappingPath<EdgeId> path2 = mapper.MapSequence(read2);
+    MappingPath<EdgeId> path1 = Map(cursor, [&] { return mapper.MapSequence(read1); });
+    MappingPath<EdgeId> path2 = Map(cursor, [&] { return mapper.MapSequence(read2); });
     for (const auto& listener : listeners_[ilib]) {
         listener->ProcessPairedRead(ithread, r, path1, path2);
         listener->ProcessSingleRead(ithread, r.first(), path1);
@@ -59,11 +60,12 @@ void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r,
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedRead& r,
                                                const SequenceMapperT& mapper,
+                                               MappingPathCache::Cursor *cursor,
                                                size_t ilib,
                                                size_t ithread) const
 {
-    MappingPath<EdgeId> path1 = mapper.MapRead(r.first());
-    MappingPath<EdgeId> path2 = mapper.MapRead(r.second());
+    MappingPath<EdgeId> path1 = Map(cursor, [&] { return mapper.MapRead(r.first()); });
+    MappingPath<EdgeId> path2 = Map(cursor, [&] { return mapper.MapRead(r.second()); });
     for (const auto& listener : listeners_[ilib]) {
         listener->ProcessPairedRead(ithread, r, path1, path2);
         listener->ProcessSingleRead(ithread, r.first(), path1);
@@ -74,11 +76,12 @@ void SequenceMapperNotifier::NotifyProcessRead(const io::PairedRead& r,
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::SingleReadSeq& r,
                                                const SequenceMapperT& mapper,
+                                               MappingPathCache::Cursor *cursor,
                                                size_t ilib,
                                                size_t ithread) const
 {
     const Sequence& read = r.sequence();
-    MappingPath<EdgeId> path = mapper.MapSequence(read);
+    MappingPath<EdgeId> path = Map(cursor, [&] { return mapper.MapSequence(read); });
     for (const auto& listener : listeners_[ilib])
         listener->ProcessSingleRead(ithread, r, path);
 }
@@ -86,10 +89,11 @@ void SequenceMapperNotifier::NotifyProcessRead(const io::SingleReadSeq& r,
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::SingleRead& r,
                                                const SequenceMapperT& mapper,
+                                               MappingPathCache::Cursor *cursor,
                                                size_t ilib,
                                                size_t ithread) const
 {
-    MappingPath<EdgeId> path = mapper.MapRead(r);
+    MappingPath<EdgeId> path = Map(cursor, [&] { return mapper.MapRead(r); });
     for (const auto& listener : listeners_[ilib])
         listener->ProcessSingleRead(ithread, r, path);
 }
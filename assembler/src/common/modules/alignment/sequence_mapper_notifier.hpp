@@ -9,6 +9,7 @@
 #define SEQUENCE_MAPPER_NOTIFIER_HPP_
 
 #include "sequence_mapper.hpp"
+#include "mapping_path_cache.hpp"
 
 #include "assembly_graph/paths/mapping_path.hpp"
 #include "assembly_graph/core/graph.hpp"
@@ -17,6 +18,7 @@
 
 #include "utils/perf/timetracer.hpp"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -54,12 +56,33 @@ public:
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
+        ProcessLibrary(streams, lib_index, mapper, nullptr, threads_count);
+    }
+
+    /**
+     * Same as above, but the mapping paths are replayed from the cache when
+     * possible (and recorded into it otherwise).
+     */
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper,
+                        MappingPathCache &cache, size_t threads_count = 0) {
+        ProcessLibrary(streams, lib_index, mapper, &cache, threads_count);
+    }
+
+private:
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper,
+                        MappingPathCache *cache, size_t threads_count) {
         std::string lib_str = std::to_string(lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
         if (threads_count == 0)
             threads_count = streams.size();
 
         streams.reset();
+        if (cache)
+            cache->Start(streams.size());
         NotifyStartProcessLibrary(lib_index, threads_count);
         size_t counter = 0, n = 15;
 
@@ -68,6 +91,9 @@ public:
             size_t size = 0;
             ReadType r;
             auto& stream = streams[i];
+            std::unique_ptr<MappingPathCache::Cursor> cursor;
+            if (cache)
+                cursor.reset(new MappingPathCache::Cursor(*cache, i));
             while (!stream.eof()) {
                 if (size == BUFFER_SIZE) {
                     #pragma omp critical
@@ -83,12 +109,15 @@ public:
                 }
                 stream >> r;
                 ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
+                NotifyProcessRead(r, mapper, cursor.get(), lib_index, i);
             }
             #pragma omp atomic
             counter += size;
         }
 
+        if (cache)
+            cache->Finish();
+
         for (size_t i = 0; i < threads_count; ++i)
             NotifyMergeBuffer(lib_index, i);
 
@@ -96,9 +125,14 @@ public:
         NotifyStopProcessLibrary(lib_index);
     }
 
-private:
+    template<class MapF>
+    static MappingPath<EdgeId> Map(MappingPathCache::Cursor *cursor, const MapF &map) {
+        return cursor ? cursor->Get(map) : map();
+    }
+
     template<class ReadType>
-    void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
+    void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, MappingPathCache::Cursor *cursor,
+                           size_t ilib, size_t ithread) const;
 
     void NotifyStartProcessLibrary(size_t ilib, size_t thread_count) const;
 
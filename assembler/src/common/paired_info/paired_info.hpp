@@ -11,9 +11,11 @@
 #include "assembly_graph/core/action_handlers.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 #include "paired_info_buffer.hpp"
+#include "config.hpp"
 #include <type_traits>
 #include <boost/iterator/iterator_facade.hpp>
 #include <btree/safe_btree_map.h>
+#include <parallel_hashmap/phmap.h>
 #include <set>
 
 namespace omnigraph {
@@ -564,14 +566,33 @@ class NoLockingAdapter : public T {
 //Aliases for common graphs
 template<typename K, typename V>
 using safe_btree_map = NoLockingAdapter<btree::safe_btree_map<K, V>>; //Two-parameters wrapper
-template<typename Graph>
-using PairedInfoIndexT = PairedIndex<Graph, PointTraits, safe_btree_map>;
 
 template<typename K, typename V>
 using btree_map = NoLockingAdapter<btree::btree_map<K, V>>; //Two-parameters wrapper
 
+template<typename K, typename V>
+using flat_hash_map = NoLockingAdapter<phmap::flat_hash_map<K, V>>; //Two-parameters wrapper
+
+// Open addressing tables make histogram lookups several times faster than
+// b-trees (see paired_index_bench), though edges are traversed in hash order
+// instead of the id order, so the results may differ in tie-breaking
+#ifdef SPADES_PAIRED_INDEX_HASHMAP
+template<typename K, typename V>
+using paired_index_map = flat_hash_map<K, V>;
+template<typename K, typename V>
+using unclustered_paired_index_map = flat_hash_map<K, V>;
+#else
+template<typename K, typename V>
+using paired_index_map = safe_btree_map<K, V>;
+template<typename K, typename V>
+using unclustered_paired_index_map = btree_map<K, V>;
+#endif
+
+template<typename Graph>
+using PairedInfoIndexT = PairedIndex<Graph, PointTraits, paired_index_map>;
+
 template<typename Graph>
-using UnclusteredPairedInfoIndexT = PairedIndex<Graph, RawPointTraits, btree_map>;
+using UnclusteredPairedInfoIndexT = PairedIndex<Graph, RawPointTraits, unclustered_paired_index_map>;
 
 
 template<typename G, typename Traits, template<typename, typename> class Container>
@@ -586,6 +607,14 @@ public:
 
     PairedIndexHandler(PairedIndex<G, Traits, Container>& p): GraphActionHandler<G>(p.graph(), "PairedIndexHandler"), paired_index_(p) {}
 
+    void HandleRenumbering(const omnigraph::IdRenumbering<typename G::VertexId, EdgeId> &renumbering) override {
+        paired_index_.Renumber(renumbering);
+    }
+
+    bool IsRenumberable() const override {
+        return true;
+    }
+
     virtual void HandleDelete(EdgeId e) override {
         if (e == paired_index_.graph().conjugate(e)) {
             DEBUG("removing self-conj");
@@ -698,7 +727,7 @@ using PairedInfoIndicesT = PairedIndices<PairedInfoIndexT<Graph>>;
 
 
 template<typename Graph>
-using PairedInfoIndexHandlerT = PairedIndexHandler<Graph, PointTraits, safe_btree_map>;
+using PairedInfoIndexHandlerT = PairedIndexHandler<Graph, PointTraits, paired_index_map>;
 
 template<class Graph>
 using PairedInfoIndicesHandlerT = std::vector<PairedInfoIndexHandlerT<Graph>>;
@@ -194,6 +194,20 @@ class PairedBuffer : public PairedBufferBase<PairedBuffer<G, Traits, Container>,
         return storage_.lock_table();
     }
 
+    /**
+     * @brief Translates edge ids after graph compaction.
+     */
+    template<class Renumbering>
+    void Renumber(const Renumbering &renumbering) {
+        StorageMap storage;
+        for (auto &i : storage_) {
+            InnerMap &inner = storage[renumbering(i.first)];
+            for (auto &j : i.second)
+                inner[renumbering(j.first)] = std::move(j.second);
+        }
+        storage_.swap(storage);
+    }
+
     void BinWrite(std::ostream &str) const {
         using io::binary::BinWrite;
         BinWrite<size_t>(str, storage_.size());
@@ -219,6 +219,7 @@ void load(debruijn_config::construction& con,
     load(con.keep_perfect_loops, pt, "keep_perfect_loops", complete);
     load(con.read_buffer_size, pt, "read_buffer_size", complete);
     load(con.read_cov_threshold, pt, "read_cov_threshold", complete);
+    load(con.single_pass_cov_filter, pt, "single_pass_cov_filter", false);
 
     con.read_buffer_size *= 1024 * 1024;
     load(con.early_tc, pt, "early_tip_clipper", complete);
@@ -469,6 +470,7 @@ void load(pacbio_processor& pb,
   load(pb.max_path_in_dijkstra, pt, "max_path_in_dijkstra");
   load(pb.max_vertex_in_dijkstra, pt, "max_vertex_in_dijkstra");
   load(pb.rna_filtering, pt, "rna_filtering");
+  load(pb.distance_cache_size, pt, "distance_cache_size", false);
 
   load(pb.long_seq_limit, pt, "long_seq_limit");
   load(pb.enable_gap_closing, pt, "enable_gap_closing", false);
@@ -569,6 +571,20 @@ void load(debruijn_config::kmer_coverage_model& kcm,
   load(kcm.use_coverage_threshold, pt, "use_coverage_threshold");
 }
 
+void load(debruijn_config::checkpoint_io& cio,
+          boost::property_tree::ptree const& pt, bool complete) {
+  using config_common::load;
+  load(cio.compression, pt, "compression", complete);
+  load(cio.background, pt, "background", complete);
+}
+
+void load(debruijn_config::minimizer_mapping& mm,
+          boost::property_tree::ptree const& pt, bool complete) {
+  using config_common::load;
+  load(mm.pair_info_count, pt, "pair_info_count", complete);
+  load(mm.window, pt, "window", complete);
+}
+
 void load(debruijn_config::time_tracing& tt,
           boost::property_tree::ptree const& pt, bool /*complete*/) {
   using config_common::load;
@@ -626,6 +642,7 @@ void load(debruijn_config::simplification& simp,
   using config_common::load;
 
   load(simp.cycle_iter_count, pt, "cycle_iter_count", complete);
+  load(simp.concurrent_mutation, pt, "concurrent_mutation", false);
 
   load(simp.topology_simplif_enabled, pt, "topology_simplif_enabled", complete);
   load(simp.tc, pt, "tc", complete); // tip clipper:
@@ -717,6 +734,7 @@ void load_launch_info(debruijn_config &cfg, boost::property_tree::ptree const &p
     load(cfg.log_filename, pt, "log_filename");
 
     cfg.checkpoints = ModeByName<Checkpoints>(pt.get("checkpoints", "none"), {"none", "last", "all"});
+    load(cfg.cio, pt, "checkpoint_io", false);
 
     load(cfg.developer_mode, pt, "developer_mode");
     if (cfg.developer_mode) {
@@ -827,6 +845,9 @@ void load_cfg(debruijn_config &cfg, boost::property_tree::ptree const &pt,
 
     load(cfg.ss, pt, "strand_specificity", complete);
     load(cfg.calculate_coverage_for_each_lib, pt, "calculate_coverage_for_each_lib", complete);
+    load(cfg.cache_read_mappings, pt, "cache_read_mappings", false);
+    load(cfg.sequence_arena, pt, "sequence_arena", false);
+    load(cfg.mm, pt, "minimizer_mapping", false);
 
 
     if (pt.count("plasmid")) {
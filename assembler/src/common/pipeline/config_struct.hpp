@@ -269,6 +269,7 @@ struct debruijn_config {
         };
 
         size_t cycle_iter_count;
+        bool concurrent_mutation = false;
 
         bool topology_simplif_enabled;
         tip_clipper tc;
@@ -304,10 +305,12 @@ struct debruijn_config {
         early_tip_clipper early_tc;
         bool keep_perfect_loops;
         unsigned read_cov_threshold;
+        bool single_pass_cov_filter;
         size_t read_buffer_size;
         construction() :
                 keep_perfect_loops(true),
                 read_cov_threshold(0),
+                single_pass_cov_filter(false),
                 read_buffer_size(0) {}
     };
 
@@ -428,6 +431,22 @@ struct debruijn_config {
         bool use_coverage_threshold;
     };
 
+    // Writing of the checkpoints, see io::binary::CheckpointWriter
+    struct checkpoint_io {
+        // zlib level of the checkpoint files chunks, 0 disables the compression
+        int compression = 1;
+        // Write the files in the background while the next stage runs. The
+        // whole checkpoint is kept in memory until it is written
+        bool background = false;
+    };
+
+    // Mapping short reads by their window minimizers, see MinimizerSequenceMapper
+    struct minimizer_mapping {
+        // Use it for the paired reads mapped on the paired info counting stage
+        bool pair_info_count = false;
+        unsigned window = 10;
+    };
+
     struct time_tracing {
         bool enable;
         unsigned granularity;
@@ -441,6 +460,7 @@ struct debruijn_config {
     std::string output_dir;
     std::string tmp_dir;
     Checkpoints checkpoints;
+    checkpoint_io cio;
     std::string output_saves;
     std::string log_filename;
     std::string series_analysis;
@@ -543,6 +563,11 @@ struct debruijn_config {
     size_t flanking_range;
 
     bool calculate_coverage_for_each_lib;
+    // Store read mapping paths on disk to replay them while the graph is unchanged
+    bool cache_read_mappings = false;
+    // Store the edge nucleotides in the slab arena owned by the graph, see SequenceArena
+    bool sequence_arena = false;
+    minimizer_mapping mm;
     strand_specificity ss;
     time_tracing tt;
 
@@ -18,6 +18,8 @@ struct pacbio_processor {
     size_t max_path_in_dijkstra   = 15000;
     size_t max_vertex_in_dijkstra = 2000;
     bool rna_filtering            = false;
+    // Vertex distances kept by the Dijkstra runs cache of PacBioMappingIndex
+    size_t distance_cache_size    = 1 << 22;
 
     // gap closer
     size_t long_seq_limit           = 400;
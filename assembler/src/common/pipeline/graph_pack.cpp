@@ -25,9 +25,9 @@ namespace debruijn_graph {
 GraphPack::GraphPack(size_t k, const std::string &workdir, size_t lib_count,
                      const std::vector<std::string> &genome,
                      size_t flanking_range, size_t max_mapping_gap, size_t max_gap_diff,
-                     bool detach_indices) : k_(k), workdir_(workdir) {
+                     bool detach_indices, bool sequence_arena) : k_(k), workdir_(workdir) {
     using namespace omnigraph::de;
-    Graph &g = emplace<Graph>(k);
+    Graph &g = emplace<Graph>(k, sequence_arena);
     emplace<EdgeIndex<Graph>>(g, workdir);
     emplace<KmerMapper<Graph>>(g);
     emplace<FlankingCoverage<Graph>>(g, flanking_range);
@@ -21,7 +21,8 @@ public:
                size_t flanking_range = 50,
                size_t max_mapping_gap = 0,
                size_t max_gap_diff = 0,
-               bool detach_indices = true);
+               bool detach_indices = true,
+               bool sequence_arena = false);
 
     size_t k() const { return k_; }
     const std::string &workdir() const { return workdir_; }
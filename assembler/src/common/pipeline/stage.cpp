@@ -7,6 +7,7 @@
 
 #include "io/dataset_support/read_converter.hpp"
 #include "io/binary/graph_pack.hpp"
+#include "io/binary/checkpoint.hpp"
 
 #include "pipeline/stage.hpp"
 
@@ -179,6 +180,14 @@ void StageManager::run(debruijn_graph::GraphPack& g,
         }
     }
 
+    io::binary::ChunkedFormat format;
+    format.level = cfg::get().cio.compression;
+    io::binary::OutputFile::set_format(format);
+    // In the background mode checkpoint files are collected in memory and
+    // written while the next stages run, otherwise they are written directly
+    bool background = cfg::get().cio.background;
+    io::binary::CheckpointWriter checkpoint(format, background);
+
     for (; start_stage != stages_.end(); ++start_stage) {
         AssemblyStage *stage = start_stage->get();
 
@@ -190,17 +199,27 @@ void StageManager::run(debruijn_graph::GraphPack& g,
         }
 
         if (saves_policy_.EnabledCheckpoints() != SavesPolicy::Checkpoints::None) {
+            // The previous checkpoint becomes the last one only after it is written
+            checkpoint.Wait();
             auto prev_saves = saves_policy_.GetLastCheckpoint();
             {
                 TIME_TRACE_SCOPE("save", saves_policy_.SavesPath());
+                std::unique_ptr<io::binary::CheckpointWriter::Scope> scope;
+                if (background)
+                    scope.reset(new io::binary::CheckpointWriter::Scope(checkpoint));
                 stage->save(g, saves_policy_.SavesPath());
             }
-            saves_policy_.UpdateCheckpoint(stage->id());
-            if (!prev_saves.empty() && saves_policy_.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last) {
-                fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), prev_saves));
-            }
+            std::string id = stage->id();
+            checkpoint.Commit([this, id, prev_saves] {
+                saves_policy_.UpdateCheckpoint(id.c_str());
+                if (!prev_saves.empty() && saves_policy_.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last) {
+                    fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), prev_saves));
+                }
+            });
         }
     }
+
+    checkpoint.Wait();
 }
 
 }
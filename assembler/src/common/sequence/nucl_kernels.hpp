@@ -0,0 +1,454 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "nucl.hpp"
+
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NUCL_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "nucleotide kernels assume little-endian packed storage");
+
+// Bulk nucleotide kernels shared by Sequence, RuntimeSeq and SingleRead.
+//
+// Packed layout is the one used by Sequence / Seq / RuntimeSeq: 4 nucleotides
+// per byte, i-th nucleotide in bits [2*(i % 4), 2*(i % 4) + 2) of byte i / 4.
+// On little-endian hosts this coincides with the layout of the uint64_t word
+// arrays, so the word storage could be passed in directly.
+//
+// Vector paths (SSE4.2 / AVX2) are selected at runtime, a block containing
+// anything except ACGTacgt0123 is always handled by the scalar code, so the
+// results are bit-identical to the per-character implementation.
+namespace nucl_kernels {
+
+enum class Isa {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+inline const char *IsaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "AVX2";
+        case Isa::SSE42: return "SSE4.2";
+        default: return "scalar";
+    }
+}
+
+inline Isa DetectIsa() {
+#ifdef NUCL_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return Isa::SSE42;
+#endif
+    return Isa::Scalar;
+}
+
+// Currently used instruction set. Might be lowered (e.g. by tests and
+// benchmarks) but never set above DetectIsa().
+inline Isa &ActiveIsa() {
+    static Isa isa = DetectIsa();
+    return isa;
+}
+
+namespace scalar {
+
+inline bool IsValid(const char *s, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        if (!is_nucl(s[i]))
+            return false;
+    return true;
+}
+
+inline void Pack(const char *s, size_t n, uint8_t *out, bool rc) {
+    uint8_t data = 0;
+    unsigned cnt = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t c = rc ? uint8_t(dignucl(s[n - 1 - i]) ^ 3) : uint8_t(dignucl(s[i]));
+        data = uint8_t(data | (c << cnt));
+        cnt += 2;
+        if (cnt == 8) {
+            *out++ = data;
+            data = 0;
+            cnt = 0;
+        }
+    }
+    if (cnt)
+        *out = data;
+}
+
+inline void Unpack(const uint8_t *packed, size_t from, size_t n, char *out, bool rc) {
+    const char *table = rc ? "TGCA" : "ACGT";
+    for (size_t i = 0; i < n; ++i) {
+        size_t pos = from + i;
+        char c = table[(packed[pos >> 2] >> ((pos & 3) << 1)) & 3];
+        if (rc)
+            out[n - 1 - i] = c;
+        else
+            out[i] = c;
+    }
+}
+
+inline void ReverseComplement(const char *s, size_t n, char *out) {
+    for (size_t i = 0; i < n; ++i)
+        out[n - 1 - i] = nucl_complement(s[i]);
+}
+
+}
+
+#ifdef NUCL_KERNELS_X86
+
+#define NUCL_KERNELS_SSE __attribute__((target("sse4.2")))
+#define NUCL_KERNELS_AVX2 __attribute__((target("avx2")))
+
+namespace sse42 {
+
+// Byte mask of ACGTacgt0123 characters
+NUCL_KERNELS_SSE inline __m128i ValidMask(__m128i x) {
+    __m128i l = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('a')),
+                                          _mm_cmpeq_epi8(l, _mm_set1_epi8('c'))),
+                             _mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('g')),
+                                          _mm_cmpeq_epi8(l, _mm_set1_epi8('t'))));
+    __m128i d = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(3)), x);
+    return _mm_or_si128(m, d);
+}
+
+// ACGT -> 0123 for letters of any case: ((c >> 1) & 3) ^ ((c >> 2) & 1),
+// digits are passed as is
+NUCL_KERNELS_SSE inline __m128i Encode(__m128i x) {
+    __m128i f = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(3)),
+                              _mm_and_si128(_mm_srli_epi16(x, 2), _mm_set1_epi8(1)));
+    __m128i d = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(3)), x);
+    return _mm_or_si128(_mm_and_si128(d, x), _mm_andnot_si128(d, f));
+}
+
+NUCL_KERNELS_SSE inline __m128i Reverse(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// 16 2-bit codes (one per byte) -> 32 bits
+NUCL_KERNELS_SSE inline uint32_t Compact(__m128i codes) {
+    __m128i v = _mm_maddubs_epi16(codes, _mm_set1_epi16(0x0401));
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00100001));
+    v = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+    return uint32_t(_mm_cvtsi128_si32(v));
+}
+
+NUCL_KERNELS_SSE inline bool IsValid(const char *s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        if (_mm_movemask_epi8(ValidMask(x)) != 0xFFFF)
+            return false;
+    }
+    return scalar::IsValid(s + i, n - i);
+}
+
+NUCL_KERNELS_SSE inline void Pack(const char *s, size_t n, uint8_t *out, bool rc) {
+    size_t blocks = n / 16;
+    for (size_t j = 0; j < blocks; ++j) {
+        const char *p = rc ? s + n - 16 * (j + 1) : s + 16 * j;
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(ValidMask(x)) != 0xFFFF) {
+            scalar::Pack(p, 16, out + 4 * j, rc);
+            continue;
+        }
+        __m128i codes = Encode(rc ? Reverse(x) : x);
+        if (rc)
+            codes = _mm_xor_si128(codes, _mm_set1_epi8(3));
+        uint32_t packed = Compact(codes);
+        memcpy(out + 4 * j, &packed, sizeof(packed));
+    }
+    size_t r = n - 16 * blocks;
+    scalar::Pack(rc ? s : s + 16 * blocks, r, out + 4 * blocks, rc);
+}
+
+// 16 packed bytes -> 64 characters
+NUCL_KERNELS_SSE inline void Expand(__m128i x, __m128i table, __m128i out[4]) {
+    __m128i mask = _mm_set1_epi8(3);
+    __m128i c0 = _mm_and_si128(x, mask);
+    __m128i c1 = _mm_and_si128(_mm_srli_epi16(x, 2), mask);
+    __m128i c2 = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+    __m128i c3 = _mm_and_si128(_mm_srli_epi16(x, 6), mask);
+    __m128i a = _mm_unpacklo_epi8(c0, c1), b = _mm_unpacklo_epi8(c2, c3);
+    out[0] = _mm_shuffle_epi8(table, _mm_unpacklo_epi16(a, b));
+    out[1] = _mm_shuffle_epi8(table, _mm_unpackhi_epi16(a, b));
+    a = _mm_unpackhi_epi8(c0, c1), b = _mm_unpackhi_epi8(c2, c3);
+    out[2] = _mm_shuffle_epi8(table, _mm_unpacklo_epi16(a, b));
+    out[3] = _mm_shuffle_epi8(table, _mm_unpackhi_epi16(a, b));
+}
+
+NUCL_KERNELS_SSE inline void Unpack(const uint8_t *packed, size_t from, size_t n, char *out, bool rc) {
+    // Scalar head up to the byte boundary
+    size_t head = std::min(n, (4 - (from & 3)) & 3);
+    scalar::Unpack(packed, from, head, rc ? out + n - head : out, rc);
+
+    __m128i table = rc ? _mm_setr_epi8('T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+                       : _mm_setr_epi8('A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const uint8_t *p = packed + ((from + head) >> 2);
+    size_t i = head;
+    for (; i + 64 <= n; i += 64, p += 16) {
+        __m128i chars[4];
+        Expand(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), table, chars);
+        if (rc) {
+            char *o = out + n - i - 64;
+            for (unsigned k = 0; k < 4; ++k)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 16 * (3 - k)), Reverse(chars[k]));
+        } else {
+            for (unsigned k = 0; k < 4; ++k)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 16 * k), chars[k]);
+        }
+    }
+    scalar::Unpack(packed, from + i, n - i, rc ? out : out + i, rc);
+}
+
+NUCL_KERNELS_SSE inline void ReverseComplement(const char *s, size_t n, char *out) {
+    // Complement is a xor with a value depending on the low nibble only:
+    // A(1) <-> T(4) is ^ 0x15, C(3) <-> G(7) is ^ 0x04, N(E) stays. Case is kept.
+    const __m128i xors = _mm_setr_epi8(0, 0x15, 0, 0x04, 0x15, 0, 0, 0x04, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t blocks = n / 16;
+    for (size_t j = 0; j < blocks; ++j) {
+        const char *p = s + n - 16 * (j + 1);
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i l = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('a')),
+                                              _mm_cmpeq_epi8(l, _mm_set1_epi8('c'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('g')),
+                                              _mm_cmpeq_epi8(l, _mm_set1_epi8('t'))));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(l, _mm_set1_epi8('n')));
+        if (_mm_movemask_epi8(m) != 0xFFFF) {
+            scalar::ReverseComplement(p, 16, out + 16 * j);
+            continue;
+        }
+        __m128i c = _mm_xor_si128(x, _mm_shuffle_epi8(xors, _mm_and_si128(x, _mm_set1_epi8(0x0F))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * j), Reverse(c));
+    }
+    scalar::ReverseComplement(s, n - 16 * blocks, out + 16 * blocks);
+}
+
+}
+
+namespace avx2 {
+
+NUCL_KERNELS_AVX2 inline __m256i ValidMask(__m256i x) {
+    __m256i l = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('a')),
+                                                _mm256_cmpeq_epi8(l, _mm256_set1_epi8('c'))),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('g')),
+                                                _mm256_cmpeq_epi8(l, _mm256_set1_epi8('t'))));
+    __m256i d = _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(3)), x);
+    return _mm256_or_si256(m, d);
+}
+
+NUCL_KERNELS_AVX2 inline __m256i Encode(__m256i x) {
+    __m256i f = _mm256_xor_si256(_mm256_and_si256(_mm256_srli_epi16(x, 1), _mm256_set1_epi8(3)),
+                                 _mm256_and_si256(_mm256_srli_epi16(x, 2), _mm256_set1_epi8(1)));
+    __m256i d = _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(3)), x);
+    return _mm256_or_si256(_mm256_and_si256(d, x), _mm256_andnot_si256(d, f));
+}
+
+NUCL_KERNELS_AVX2 inline __m256i Reverse(__m256i x) {
+    x = _mm256_shuffle_epi8(x, _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+    return _mm256_permute4x64_epi64(x, 0x4E);
+}
+
+// 32 2-bit codes (one per byte) -> 64 bits
+NUCL_KERNELS_AVX2 inline uint64_t Compact(__m256i codes) {
+    __m256i v = _mm256_maddubs_epi16(codes, _mm256_set1_epi16(0x0401));
+    v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00100001));
+    v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+    v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1));
+    return uint64_t(_mm_cvtsi128_si64(_mm256_castsi256_si128(v)));
+}
+
+NUCL_KERNELS_AVX2 inline bool IsValid(const char *s, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        if (_mm256_movemask_epi8(ValidMask(x)) != -1)
+            return false;
+    }
+    return scalar::IsValid(s + i, n - i);
+}
+
+NUCL_KERNELS_AVX2 inline void Pack(const char *s, size_t n, uint8_t *out, bool rc) {
+    size_t blocks = n / 32;
+    for (size_t j = 0; j < blocks; ++j) {
+        const char *p = rc ? s + n - 32 * (j + 1) : s + 32 * j;
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if (_mm256_movemask_epi8(ValidMask(x)) != -1) {
+            scalar::Pack(p, 32, out + 8 * j, rc);
+            continue;
+        }
+        __m256i codes = Encode(rc ? Reverse(x) : x);
+        if (rc)
+            codes = _mm256_xor_si256(codes, _mm256_set1_epi8(3));
+        uint64_t packed = Compact(codes);
+        memcpy(out + 8 * j, &packed, sizeof(packed));
+    }
+    size_t r = n - 32 * blocks;
+    scalar::Pack(rc ? s : s + 32 * blocks, r, out + 8 * blocks, rc);
+}
+
+NUCL_KERNELS_AVX2 inline void Unpack(const uint8_t *packed, size_t from, size_t n, char *out, bool rc) {
+    size_t head = std::min(n, (4 - (from & 3)) & 3);
+    scalar::Unpack(packed, from, head, rc ? out + n - head : out, rc);
+
+    __m256i table = rc ? _mm256_setr_epi8('T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          'T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+                       : _mm256_setr_epi8('A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m256i mask = _mm256_set1_epi8(3);
+    const uint8_t *p = packed + ((from + head) >> 2);
+    size_t i = head;
+    for (; i + 64 <= n; i += 64, p += 16) {
+        // Bytes 0-7 go to the low lane, 8-15 to the high one
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m256i x = _mm256_permute4x64_epi64(_mm256_castsi128_si256(in), 0x54);
+        __m256i c0 = _mm256_and_si256(x, mask);
+        __m256i c1 = _mm256_and_si256(_mm256_srli_epi16(x, 2), mask);
+        __m256i c2 = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+        __m256i c3 = _mm256_and_si256(_mm256_srli_epi16(x, 6), mask);
+        __m256i a = _mm256_unpacklo_epi8(c0, c1), b = _mm256_unpacklo_epi8(c2, c3);
+        __m256i lo = _mm256_shuffle_epi8(table, _mm256_unpacklo_epi16(a, b));
+        __m256i hi = _mm256_shuffle_epi8(table, _mm256_unpackhi_epi16(a, b));
+        __m256i first = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i second = _mm256_permute2x128_si256(lo, hi, 0x31);
+        if (rc) {
+            char *o = out + n - i - 64;
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 32), Reverse(first));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), Reverse(second));
+        } else {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), first);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 32), second);
+        }
+    }
+    scalar::Unpack(packed, from + i, n - i, rc ? out : out + i, rc);
+}
+
+NUCL_KERNELS_AVX2 inline void ReverseComplement(const char *s, size_t n, char *out) {
+    const __m256i xors = _mm256_setr_epi8(0, 0x15, 0, 0x04, 0x15, 0, 0, 0x04, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          0, 0x15, 0, 0x04, 0x15, 0, 0, 0x04, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t blocks = n / 32;
+    for (size_t j = 0; j < blocks; ++j) {
+        const char *p = s + n - 32 * (j + 1);
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i l = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('a')),
+                                                    _mm256_cmpeq_epi8(l, _mm256_set1_epi8('c'))),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('g')),
+                                                    _mm256_cmpeq_epi8(l, _mm256_set1_epi8('t'))));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(l, _mm256_set1_epi8('n')));
+        if (_mm256_movemask_epi8(m) != -1) {
+            scalar::ReverseComplement(p, 32, out + 32 * j);
+            continue;
+        }
+        __m256i c = _mm256_xor_si256(x, _mm256_shuffle_epi8(xors, _mm256_and_si256(x, _mm256_set1_epi8(0x0F))));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32 * j), Reverse(c));
+    }
+    scalar::ReverseComplement(s, n - 32 * blocks, out + 32 * blocks);
+}
+
+}
+
+#undef NUCL_KERNELS_SSE
+#undef NUCL_KERNELS_AVX2
+
+#endif
+
+// Vector code pays off only starting from a couple of blocks
+static const size_t MIN_VECTOR_SIZE = 32;
+
+/**
+ * @return true if all characters of s[0, n) are ACGTacgt0123 (see is_nucl())
+ */
+inline bool IsValid(const char *s, size_t n) {
+#ifdef NUCL_KERNELS_X86
+    if (n >= MIN_VECTOR_SIZE) {
+        switch (ActiveIsa()) {
+            case Isa::AVX2: return avx2::IsValid(s, n);
+            case Isa::SSE42: return sse42::IsValid(s, n);
+            default: break;
+        }
+    }
+#endif
+    return scalar::IsValid(s, n);
+}
+
+/**
+ * Packs n nucleotides (ACGTacgt or 0123) into (n + 3) / 4 bytes, unused bits
+ * of the last byte are zeroed. If rc is set, reverse-complement is packed.
+ */
+inline void Pack(const char *s, size_t n, uint8_t *out, bool rc = false) {
+#ifdef NUCL_KERNELS_X86
+    if (n >= MIN_VECTOR_SIZE) {
+        switch (ActiveIsa()) {
+            case Isa::AVX2: return avx2::Pack(s, n, out, rc);
+            case Isa::SSE42: return sse42::Pack(s, n, out, rc);
+            default: break;
+        }
+    }
+#endif
+    scalar::Pack(s, n, out, rc);
+}
+
+/**
+ * Unpacks nucleotides [from, from + n) into ACGT string, reverse-complement
+ * of the range if rc is set.
+ */
+inline void Unpack(const uint8_t *packed, size_t from, size_t n, char *out, bool rc = false) {
+#ifdef NUCL_KERNELS_X86
+    if (n >= MIN_VECTOR_SIZE) {
+        switch (ActiveIsa()) {
+            case Isa::AVX2: return avx2::Unpack(packed, from, n, out, rc);
+            case Isa::SSE42: return sse42::Unpack(packed, from, n, out, rc);
+            default: break;
+        }
+    }
+#endif
+    scalar::Unpack(packed, from, n, out, rc);
+}
+
+/**
+ * Reverse-complement of ACGTNacgtn0123 string (see nucl_complement())
+ */
+inline void ReverseComplement(const char *s, size_t n, char *out) {
+#ifdef NUCL_KERNELS_X86
+    if (n >= MIN_VECTOR_SIZE) {
+        switch (ActiveIsa()) {
+            case Isa::AVX2: return avx2::ReverseComplement(s, n, out);
+            case Isa::SSE42: return sse42::ReverseComplement(s, n, out);
+            default: break;
+        }
+    }
+#endif
+    scalar::ReverseComplement(s, n, out);
+}
+
+// Contiguous character storage of the string-like objects Sequence and
+// RuntimeSeq are constructed from, nullptr if there is none.
+inline const char *ContiguousNucls(const std::string &s) { return s.data(); }
+inline const char *ContiguousNucls(const char *s) { return s; }
+inline const char *ContiguousNucls(char *s) { return s; }
+template<class S>
+const char *ContiguousNucls(const S &) { return nullptr; }
+
+}
@@ -20,6 +20,7 @@
 #include <array>
 #include <algorithm>
 #include "nucl.hpp"
+#include "nucl_kernels.hpp"
 #include "math/log.hpp"
 #include "seq_common.hpp"
 #include "seq.hpp"
@@ -164,27 +165,9 @@ private:
      * @param s C-string (ACGT chars only), strlen(s) = size_
      */
     void init(const char *s) {
-        T data = 0;
-        size_t cnt = 0;
-        size_t cur = 0;
-        for (size_t pos = 0; pos < size_; ++pos, ++s) { // unsafe!
-            // VERIFY(is_nucl(*s)); // for performance
-            data = data | ((T) dignucl(*s) << cnt);
-            cnt += 2;
-            if (cnt == TBits) {
-                this->data_[cur++] = data;
-                cnt = 0;
-                data = 0;
-            }
-        }
-        if (cnt != 0) {
-            this->data_[cur++] = data;
-        }
-
-        for (; cur < DataSize; ++cur)
-            this->data_[cur] = 0;
-
-        VERIFY(*s == 0); // C-string always ends on 0
+        std::fill(data_.begin(), data_.end(), 0);
+        nucl_kernels::Pack(s, size_, reinterpret_cast<uint8_t*>(data_.data()));
+        VERIFY(s[size_] == 0); // C-string always ends on 0
     }
 
     /**
@@ -299,6 +282,11 @@ public:
         // we fill everything with zeros (As) by default.
         std::fill(data_.begin(), data_.end(), 0);
 
+        if (const char *chars = nucl_kernels::ContiguousNucls(s)) {
+            nucl_kernels::Pack(chars + offset, size_, reinterpret_cast<uint8_t*>(data_.data()));
+            return;
+        }
+
         // data -- one temporary variable corresponding to the i-th array element
         // and some counters
         T data = 0;
@@ -623,9 +611,7 @@ public:
      */
     std::string str() const {
         std::string res(size_, '-');
-        for (size_t i = 0; i < size_; ++i) {
-            res[i] = nucl(operator[](i));
-        }
+        nucl_kernels::Unpack(reinterpret_cast<const uint8_t*>(data_.data()), 0, size_, &res[0]);
         return res;
     }
 
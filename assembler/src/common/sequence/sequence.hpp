@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
@@ -14,6 +15,8 @@
 
 #include "seq.hpp"
 #include "rtseq.hpp"
+#include "nucl_kernels.hpp"
+#include "sequence_arena.hpp"
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/Support/TrailingObjects.h>
@@ -32,13 +35,18 @@ class Sequence {
     // Number of bits in STN (for faster div and mod)
     const static size_t STNBits = log_<STN, 2>::value;
 
-    class ManagedNuclBuffer final : public llvm::ThreadSafeRefCountedBase<ManagedNuclBuffer>,
-                                    protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
+    class ManagedNuclBuffer final : protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
         friend TrailingObjects;
 
-        ManagedNuclBuffer() {}
+        mutable std::atomic<int> ref_count_;
+        // Size class and shard of the arena allocated buffers, 0 for the heap allocated ones
+        uint32_t arena_block_;
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
+        explicit ManagedNuclBuffer(uint32_t arena_block)
+                : ref_count_(0), arena_block_(arena_block) {}
+
+        ManagedNuclBuffer(size_t nucls, ST *buf)
+                : ManagedNuclBuffer(0) {
             std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
         }
 
@@ -47,7 +55,7 @@ class Sequence {
 
         static ManagedNuclBuffer *create(size_t nucls) {
             void *mem = ::operator new(totalSizeToAlloc<ST>(Sequence::DataSize(nucls)));
-            return new (mem) ManagedNuclBuffer();
+            return new (mem) ManagedNuclBuffer(0);
         }
 
         static ManagedNuclBuffer *create(size_t nucls, ST *data) {
@@ -55,6 +63,25 @@ class Sequence {
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
 
+        static ManagedNuclBuffer *create(size_t nucls, SequenceArena &arena) {
+            uint32_t block;
+            void *mem = arena.Allocate(totalSizeToAlloc<ST>(Sequence::DataSize(nucls)), block);
+            return new (mem) ManagedNuclBuffer(block);
+        }
+
+        void Retain() const {
+            ref_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Release() const {
+            if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+            if (arena_block_)
+                SequenceArena::Deallocate(const_cast<ManagedNuclBuffer*>(this), arena_block_);
+            else
+                delete this;
+        }
+
         const ST *data() const { return getTrailingObjects<ST>(); }
         ST *data() { return getTrailingObjects<ST>(); }
     };
@@ -75,6 +102,14 @@ class Sequence {
 
         VERIFY(is_dignucl(s[0]) || is_nucl(s[0]));
 
+        if (const char *chars = nucl_kernels::ContiguousNucls(s)) {
+            size_t packed_size = (size_ + 3) >> 2;
+            uint8_t *packed = reinterpret_cast<uint8_t*>(bytes);
+            nucl_kernels::Pack(chars, size_, packed, rc);
+            memset(packed + packed_size, 0, bytes_size * sizeof(ST) - packed_size);
+            return;
+        }
+
         // Which symbols does our string contain : 0123 or ACGT?
         bool digit_str = is_dignucl(s[0]);
 
@@ -124,6 +159,8 @@ class Sequence {
     inline bool ReadHeader(std::istream &file);
     inline bool WriteHeader(std::ostream &file) const;
 
+    friend class SequenceBatchBuilder;
+
     Sequence(size_t size, int)
             : size_(size), from_(0), rtl_(false), data_(ManagedNuclBuffer::create(size_)) {}
 
@@ -173,6 +210,22 @@ public:
     Sequence(const Sequence &s)
             : Sequence(s, s.from_, s.size_, s.rtl_) {}
 
+    /**
+     * Copies the nucleotides to the buffer allocated from the arena
+     */
+    Sequence(const Sequence &s, SequenceArena &arena)
+            : size_(s.size_), from_(0), rtl_(false), data_(ManagedNuclBuffer::create(size_, arena)) {
+        if (!size_)
+            return;
+
+        if (!s.rtl_ && (s.from_ & (STN - 1)) == 0) {
+            memcpy(data_->data(), s.data_->data() + (s.from_ >> STNBits), DataSize(size_) * sizeof(ST));
+            return;
+        }
+
+        InitFromNucls(s.str());
+    }
+
     const Sequence &operator=(const Sequence &rhs) {
         if (&rhs == this)
             return *this;
@@ -267,6 +320,11 @@ public:
 
     inline std::string err() const;
 
+    /**
+     * Hash of the packed nucleotides, equal for the equal sequences
+     */
+    inline size_t GetHash(uint64_t seed = 0) const;
+
     size_t size() const {
         return size_;
     }
@@ -374,11 +432,32 @@ Sequence Sequence::operator+(const Sequence &s) const {
     //    return Sequence(new Data(bytes), 0, total, false);
 }
 
+size_t Sequence::GetHash(uint64_t seed) const {
+    size_t words = size_ >> STNBits, rest = size_ & (STN - 1);
+    std::vector<ST> packed;
+    const ST *data;
+    if (!rtl_ && (from_ & (STN - 1)) == 0) {
+        data = data_->data() + (from_ >> STNBits);
+    } else {
+        // Repack the reverse complement or unaligned subsequence
+        packed.assign(DataSize(size_), 0);
+        for (size_t i = 0; i < size_; ++i)
+            packed[i >> STNBits] |= ST(operator[](i)) << ((i & (STN - 1)) << 1);
+        data = packed.data();
+    }
+
+    size_t hash = XXH3_64bits_withSeed(data, words * sizeof(ST), seed);
+    if (rest) {
+        // The rest of the last word might be occupied by the sequence the data is shared with
+        ST last = data[words] & ((ST(1) << (rest << 1)) - 1);
+        hash = XXH3_64bits_withSeed(&last, sizeof(last), hash);
+    }
+    return hash;
+}
+
 std::string Sequence::str() const {
     std::string res(size_, '-');
-    for (size_t i = 0; i < size_; ++i) {
-        res[i] = nucl(this->operator[](i));
-    }
+    nucl_kernels::Unpack(reinterpret_cast<const uint8_t*>(data_->data()), from_, size_, &res[0], rtl_);
     return res;
 }
 
@@ -490,4 +569,47 @@ public:
     }
 };
 
+/**
+ * @class SequenceBatchBuilder
+ * @section DESCRIPTION
+ *
+ * Packs many nucleotide strings into a single shared buffer. Sequences
+ * returned by append() are views into this buffer (which is kept alive by
+ * them), so there is no per-sequence allocation.
+ */
+class SequenceBatchBuilder {
+    typedef Sequence::ST ST;
+
+    Sequence buffer_;
+    // Every sequence starts at the byte boundary, so used_ is always a multiple of 4
+    size_t used_;
+
+public:
+    // Limited by the width of Sequence::from_
+    const static size_t MaxCapacity = (size_t(1) << 31) - 1;
+
+    explicit SequenceBatchBuilder(size_t capacity)
+            : buffer_(capacity, 0), used_(0) {
+        VERIFY(capacity <= MaxCapacity);
+        memset(buffer_.data_->data(), 0, Sequence::DataSize(capacity) * sizeof(ST));
+    }
+
+    size_t capacity() const {
+        return buffer_.size();
+    }
+
+    bool fits(size_t size) const {
+        return used_ + size <= capacity();
+    }
+
+    Sequence append(const char *s, size_t size, bool rc = false) {
+        VERIFY(fits(size));
+        uint8_t *bytes = reinterpret_cast<uint8_t*>(buffer_.data_->data());
+        nucl_kernels::Pack(s, size, bytes + (used_ >> 2), rc);
+        Sequence res(buffer_, used_, size, false);
+        used_ = (used_ + size + 3) & ~size_t(3);
+        return res;
+    }
+};
+
 #pragma GCC diagnostic pop
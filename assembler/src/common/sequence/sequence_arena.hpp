@@ -0,0 +1,176 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <folly/SmallLocks.h>
+
+#include <sys/mman.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Slab allocator for the nucleotide buffers of long living sequences, e.g. the
+// graph edges. Millions of small buffers are carved from 2 Mb slabs (backed by
+// transparent hugepages where available) instead of the general heap, the freed
+// ones are reused via the per size class free lists and the slabs are unmapped
+// at once when both the arena owner and all the buffers allocated from it are
+// gone, so the sequences escaping the owner stay valid.
+class SequenceArena {
+public:
+    static constexpr size_t SLAB_SIZE = size_t(2) << 20;
+    // Every shard takes the runs of this size from the current slab
+    static constexpr size_t RUN_SIZE = size_t(64) << 10;
+    static constexpr size_t GRANULARITY = 16;
+    // Larger buffers are allocated from the heap
+    static constexpr size_t MAX_BLOCK_SIZE = 4096;
+    static constexpr unsigned SHARDS = 32;
+
+    static std::shared_ptr<SequenceArena> create() {
+        return std::shared_ptr<SequenceArena>(new SequenceArena(), [](SequenceArena *arena) { arena->Unref(); });
+    }
+
+    /**
+     * @brief  Allocates the memory of the given size. The returned block tag is 0 for the heap allocated memory
+     *         and must be passed to Deallocate().
+     */
+    void *Allocate(size_t size, uint32_t &block) {
+        size_t cls = (size + GRANULARITY - 1) / GRANULARITY;
+        if (size > MAX_BLOCK_SIZE || !cls) {
+            block = 0;
+            return ::operator new(size);
+        }
+
+        unsigned idx = ThreadShard();
+        Shard &shard = shards_[idx];
+        block = uint32_t(idx << 16 | cls);
+        folly::MSLGuard guard(shard.lock);
+        if (!shard.live++)
+            refs_.fetch_add(1, std::memory_order_relaxed);
+
+        if (FreeBlock *free = shard.free[cls]) {
+            shard.free[cls] = free->next;
+            return free;
+        }
+
+        size_t bytes = cls * GRANULARITY;
+        if (shard.end - shard.cur < ptrdiff_t(bytes)) {
+            shard.cur = AllocateRun();
+            shard.end = shard.cur + RUN_SIZE;
+        }
+        void *res = shard.cur;
+        shard.cur += bytes;
+        return res;
+    }
+
+    static void Deallocate(void *p, uint32_t block) {
+        if (!block) {
+            ::operator delete(p);
+            return;
+        }
+
+        SequenceArena *arena = reinterpret_cast<SlabHeader*>(uintptr_t(p) & ~(SLAB_SIZE - 1))->arena;
+        Shard &shard = arena->shards_[block >> 16];
+        bool last;
+        {
+            folly::MSLGuard guard(shard.lock);
+            auto *free = static_cast<FreeBlock*>(p);
+            free->next = shard.free[block & 0xFFFF];
+            shard.free[block & 0xFFFF] = free;
+            last = !--shard.live;
+        }
+        // The arena might be released right away, so it is done outside of the lock
+        if (last)
+            arena->Unref();
+    }
+
+    size_t slabs() const {
+        std::lock_guard<std::mutex> lock(slabs_mutex_);
+        return slabs_.size();
+    }
+
+private:
+    struct SlabHeader {
+        SequenceArena *arena;
+    };
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct Shard {
+        folly::MicroSpinLock lock = { 0 };
+        // Number of the allocated blocks, the arena is referenced by the shard while it is non-zero
+        size_t live = 0;
+        char *cur = nullptr, *end = nullptr;
+        std::array<FreeBlock*, MAX_BLOCK_SIZE / GRANULARITY + 1> free{};
+    };
+
+    static_assert(sizeof(SlabHeader) <= GRANULARITY, "Slab header must fit the first block");
+
+    SequenceArena()
+            : refs_(1), slab_cur_(nullptr), slab_end_(nullptr) {}
+
+    ~SequenceArena() {
+        for (char *slab : slabs_)
+            munmap(slab, SLAB_SIZE);
+    }
+
+    void Unref() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    static unsigned ThreadShard() {
+        static std::atomic<unsigned> next(0);
+        thread_local unsigned shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return shard;
+    }
+
+    char *AllocateRun() {
+        std::lock_guard<std::mutex> lock(slabs_mutex_);
+        if (slab_end_ - slab_cur_ < ptrdiff_t(RUN_SIZE)) {
+            slab_cur_ = MapSlab();
+            slab_end_ = slab_cur_ + SLAB_SIZE;
+            slabs_.push_back(slab_cur_);
+            new (slab_cur_) SlabHeader{this};
+            slab_cur_ += GRANULARITY;
+        }
+        char *res = slab_cur_;
+        slab_cur_ += RUN_SIZE;
+        return res;
+    }
+
+    static char *MapSlab() {
+        // Slabs are aligned by their size, so the header is found from any block address
+        size_t size = 2 * SLAB_SIZE;
+        void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            throw std::bad_alloc();
+
+        uintptr_t start = uintptr_t(mem), slab = (start + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1);
+        if (slab > start)
+            munmap(mem, slab - start);
+        if (start + size > slab + SLAB_SIZE)
+            munmap(reinterpret_cast<void*>(slab + SLAB_SIZE), start + size - slab - SLAB_SIZE);
+#ifdef MADV_HUGEPAGE
+        madvise(reinterpret_cast<void*>(slab), SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<char*>(slab);
+    }
+
+    std::atomic<size_t> refs_;
+    std::array<Shard, SHARDS> shards_;
+    mutable std::mutex slabs_mutex_;
+    char *slab_cur_, *slab_end_;
+    std::vector<char*> slabs_;
+};
@@ -65,11 +65,13 @@ void SHWDistanceExtended(const std::string &target, const std::string &query, in
 }
 
 int SHWDistance(const std::string &a, const std::string &b, int max_score, int &end_pos) {
-    int a_len = (int) a.length();
-    int b_len = (int) b.length();
+    return SHWDistance(a.data(), (int) a.length(), b.data(), (int) b.length(), max_score, end_pos);
+}
+
+int SHWDistance(const char *a, int a_len, const char *b, int b_len, int max_score, int &end_pos) {
     VERIFY(a_len > 0);
     VERIFY(b_len > 0);
-    edlib::EdlibAlignResult result = edlib::edlibAlign(a.c_str(), a_len, b.c_str(), b_len
+    edlib::EdlibAlignResult result = edlib::edlibAlign(a, a_len, b, b_len
                                      , edlib::edlibNewAlignConfig(max_score, edlib::EDLIB_MODE_SHW, edlib::EDLIB_TASK_DISTANCE, NULL, 0));
     int score = std::numeric_limits<int>::max();
     if (result.status == edlib::EDLIB_STATUS_OK && result.editDistance >= 0) {
@@ -81,4 +83,3 @@ int SHWDistance(const std::string &a, const std::string &b, int max_score, int &
     edlib::edlibFreeAlignResult(result);
     return score;
 }
-
@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "nucl.hpp"
+#include "nucl_kernels.hpp"
 #include "sequence.hpp"
 #include "levenshtein.hpp"
 
@@ -33,6 +34,8 @@ void SHWDistanceExtended(const std::string &target, const std::string &query, in
 
 int SHWDistance(const std::string &a, const std::string &b, int max_score, int &end_pos);
 
+int SHWDistance(const char *a, int a_len, const char *b, int b_len, int max_score, int &end_pos);
+
 inline Sequence MergeOverlappingSequences(const std::vector<Sequence>& ss,
         size_t overlap, bool safe_merging = true) {
     if (ss.empty()) {
@@ -124,7 +127,7 @@ inline std::pair<size_t, size_t> LocalSimilarity(const Sequence& s1, const Seque
 
 inline std::string ReverseComplement(const std::string &s) {
     std::string res(s.size(), 0);
-    transform(s.begin(), s.end(), res.rbegin(), nucl_complement); // only difference with reverse is rbegin() instead of begin()
+    nucl_kernels::ReverseComplement(s.data(), s.size(), &res[0]);
     return res;
 }
 
@@ -29,7 +29,7 @@ struct ConstructionStorage {
     using CoverageMap = utils::PerfectHashMap<RtSeq, uint32_t, utils::slim_kmer_index_traits<RtSeq>, utils::DefaultStoring>;
 
     ConstructionStorage(unsigned k)
-            : ext_index(k) {}
+            : ext_index(k), total_nucls(0) {}
 
     utils::DeBruijnExtensionIndex<> ext_index;
 
@@ -40,6 +40,7 @@ struct ConstructionStorage {
     io::ReadStreamList<io::SingleReadSeq> read_streams;
     io::ReadStreamList<io::SingleReadSeq> contigs_streams;
     fs::TmpDir workdir;
+    uint64_t total_nucls;
 };
 
 bool add_trusted_contigs(io::DataSet<config::LibraryData> &libraries,
@@ -149,6 +150,7 @@ void Construction::init(debruijn_graph::GraphPack &gp, const char *) {
         read_count += dataset.reads[lib_id].data().read_count;
     }
 
+    storage().total_nucls = total_nucls;
     dataset.RL = std::max(dataset.no_merge_RL, merged_max_len);
     INFO("Max read length " << dataset.RL);
 
@@ -187,14 +189,24 @@ class CoverageFilter: public Construction::Phase {
         unsigned kplusone = index.k() + 1;
         rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(kplusone);
 
-        INFO("Estimating k-mers cardinality");
-        size_t kmers = EstimateCardinalityUpperBound(kplusone, read_streams, hasher, KmerFilter());
+        if (storage().params.single_pass_cov_filter) {
+            // There cannot be more distinct k-mers than nucleotides in the reads. Start
+            // with a small CQF and expand it while counting
+            storage().cqf.reset(new qf::cqf(1 << 20, qf::cqf::hash_bits_for(storage().total_nucls)));
 
-        // Create main CQF using # of slots derived from estimated # of k-mers
-        storage().cqf.reset(new qf::cqf(kmers));
+            INFO("Building k-mer coverage histogram and estimating k-mers cardinality");
+            FillCoverageHistogramAndEstimateCardinality(*storage().cqf, kplusone, hasher, read_streams, rthr,
+                                                        cfg::get().ds.RL, KmerFilter());
+        } else {
+            INFO("Estimating k-mers cardinality");
+            size_t kmers = EstimateCardinalityUpperBound(kplusone, read_streams, hasher, KmerFilter());
+
+            // Create main CQF using # of slots derived from estimated # of k-mers
+            storage().cqf.reset(new qf::cqf(kmers));
 
-        INFO("Building k-mer coverage histogram");
-        FillCoverageHistogram(*storage().cqf, kplusone, hasher, read_streams, rthr, KmerFilter());
+            INFO("Building k-mer coverage histogram");
+            FillCoverageHistogram(*storage().cqf, kplusone, hasher, read_streams, rthr, KmerFilter());
+        }
 
         // Replace input streams with wrapper ones
         storage().read_streams = io::CovFilteringWrap(std::move(read_streams), kplusone, hasher, *storage().cqf, rthr);
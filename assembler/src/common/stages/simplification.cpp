@@ -31,7 +31,8 @@ SimplifInfoContainer CreateInfoContainer(const GraphPack &gp) {
     SimplifInfoContainer info_container(cfg::get().mode);
     info_container.set_read_length(cfg::get().ds.RL)
             .set_main_iteration(cfg::get().main_iteration)
-            .set_chunk_cnt(5 * cfg::get().max_threads);
+            .set_chunk_cnt(5 * cfg::get().max_threads)
+            .set_concurrent_mutation(cfg::get().simp.concurrent_mutation);
 
     //0 if model didn't converge
     //todo take max with trusted_bound
@@ -398,11 +398,13 @@ AlgoPtr<Graph> SelfConjugateEdgeRemoverInstance(Graph &g, const std::string &con
     ConditionParser<Graph> parser(g, condition_str, info);
     auto condition = func::And(SelfConjugateCondition<Graph>(g), parser());
 
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
                                                                   condition,
                                                                   info.chunk_cnt(),
                                                                   removal_handler,
                                                                   /*canonical_only*/true);
+    algo->set_concurrent(info.concurrent_mutation());
+    return algo;
 }
 
 template<class Graph>
@@ -516,11 +518,13 @@ AlgoPtr<Graph> IsolatedEdgeRemoverInstance(Graph &g,
                                       func::And(LengthUpperBound<Graph>(g, max_length),
                                                CoverageUpperBound<Graph>(g, ier.max_coverage))));
 
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
                                                                   condition,
                                                                   info.chunk_cnt(),
                                                                   removal_handler,
                                                                   /*canonical_only*/true);
+    algo->set_concurrent(info.concurrent_mutation());
+    return algo;
 }
 
 template<class Graph>
@@ -531,11 +535,13 @@ AlgoPtr<Graph> RelativeECRemoverInstance(Graph &g,
     if (!rcec_config.enabled)
         return nullptr;
 
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
             AddRelativeCoverageECCondition(g, rcec_config.rcec_ratio,
                                            AddAlternativesPresenceCondition(g, func::TypedPredicate<typename Graph::EdgeId>
                                                    (LengthUpperBound<Graph>(g, rcec_config.max_ec_length)))),
             info.chunk_cnt(), removal_handler, /*canonical_only*/true);
+    algo->set_concurrent(info.concurrent_mutation());
+    return algo;
 }
 
 template<class Graph>
@@ -546,6 +552,8 @@ AlgoPtr<Graph> ECRemoverInstance(Graph &g,
     if (ec_config.condition.empty())
         return nullptr;
 
+    // Not processed concurrently: the condition might include the topology
+    // checks looking beyond the neighbourhood of the edge
     return std::make_shared<LowCoverageEdgeRemovingAlgorithm<Graph>>(
             g, ec_config.condition, info, removal_handler);
 }
@@ -556,13 +564,15 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
                                   const SimplifInfoContainer &info,
                                   EdgeRemovalHandlerF<Graph> removal_handler = nullptr,
                                   bool track_changes = true) {
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
                                                                         AddTipCondition(g, condition),
                                                                         info.chunk_cnt(),
                                                                         removal_handler,
                                                                         /*canonical_only*/true,
                                                                         LengthComparator<Graph>(g),
                                                                         track_changes);
+    algo->set_concurrent(info.concurrent_mutation());
+    return algo;
 }
 
 template<class Graph>
@@ -594,9 +604,11 @@ AlgoPtr<Graph> DeadEndInstance(Graph &g,
 
     ConditionParser<Graph> parser(g, dead_end_config.condition, info);
     auto condition = parser();
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
             AddDeadEndCondition(g, condition), info.chunk_cnt(), removal_handler, /*canonical_only*/true,
             LengthComparator<Graph>(g), /*track changes*/true);
+    algo->set_concurrent(info.concurrent_mutation());
+    return algo;
 }
 
 template<class Graph>
@@ -683,13 +695,15 @@ AlgoPtr<Graph> LowCoverageEdgeRemoverInstance(Graph &g,
     VERIFY(info.read_length() > g.k());
     double threshold = lcer_config.coverage_threshold * double(info.read_length() - g.k()) / double(info.read_length());
     INFO("Low coverage edge removal (LCER) activated and will remove edges of coverage lower than " << threshold);
-    return std::make_shared<ParallelEdgeRemovingAlgorithm<Graph, CoverageComparator<Graph>>>
+    auto algo = std::make_shared<ParallelEdgeRemovingAlgorithm<Graph, CoverageComparator<Graph>>>
                         (g,
                         CoverageUpperBound<Graph>(g, threshold),
                         info.chunk_cnt(),
                         (EdgeRemovalHandlerF<Graph>)nullptr,
                         /*canonical_only*/true,
                         CoverageComparator<Graph>(g));
+    algo->set_concurrent(info.concurrent_mutation());
+    return algo;
 }
 
 template<class Graph>
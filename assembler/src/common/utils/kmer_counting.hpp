@@ -112,6 +112,23 @@ public:
 
 };
 
+class HllCQFProcessor {
+    HllProcessor hll_processor_;
+    CQFProcessor cqf_processor_;
+public:
+    HllCQFProcessor(hll::hll<> &hll,
+                    CQFKmerFilter &cqf,
+                    CQFKmerFilter &local_cqf,
+                    unsigned thr) :
+            hll_processor_(hll), cqf_processor_(cqf, local_cqf, thr) {
+    }
+
+    void ProcessKmer(const RtSeq &kmer, uint64_t hash) {
+        hll_processor_.ProcessKmer(kmer, hash);
+        cqf_processor_.ProcessKmer(kmer, hash);
+    }
+};
+
 template<class Hasher, class KMerFilter = utils::StoringTypeFilter<utils::SimpleStoring>>
 class HllFiller {
  private:
@@ -138,9 +155,14 @@ class HllFiller {
     //Return value: should we interrupt reads processing
     template <class Read>
     bool operator()(std::unique_ptr<Read> r) {
+        return (*this)(*r);
+    }
+
+    template <class Read>
+    bool operator()(const Read &r) {
         unsigned thread_id = (unsigned)omp_get_thread_num();
         reads[thread_id] += 1;
-        const Sequence &seq = r->sequence();
+        const Sequence &seq = r.sequence();
         if (seq.size() < k) {
             return false;
         }
@@ -173,16 +195,16 @@ size_t EstimateCardinalityForOneStream(unsigned k, ReadStream &streams, const Ha
     size_t n = 15, reads = 0;
     HllFiller<Hasher, KMerFilter> hll_filler(hlls, hasher, filter, k);
 
-    for (size_t i = 0; i < streams.size(); ++i) {
-        while (!streams[i].eof()) {
-            hammer::ReadProcessor rp(nthreads);
-            rp.Run(streams[i], hll_filler);
+    // Parse several streams concurrently, but leave most of the threads for k-mer processing
+    unsigned nproducers = std::max(1u, nthreads / 4);
+    while (!streams.eof()) {
+        hammer::ReadProcessor rp(nthreads);
+        rp.RunParallel(streams, hll_filler, nproducers);
 
-            reads = hll_filler.processed_reads();
-            if (reads >> n) {
-                INFO("Processed " << reads << " reads");
-                n += 1;
-            }
+        reads = hll_filler.processed_reads();
+        if (reads >> n) {
+            INFO("Processed " << reads << " reads");
+            n += 1;
         }
     }
     INFO("Total " << reads << " reads processed");
@@ -269,4 +291,66 @@ void FillCoverageHistogram(qf::cqf &cqf, unsigned k, const Hasher &hasher, ReadS
     INFO("Total " << reads << " reads processed");
 }
 
+// Does the job of EstimateCardinalityUpperBound and FillCoverageHistogram in
+// a single pass over the reads. The CQF might be small initially, but should
+// have the hash bits for all the input k-mers (see qf::cqf::hash_bits_for).
+// It is expanded between the rounds, so the next round always fits in.
+// Returns the estimated # of distinct k-mers.
+template<class Hasher, class ReadStream, class KMerFilter = utils::StoringTypeFilter<utils::SimpleStoring>>
+size_t FillCoverageHistogramAndEstimateCardinality(qf::cqf &cqf, unsigned k, const Hasher &hasher, ReadStream &streams,
+                                                   unsigned thr, size_t max_read_length,
+                                                   const KMerFilter &filter = utils::StoringTypeFilter<utils::SimpleStoring>()) {
+    unsigned stream_num = unsigned(streams.size());
+
+    std::vector<hll::hll<>> hlls(stream_num);
+    std::vector<qf::cqf> local_cqfs;
+    local_cqfs.reserve(stream_num);
+    for (unsigned i = 0; i < stream_num; ++i)
+        local_cqfs.emplace_back(1 << 16, cqf.hash_bits());
+
+    // Every k-mer added occupies at most one more slot, so a round of N reads
+    // from every stream needs N * read_slots free slots
+    uint64_t read_slots = stream_num * (max_read_length >= k ? max_read_length - k + 1 : 1);
+    auto free_slots = [&cqf]() {
+        return cqf.slots() / 10 * 9 - std::min(cqf.slots() / 10 * 9, cqf.occupied_slots());
+    };
+
+    INFO("Counting threshold " << thr);
+    streams.reset();
+    size_t reads = 0, n = 15;
+    while (!streams.eof()) {
+        while (cqf.occupied_slots() > cqf.slots() / 2 || free_slots() < read_slots) {
+            cqf.expand();
+            DEBUG("CQF expanded to " << cqf.slots() << " slots");
+        }
+        size_t round_reads = std::min<uint64_t>(1000000, free_slots() / read_slots);
+
+        #pragma omp parallel for reduction(+:reads)
+        for (unsigned i = 0; i < stream_num; ++i) {
+            HllCQFProcessor processor(hlls[i], cqf, local_cqfs[i], thr);
+            reads += FillFromStream(streams[i], hasher, processor, k, round_reads, filter);
+        }
+
+        // The local filters are counted in the round as well
+        for (unsigned i = 0; i < stream_num; ++i)
+            cqf.merge(local_cqfs[i]);
+
+        if (reads >> n) {
+            INFO("Processed " << reads << " reads");
+            n += 1;
+        }
+    }
+    INFO("Total " << reads << " reads processed");
+
+    for (size_t i = 1; i < hlls.size(); ++i) {
+        hlls[0].merge(hlls[i]);
+        hlls[i].clear();
+    }
+
+    double res = hlls[0].upper_bound_cardinality();
+
+    INFO("Estimated " << size_t(res) << " distinct kmers, CQF has " << cqf.slots() << " slots");
+    return size_t(res);
+}
+
 }
@@ -11,6 +11,8 @@
 
 #include <boomphf/BooPHF.h>
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include <cmath>
 
@@ -51,6 +53,9 @@ private:
   typedef boomphf::mphf<hash_function128> KMerDataIndex;
 
 public:
+  // Number of k-mers looked up simultaneously by the batched seq_idx()
+  static constexpr size_t LOOKUP_BATCH = 16;
+
   KMerIndex(): num_segments_(0), size_(0) {}
 
   KMerIndex(const KMerIndex&) = delete;
@@ -62,6 +67,7 @@ public:
     num_segments_ = 0;
     segment_starts_.clear();
     index_.clear();
+    mapping_.reset();
   }
 
   size_t mem_size() {
@@ -89,6 +95,28 @@ public:
     return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
   }
 
+  // Batched seq_idx(): the k-mers are hashed first and the bit vector words
+  // their lookups start with are prefetched, so the cache misses of the
+  // different k-mers overlap instead of being paid one after another.
+  void seq_idx(const KMerSeq *s, size_t n, size_t *res) const {
+    size_t buckets[LOOKUP_BATCH];
+    boomphf::hash_pair_t hashes[LOOKUP_BATCH];
+
+    for (size_t start = 0; start < n; start += LOOKUP_BATCH) {
+      size_t cnt = std::min(LOOKUP_BATCH, n - start);
+      for (size_t i = 0; i < cnt; ++i) {
+        buckets[i] = seq_bucket(s[start + i]);
+        hashes[i] = index_[buckets[i]].hash(s[start + i]);
+        index_[buckets[i]].prefetch(hashes[i]);
+      }
+
+      for (size_t i = 0; i < cnt; ++i) {
+        size_t idx = index_[buckets[i]].lookup(hashes[i]);
+        res[start + i] = (idx == -1ULL ? idx : segment_starts_[buckets[i]] + idx);
+      }
+    }
+  }
+
   size_t raw_seq_idx(const KMerRawReference data) const {
     size_t bucket = raw_seq_bucket(data);
     size_t idx = index_[bucket].lookup(data);
@@ -120,12 +148,42 @@ public:
     segment_policy_.reset(num_segments_);
   }
 
+  // Saves the index in the layout map() could use in place,
+  // see io::binary::AlignedWriter
+  template<class Writer>
+  void serialize_aligned(Writer &os) const {
+    os.write((char*)&num_segments_, sizeof(num_segments_));
+    for (size_t i = 0; i < num_segments_; ++i)
+      index_[i].save_aligned(os);
+    os.write((char*)&segment_starts_[0], (num_segments_ + 1) * sizeof(segment_starts_[0]));
+  }
+
+  // Uses the bit arrays of the index saved by serialize_aligned() right in
+  // the mapped memory, see io::binary::MappedReader
+  template<class Reader>
+  void map(Reader &is) {
+    clear();
+
+    is.read((char*)&num_segments_, sizeof(num_segments_));
+
+    index_.resize(num_segments_);
+    for (size_t i = 0; i < num_segments_; ++i)
+      index_[i].map(is);
+
+    segment_starts_.resize(num_segments_ + 1);
+    is.read((char*)&segment_starts_[0], (num_segments_ + 1) * sizeof(segment_starts_[0]));
+    count_size();
+    segment_policy_.reset(num_segments_);
+    mapping_ = is.file();
+  }
+
   void swap(KMerIndex<traits> &other) {
     std::swap(index_, other.index_);
     std::swap(num_segments_, other.num_segments_);
     std::swap(size_, other.size_);
     std::swap(segment_starts_, other.segment_starts_);
     std::swap(segment_policy_, other.segment_policy_);
+    std::swap(mapping_, other.mapping_);
   }
 
  private:
@@ -135,6 +193,8 @@ public:
   std::vector<size_t> segment_starts_;
   size_t size_;
   kmer::KMerSegmentPolicy<KMerSeq> segment_policy_;
+  // Keeps the mapped memory alive
+  std::shared_ptr<void> mapping_;
 
   size_t seq_bucket(const KMerSeq &s) const {
     return segment_policy_(s);
@@ -145,4 +205,7 @@ public:
 
   friend class KMerIndexBuilder<__self>;
 };
+
+template<class traits>
+constexpr size_t KMerIndex<traits>::LOOKUP_BATCH;
 }
@@ -23,6 +23,8 @@
 #include "adt/iterator_range.hpp"
 #include "adt/loser_tree.hpp"
 
+#include "threadpool/threadpool.hpp"
+
 #include <boomphf/BooPHF.h>
 
 #include <libcxx/sort.hpp>
@@ -41,6 +43,12 @@
 #include <fstream>
 #include <vector>
 #include <cmath>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace kmers {
 
@@ -191,6 +199,154 @@ class KMerDiskStorage {
 };
 
 
+// Admits bucket merges while their total memory footprint fits into the
+// budget. A merge is always admitted if nothing else is running, so a single
+// huge bucket cannot stall the counting.
+class MergeMemoryBudget {
+ public:
+  explicit MergeMemoryBudget(size_t budget)
+      : budget_(budget), used_(0), active_(0) {}
+
+  void acquire(size_t amount) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return active_ == 0 || used_ + amount <= budget_; });
+    used_ += amount;
+    active_ += 1;
+  }
+
+  void release(size_t amount) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      used_ -= amount;
+      active_ -= 1;
+    }
+    cv_.notify_all();
+  }
+
+  size_t budget() const { return budget_; }
+
+ private:
+  size_t budget_;
+  size_t used_;
+  size_t active_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+// Merge output of a single bucket. The file is opened once, buffers are
+// double-buffered: the filled one is written on the I/O pool while the next
+// one is being merged.
+template<class Seq>
+class KMerBucketWriter {
+ public:
+  KMerBucketWriter(const std::string &fname, unsigned k, size_t capacity,
+                   ThreadPool::ThreadPool &pool)
+      : fname_(fname), pool_(pool), current_(0) {
+    buffers_.reserve(2);
+    buffers_.emplace_back(k, capacity);
+    buffers_.emplace_back(k, capacity);
+    file_ = fopen(fname_.c_str(), "wb");
+    if (!file_)
+      FATAL_ERROR("Cannot open temporary file " << fname_ << " for writing");
+  }
+
+  ~KMerBucketWriter() {
+    close();
+  }
+
+  adt::KMerVector<Seq> &buffer() { return buffers_[current_]; }
+
+  // Hands the current buffer over to the I/O pool
+  void flush() {
+    auto &buf = buffers_[current_];
+    if (buf.size() == 0)
+      return;
+
+    wait();
+    written_ = pool_.run([this, &buf] {
+        size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), file_);
+        if (res != buf.size())
+          FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        buf.clear();
+      });
+    current_ ^= 1;
+  }
+
+  void close() {
+    if (!file_)
+      return;
+
+    flush();
+    wait();
+    if (fclose(file_) != 0)
+      FATAL_ERROR("I/O error! Cannot close " << fname_ << ". Reason: " << strerror(errno) << ". Error code: " << errno);
+    file_ = nullptr;
+  }
+
+ private:
+  void wait() {
+    if (written_.valid())
+      written_.get();
+  }
+
+  std::string fname_;
+  FILE *file_;
+  ThreadPool::ThreadPool &pool_;
+  std::vector<adt::KMerVector<Seq>> buffers_;
+  unsigned current_;
+  std::future<void> written_;
+};
+
+// Read-ahead over the sorted runs of a mapped bucket: asks the kernel for the
+// window of data in front of each run position and drops the pages behind it,
+// so the merge does not fault pages in one by one and its resident size stays
+// within the windows.
+class RunReadAhead {
+ public:
+  RunReadAhead(const void *data, size_t window)
+      : data_(reinterpret_cast<uintptr_t>(data)), page_size_(getpagesize()),
+        window_(std::max(window, page_size_)) {}
+
+  void add_run(size_t from, size_t to) {
+    runs_.push_back({ to, from, from });
+    advance(runs_.size() - 1, from);
+  }
+
+  void advance(size_t run, size_t pos) {
+    auto &r = runs_[run];
+    if (r.prefetched < r.end && pos + window_ / 2 >= r.prefetched) {
+      size_t to = std::min(r.end, std::max(pos, r.prefetched) + window_);
+      advise(r.prefetched / page_size_ * page_size_, to, MADV_WILLNEED);
+      r.prefetched = to;
+    }
+
+    size_t released = pos / page_size_ * page_size_;
+    if (released > r.released) {
+      advise((r.released + page_size_ - 1) / page_size_ * page_size_, released, MADV_DONTNEED);
+      r.released = released;
+    }
+  }
+
+ private:
+  struct Run {
+    size_t end;
+    size_t prefetched;
+    size_t released;
+  };
+
+  void advise(size_t from, size_t to, int advice) {
+    if (from >= to)
+      return;
+    // This is just a hint, so errors are harmless
+    madvise(reinterpret_cast<void*>(data_ + from), to - from, advice);
+  }
+
+  uintptr_t data_;
+  size_t page_size_;
+  size_t window_;
+  std::vector<Run> runs_;
+};
+
 template<class S, class traits = kmer_index_traits<S> >
 class KMerCounter {
 public:
@@ -225,7 +381,8 @@ public:
   template<class Splitter>
   KMerDiskCounter(fs::TmpDir work_dir,
                   Splitter splitter)
-      : __super(splitter.K()), splitter_(new Splitter{std::move(splitter)}), work_dir_(work_dir) {}
+      : __super(splitter.K()), splitter_(new Splitter{std::move(splitter)}), work_dir_(work_dir),
+        memory_budget_(0) {}
 
   template<class Splitter>
   KMerDiskCounter(const std::string &work_dir,
@@ -238,6 +395,9 @@ public:
     return Seq::GetDataSize(this->k()) * sizeof(typename Seq::DataType);
   }
 
+  // Memory (in bytes) for merging the buckets, half of the free memory by default
+  void set_memory_budget(size_t budget) { memory_budget_ = budget; }
+
   KMerDiskStorage<Seq> Count(unsigned num_buckets, unsigned num_threads) override {
     // Split k-mers into buckets.
     INFO("Splitting kmer instances into " << num_buckets << " files using " << num_threads << " threads. This might take a while.");
@@ -246,14 +406,17 @@ public:
     VERIFY(raw_kmers.size() == num_buckets);
     TIME_TRACE_END;
 
-    INFO("Starting k-mer counting.");
+    size_t budget = memory_budget_ ? memory_budget_ : utils::get_free_memory() / 2;
+    INFO("Starting k-mer counting. Memory available for merging: " << (double)budget / 1024.0 / 1024.0 / 1024.0 << " Gb");
     KMerDiskStorage<Seq> res(work_dir_, this->k(), splitter_->bucket_policy());
     size_t kmers = 0;
     {
         TIME_TRACE_SCOPE("KMerDiskCounter::Count");
+        MergeMemoryBudget merge_budget(budget);
+        ThreadPool::ThreadPool io_pool(num_threads);
 #       pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
         for (size_t i = 0; i < raw_kmers.size(); ++i) {
-          kmers += MergeKMers(*raw_kmers[i], *res.create(i));
+          kmers += MergeKMers(*raw_kmers[i], *res.create(i), merge_budget, budget / num_threads, io_pool);
           raw_kmers[i].reset();
         }
     }
@@ -277,23 +440,49 @@ public:
 private:
   std::unique_ptr<kmers::KMerSplitter<Seq>> splitter_;
   fs::TmpDir work_dir_;
+  size_t memory_budget_;
 
-  size_t MergeKMers(const std::string &ifname, const std::string &ofname) {
+  // Keeps the budget acquired for the lifetime of the merge
+  class BudgetGuard {
+   public:
+    BudgetGuard(MergeMemoryBudget &budget, size_t amount)
+        : budget_(budget), amount_(amount) {
+      budget_.acquire(amount_);
+    }
+    ~BudgetGuard() { budget_.release(amount_); }
+
+   private:
+    MergeMemoryBudget &budget_;
+    size_t amount_;
+  };
+
+  size_t MergeKMers(const std::string &ifname, const std::string &ofname,
+                    MergeMemoryBudget &budget, size_t thread_budget,
+                    ThreadPool::ThreadPool &io_pool) {
     MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
+    size_t kmer_bytes = kmer_size();
 
     std::string IdxFileName = ifname + ".idx";
     if (FILE *f = fopen(IdxFileName.c_str(), "rb")) {
       fclose(f);
       MMappedRecordReader<size_t> index(ifname + ".idx", true, -1ULL);
 
-      // INFO("Total runs: " << index.size());
+      // Split the per-thread budget between the read-ahead windows of the
+      // runs and the output buffers
+      size_t nruns = std::max(index.size(), size_t(1));
+      size_t window = std::min(size_t(64) << 20, thread_budget / 2 / nruns);
+      size_t buffer_kmers = std::max(size_t(64) << 10,
+                                     std::min(size_t(1) << 20, thread_budget / 8 / kmer_bytes));
+      BudgetGuard guard(budget, std::min(ins.data_size(), nruns * window) + 2 * buffer_kmers * kmer_bytes);
 
       // Prepare runs
       std::vector<adt::iterator_range<decltype(ins.begin())>> ranges;
+      RunReadAhead readahead(ins.data(), window);
       auto beg = ins.begin();
       for (size_t sz : index) {
         auto end = std::next(beg, sz);
         ranges.push_back(adt::make_range(beg, end));
+        readahead.add_run((beg - ins.begin()) * kmer_bytes, (end - ins.begin()) * kmer_bytes);
         VERIFY(std::is_sorted(beg, end, adt::array_less<typename Seq::DataType>()));
         beg = end;
       }
@@ -302,19 +491,14 @@ private:
       adt::loser_tree<decltype(beg),
               adt::array_less<typename Seq::DataType>> tree(ranges);
 
-      if (tree.empty()) {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        if (!g)
-          FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-        fclose(g);
+      KMerBucketWriter<Seq> writer(ofname, this->k(), buffer_kmers, io_pool);
+      if (tree.empty())
         return 0;
-      }
 
       // Write it down!
-      adt::KMerVector<Seq> buf(this->k(), 1024*1024);
       size_t total = 0;
       while (!tree.empty()) {
-          buf.clear();
+          auto &buf = writer.buffer();
           buf.push_back(tree.pop());
           size_t cnt = 1;
 
@@ -337,18 +521,19 @@ private:
             tree.replay();
 
           total += buf.size();
+          writer.flush();
 
-          FILE *g = fopen(ofname.c_str(), "ab");
-          if (!g)
-            FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-          size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
-          if (res != buf.size())
-            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-          fclose(g);
+          for (size_t i = 0; i < ranges.size(); ++i)
+            readahead.advance(i, (tree.runs()[i].begin() - ins.begin()) * kmer_bytes);
       }
+      writer.close();
 
       return total;
     } else {
+      // Sorting is done in place, so the whole bucket is resident. Account the
+      // output as well, as it goes through the page cache.
+      BudgetGuard guard(budget, 2 * ins.data_size());
+
       // Sort the stuff
       libcxx::sort(ins.begin(), ins.end(), adt::array_less<typename Seq::DataType>());
 
@@ -14,8 +14,11 @@
 #include "utils/memory_limit.hpp"
 #include "utils/logger/logger.hpp"
 
+#include "threadpool/threadpool.hpp"
+
 #include <libcxx/sort.hpp>
 #include <string>
+#include <future>
 #include <cstdio>
 
 namespace kmers {
@@ -57,21 +60,44 @@ public:
     using typename KMerSplitter<Seq>::RawKMers;
 
     KMerSortingSplitter(const std::string &work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0), dump_threads_(1) {}
 
     KMerSortingSplitter(fs::TmpDir work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0), dump_threads_(1) {}
+
+    // The pending dump refers to the splitter it was started by, so it is finished before moving
+    KMerSortingSplitter(KMerSortingSplitter &&other)
+            : KMerSplitter<Seq>(std::move(other.WaitDump())),
+              kmer_buffers_(std::move(other.kmer_buffers_)), dump_buffers_(std::move(other.dump_buffers_)),
+              cell_size_(other.cell_size_), num_files_(other.num_files_), dump_threads_(other.dump_threads_),
+              ostreams_(std::move(other.ostreams_)), bucket_files_(std::move(other.bucket_files_)),
+              bucket_runs_(std::move(other.bucket_runs_)), writer_(std::move(other.writer_)) {
+        other.bucket_files_.clear();
+    }
+
+    ~KMerSortingSplitter() {
+        WaitDump();
+        CloseFiles();
+    }
 
 protected:
     using SeqKMerVector = adt::KMerVector<Seq>;
     using KMerBuffer = std::vector<SeqKMerVector>;
 
+    // Thread buffers are double-buffered: threads fill kmer_buffers_ while the
+    // previous generation (dump_buffers_) is being sorted and written out by the
+    // writer stage.
     std::vector<KMerBuffer> kmer_buffers_;
+    std::vector<KMerBuffer> dump_buffers_;
     size_t cell_size_;
     size_t num_files_;
+    unsigned dump_threads_;
 
     RawKMers PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
         num_files_ = num_files;
+        // Buckets are sorted while the threads fill the next generation, so the writer gets only a small
+        // share of threads not to oversubscribe the cores
+        dump_threads_ = std::max(1u, nthreads / 4);
         this->bucket_.reset(num_files);
 
         // Determine the set of output files
@@ -89,7 +115,8 @@ protected:
 
         if (reads_buffer_size == 0) {
             reads_buffer_size = 536870912ull;
-            size_t mem_limit =  (size_t)((double)(utils::get_free_memory()) / (nthreads * 3));
+            // Two generations of buffers are kept
+            size_t mem_limit =  (size_t)((double)(utils::get_free_memory()) / (2 * nthreads * 3));
             INFO("Memory available for splitting buffers: " << (double)mem_limit / 1024.0 / 1024.0 / 1024.0 << " Gb");
             reads_buffer_size = std::min(reads_buffer_size, mem_limit);
         }
@@ -100,10 +127,25 @@ protected:
 
         INFO("Using cell size of " << cell_size_);
         kmer_buffers_.resize(nthreads);
+        dump_buffers_.resize(nthreads);
         for (unsigned i = 0; i < nthreads; ++i) {
-            KMerBuffer &entry = kmer_buffers_[i];
-            entry.resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
+            kmer_buffers_[i].resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
+            dump_buffers_[i].resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
+        }
+
+        // Bucket files are kept open for the whole splitting. Run sizes are
+        // accumulated in memory and written to .idx files once everything is dumped.
+        bucket_files_.resize(num_files_);
+        bucket_runs_.assign(num_files_, {});
+        for (size_t k = 0; k < num_files_; ++k) {
+            bucket_files_[k] = fopen(out[k]->file().c_str(), "wb");
+            if (!bucket_files_[k])
+                FATAL_ERROR("Cannot open temporary file " << out[k]->file() << " for writing");
         }
+        ostreams_ = out;
+
+        if (!writer_)
+            writer_.reset(new ThreadPool::ThreadPool(1));
 
         return out;
     }
@@ -117,61 +159,94 @@ protected:
         return entry[idx].size() > cell_size_;
     }
 
+    // Hands the filled buffers over to the writer stage and returns as soon as
+    // the previous generation is written, so threads could continue filling.
     void DumpBuffers(const RawKMers &ostreams) {
-        VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
+        VERIFY_MSG(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_,
+                   "Buffers were not prepared for " << ostreams.size() << " files");
+
+        WaitDump();
+        std::swap(kmer_buffers_, dump_buffers_);
+
+        dump_task_ = writer_->run([this] {
+            // Every bucket is owned by a single iteration, so no locking is necessary
+#           pragma omp parallel for num_threads(dump_threads_) schedule(dynamic)
+            for (size_t k = 0; k < num_files_; ++k)
+                DumpBucket(k);
+
+            for (auto & entry : dump_buffers_)
+                for (auto & eentry : entry)
+                    eentry.clear();
+        });
+    }
 
-#   pragma omp parallel for
-        for (size_t k = 0; k < num_files_; ++k) {
-            // Below k is thread id!
-
-            size_t sz = 0;
-            for (size_t i = 0; i < kmer_buffers_.size(); ++i)
-                sz += kmer_buffers_[i][k].size();
-
-            adt::KMerVector<Seq> SortBuffer(this->K_, sz);
-            for (auto & entry : kmer_buffers_) {
-                const auto &buffer = entry[k];
-                for (size_t j = 0; j < buffer.size(); ++j)
-                    SortBuffer.push_back(buffer[j]);
-            }
-            libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
-            auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
-
-#     pragma omp critical
-            {
-                size_t cnt =  it - SortBuffer.begin();
-
-                // Write k-mers
-                FILE *f = fopen(ostreams[k]->file().c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, f);
-                if (res != cnt)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-
-                // Write index
-                f = fopen((ostreams[k]->file() + ".idx").c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                res = fwrite(&cnt, sizeof(cnt), 1, f);
-                if (res != 1)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-            }
+    void ClearBuffers() {
+        WaitDump();
+        CloseFiles();
+        WriteIndices();
+
+        for (auto *buffers : { &kmer_buffers_, &dump_buffers_ })
+            for (auto & entry : *buffers)
+                for (auto & eentry : entry) {
+                    eentry.clear();
+                    eentry.shrink_to_fit();
+                }
+    }
+
+private:
+    RawKMers ostreams_;
+    std::vector<FILE*> bucket_files_;
+    std::vector<std::vector<size_t>> bucket_runs_;
+    std::unique_ptr<ThreadPool::ThreadPool> writer_;
+    std::future<void> dump_task_;
+
+    void DumpBucket(size_t k) {
+        size_t sz = 0;
+        for (const auto &entry : dump_buffers_)
+            sz += entry[k].size();
+
+        adt::KMerVector<Seq> SortBuffer(this->K_, sz);
+        for (const auto &entry : dump_buffers_) {
+            const auto &buffer = entry[k];
+            for (size_t j = 0; j < buffer.size(); ++j)
+                SortBuffer.push_back(buffer[j]);
         }
+        libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
+        auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
+
+        size_t cnt =  it - SortBuffer.begin();
+        size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, bucket_files_[k]);
+        if (res != cnt)
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        bucket_runs_[k].push_back(cnt);
+    }
 
-        for (auto & entry : kmer_buffers_)
-            for (auto & eentry : entry)
-                eentry.clear();
+    KMerSortingSplitter &WaitDump() {
+        if (dump_task_.valid())
+            dump_task_.get();
+        return *this;
     }
 
-    void ClearBuffers() {
-        for (auto & entry : kmer_buffers_)
-            for (auto & eentry : entry) {
-                eentry.clear();
-                eentry.shrink_to_fit();
-            }
+    void CloseFiles() {
+        for (size_t k = 0; k < bucket_files_.size(); ++k) {
+            if (bucket_files_[k] && fclose(bucket_files_[k]) != 0)
+                FATAL_ERROR("I/O error! Cannot close temporary file " << ostreams_[k]->file() << ". Reason: " << strerror(errno));
+        }
+        bucket_files_.clear();
+    }
+
+    void WriteIndices() {
+        for (size_t k = 0; k < bucket_runs_.size(); ++k) {
+            const auto &runs = bucket_runs_[k];
+            FILE *f = fopen((ostreams_[k]->file() + ".idx").c_str(), "wb");
+            if (!f)
+                FATAL_ERROR("Cannot open temporary file " << ostreams_[k]->file() << ".idx for writing");
+            size_t res = fwrite(runs.data(), sizeof(size_t), runs.size(), f);
+            if (res != runs.size())
+                FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+            fclose(f);
+        }
+        bucket_runs_.clear();
     }
 };
 
@@ -47,6 +47,17 @@ public:
         return idx_;
     }
 
+    // Key the index is queried with
+    const Key &index_key() const {
+        return key_;
+    }
+
+    // Sets the index obtained for index_key() elsewhere, e.g. by a batched lookup
+    void set_idx(IdxType idx) {
+        ready_ = true;
+        idx_ = idx;
+    }
+
     SimpleKeyWithHash(const SimpleKeyWithHash &that) noexcept = default;
     SimpleKeyWithHash &operator=(const SimpleKeyWithHash &that) noexcept {
         if (this == &that)
@@ -158,6 +169,18 @@ private:
         return ready_;
     }
 
+    // Key the index is queried with
+    Key index_key() const {
+        return key_.IsMinimal() ? key_ : !key_;
+    }
+
+    // Sets the index obtained for index_key() elsewhere, e.g. by a batched lookup
+    void set_idx(IdxType idx) {
+        ready_ = true;
+        is_minimal_ = key_.IsMinimal();
+        idx_ = idx;
+    }
+
     InvertableKeyWithHash(const InvertableKeyWithHash &that) noexcept = default;
     InvertableKeyWithHash &operator=(const InvertableKeyWithHash &that) noexcept {
         this->key_= that.key_;
@@ -16,6 +16,7 @@
 #include "utils/kmer_mph/kmer_index.hpp"
 #include "utils/verify.hpp"
 
+#include <algorithm>
 #include <vector>
 #include <cstdlib>
 #include <cstdint>
@@ -73,6 +74,17 @@ public:
         clear();
         index_ptr_->deserialize(reader);
     }
+
+    template<class Writer>
+    void SaveAligned(Writer &writer) const {
+        index_ptr_->serialize_aligned(writer);
+    }
+
+    template<class Reader>
+    void Map(Reader &reader) {
+        clear();
+        index_ptr_->map(reader);
+    }
 };
 
 template<class K, class V,
@@ -99,6 +111,30 @@ public:
         return KeyWithHash(key, *index_ptr_);
     }
 
+    /**
+     * Computes the indices of a number of keys at once. The lookups are
+     * interleaved and the value slots of the found keys are prefetched, so
+     * the values might be accessed right away without stalling on memory.
+     */
+    void ResolveKWH(KeyWithHash *kwhs, size_t n) const {
+        constexpr size_t batch = KMerIndexT::LOOKUP_BATCH;
+        KeyType keys[batch];
+        IdxType idx[batch];
+
+        for (size_t start = 0; start < n; start += batch) {
+            size_t cnt = std::min(batch, n - start);
+            for (size_t i = 0; i < cnt; ++i)
+                keys[i] = kwhs[start + i].index_key();
+
+            index_ptr_->seq_idx(keys, cnt, idx);
+            for (size_t i = 0; i < cnt; ++i) {
+                if (KeyBase::valid(idx[i]))
+                    __builtin_prefetch(&data_[idx[i]]);
+                kwhs[start + i].set_idx(idx[i]);
+            }
+        }
+    }
+
     bool valid(const KeyWithHash &kwh) const {
         return KeyBase::valid(kwh.idx());
     }
@@ -147,6 +183,30 @@ public:
         KeyBase::BinRead(reader);
     }
 
+    /**
+     * Saves the map in the layout Map() could use in place, see io::binary::AlignedWriter
+     */
+    template<class Writer>
+    void SaveAligned(Writer &writer) const {
+        size_t sz = data_.size();
+        writer.write((char*)&sz, sizeof(sz));
+        writer.array(data_.data(), sz);
+        KeyBase::SaveAligned(writer);
+    }
+
+    /**
+     * Uses the map saved by SaveAligned() right in the mapped memory, the pages
+     * are read lazily on the first access. The Container should be able to
+     * use the memory it does not own, see adt::mappable_vector
+     */
+    template<class Reader>
+    void Map(Reader &reader) {
+        size_t sz;
+        reader.read((char*)&sz, sizeof(sz));
+        data_.map(reader.template array<V>(sz), sz, reader.file());
+        KeyBase::Map(reader);
+    }
+
     size_t size() const {
         return data_.size();
     }
@@ -155,6 +215,8 @@ public:
     auto value_cbegin() const { return data_.cbegin(); }
     auto value_end() const { return data_.end(); }
     auto value_cend() const { return data_.cend(); }
+    auto value_begin() { return data_.begin(); }
+    auto value_end() { return data_.end(); }
 
     friend struct PerfectHashMapBuilder;
 
@@ -15,14 +15,14 @@
 namespace utils {
 
 struct PerfectHashMapBuilder {
-    template<class K, class V, class traits, class StoringType, class Counter>
+    template<class K, class V, class traits, class StoringType, class Container, class Counter>
     kmers::KMerDiskStorage<typename Counter::Seq>
-    BuildIndex(PerfectHashMap<K, V, traits, StoringType> &index,
+    BuildIndex(PerfectHashMap<K, V, traits, StoringType, Container> &index,
                Counter& counter, size_t bucket_num,
                size_t thread_num, bool save_final = false) const {
         TIME_TRACE_SCOPE("PerfectHashMapBuilder::BuildIndex<Counter>");
 
-        using KMerIndex = typename PerfectHashMap<K, V, traits, StoringType>::KMerIndexT;
+        using KMerIndex = typename PerfectHashMap<K, V, traits, StoringType, Container>::KMerIndexT;
 
         kmers::KMerIndexBuilder<KMerIndex> builder((unsigned)bucket_num, (unsigned)thread_num);
         auto res = builder.BuildIndex(*index.index_ptr_, counter, save_final);
@@ -31,12 +31,12 @@ struct PerfectHashMapBuilder {
         return res;
     }
 
-    template<class K, class V, class traits, class StoringType, class KMerStorage>
-    void BuildIndex(PerfectHashMap<K, V, traits, StoringType> &index,
+    template<class K, class V, class traits, class StoringType, class Container, class KMerStorage>
+    void BuildIndex(PerfectHashMap<K, V, traits, StoringType, Container> &index,
                     const KMerStorage& storage, size_t thread_num) const {
         TIME_TRACE_SCOPE("PerfectHashMapBuilder::BuildIndex<Storage>");
 
-        using KMerIndex = typename PerfectHashMap<K, V, traits, StoringType>::KMerIndexT;
+        using KMerIndex = typename PerfectHashMap<K, V, traits, StoringType, Container>::KMerIndexT;
 
         kmers::KMerIndexBuilder<KMerIndex> builder(0, (unsigned)thread_num);
         builder.BuildIndex(*index.index_ptr_, storage);
@@ -131,15 +131,15 @@ void BuildIndex(KeyStoringMap<K, V, traits, StoringType> &index,
     KeyStoringIndexBuilder().BuildIndex(index, counter, bucket_num, thread_num);
 }
 
-template<class K, class V, class traits, class StoringType, class Counter>
-void BuildIndex(PerfectHashMap<K, V, traits, StoringType> &index,
+template<class K, class V, class traits, class StoringType, class Container, class Counter>
+void BuildIndex(PerfectHashMap<K, V, traits, StoringType, Container> &index,
                 Counter& counter, size_t bucket_num,
                 size_t thread_num, bool save_final = false) {
     PerfectHashMapBuilder().BuildIndex(index, counter, bucket_num, thread_num, save_final);
 }
 
-template<class K, class V, class traits, class StoringType, class KMerStorage>
-void BuildIndex(PerfectHashMap<K, V, traits, StoringType> &index,
+template<class K, class V, class traits, class StoringType, class Container, class KMerStorage>
+void BuildIndex(PerfectHashMap<K, V, traits, StoringType, Container> &index,
                 const KMerStorage& storage, size_t thread_num) {
     PerfectHashMapBuilder().BuildIndex(index, storage, thread_num);
 }
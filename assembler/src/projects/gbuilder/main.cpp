@@ -173,28 +173,33 @@ int main(int argc, char* argv[]) {
 
         // Step 2: extract unbranching paths
         bool keep_perfect_loops = true;
-        std::vector<Sequence> edge_sequences;
         unsigned nchunks = 16 * omp_get_max_threads();
-        if (keep_perfect_loops)
-            edge_sequences = debruijn_graph::UnbranchingPathExtractor(ext_index, k).ExtractUnbranchingPathsAndLoops(nchunks);
-        else
-            edge_sequences = debruijn_graph::UnbranchingPathExtractor(ext_index, k).ExtractUnbranchingPaths(nchunks);
+        debruijn_graph::UnbranchingPathExtractor extractor(ext_index, k);
 
         if (cfg.mode == output_type::unitigs) {
+            debruijn_graph::SequenceChunks edge_sequences;
+            if (keep_perfect_loops)
+                edge_sequences = extractor.ExtractUnbranchingPathsAndLoops(nchunks);
+            else
+                edge_sequences = extractor.ExtractUnbranchingPaths(nchunks);
+
             // Step 3: output stuff
 
             INFO("Saving unitigs to " << cfg.outfile);
             size_t idx = 1;
             std::ofstream f(cfg.outfile);
-            for (const auto &edge: edge_sequences) {
-                f << std::string(">") << io::MakeContigId(idx++, edge.size(), "EDGE") << std::endl;
-                io::WriteWrapped(edge.str(), f);
+            for (const auto &chunk: edge_sequences) {
+                for (const auto &edge: chunk) {
+                    f << std::string(">") << io::MakeContigId(idx++, edge.size(), "EDGE") << std::endl;
+                    io::WriteWrapped(edge.str(), f);
+                }
             }
         } else {
-            // Step 3: build the graph
+            // Step 3: build the graph, the paths are turned into the edges as they are extracted
             INFO("Building graph");
             debruijn_graph::DeBruijnGraph g(k);
-            debruijn_graph::FastGraphFromSequencesConstructor<debruijn_graph::DeBruijnGraph>(k, ext_index).ConstructGraph(g, edge_sequences);
+            debruijn_graph::FastGraphFromSequencesConstructor<debruijn_graph::DeBruijnGraph>(k, ext_index)
+                    .ConstructGraph(g, extractor, nchunks, keep_perfect_loops);
 
             // Step 4: infer coverage
             if (cfg.coverage) {
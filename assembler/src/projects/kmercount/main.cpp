@@ -126,6 +126,7 @@ struct Args {
     unsigned K = 21;
     std::string workdir, dataset = "";
     size_t read_buffer_size = 536870912;
+    size_t merge_memory = 0;
     std::vector<std::string> input;
 };
 }
@@ -140,6 +141,7 @@ void process_cmdline(int argc, char **argv, kmer_count::Args &args) {
         (option("-t", "--threads") & integer("value", args.nthreads)) % "# of threads to use",
         (option("-w", "--workdir") & value("dir", args.workdir)) % "Working directory to use",
         (option("-b", "--bufsize") & integer("value", args.read_buffer_size)) % "Sorting buffer size, per thread",
+        (option("-m", "--merge-memory") & integer("value", args.merge_memory)) % "Memory for merging k-mer buckets (in Mb), half of the free memory by default",
         (option("-h", "--help").set(print_help)) % "Show help",
         opt_values("input files", args.input)
     );
@@ -212,6 +214,7 @@ int main(int argc, char* argv[]) {
         }
 
         kmers::KMerDiskCounter<RtSeq> counter(args.workdir, std::move(splitter));
+        counter.set_memory_budget(args.merge_memory << 20);
         auto res = counter.CountAll(16, args.nthreads, /* merge */ true);
         auto final_kmers = res.final_kmers();
 
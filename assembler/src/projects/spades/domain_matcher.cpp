@@ -22,6 +22,9 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,16 +35,90 @@ extern "C" {
 
 namespace nrps {
 
-static void MatchContigsInternal(hmmer::HMMMatcher &matcher, const path_extend::BidirectionalPath &path,
-                                 const std::string &path_string,
-                                 const std::string &type, const std::string &desc,
-                                 ContigAlnInfo &res, io::OFastaReadStream &oss_contig, size_t model_length,
-                                 bool isAA = true) {
+namespace {
+
+// Scaffold strand to be matched, shared by all the HMMs
+struct MatchTarget {
+    const path_extend::BidirectionalPath *path;
+    std::string nucls;
+    // Translations of the three frames, filled only if there are AA models
+    std::array<std::string, 3> aas;
+};
+
+// Contiguous range of targets matched with one HMM
+struct MatchItem {
+    size_t hmm;
+    size_t from, to;
+};
+
+struct MatchResult {
+    ContigAlnInfo alns;
+    // Hit scaffolds are written only after all the items are processed to keep the output order
+    std::vector<const MatchTarget*> contigs;
+};
+
+}
+
+static std::vector<MatchTarget> CollectTargets(const path_extend::PathContainer &contig_paths,
+                                               const path_extend::ScaffoldSequenceMaker &scaffold_maker,
+                                               bool translate) {
+    std::vector<MatchTarget> res;
+    for (auto iter = contig_paths.begin(); iter != contig_paths.end(); ++iter) {
+        if (iter.get().Length() <= 0)
+            continue;
+        res.push_back({ &iter.get(), "", {} });
+
+        if (iter.getConjugate().Length() <= 0)
+            continue;
+        res.push_back({ &iter.getConjugate(), "", {} });
+    }
+
+#   pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < res.size(); ++i) {
+        auto &target = res[i];
+        target.nucls = scaffold_maker.MakeSequence(*target.path);
+        if (!translate)
+            continue;
+        for (size_t shift = 0; shift < 3; ++shift)
+            target.aas[shift] = aa::translate(target.nucls.c_str() + shift);
+    }
+
+    return res;
+}
+
+// Splits the targets into chunks of similar total length, so there are enough work items to keep all
+// the threads busy even if there are few HMMs
+static std::vector<std::pair<size_t, size_t>> SplitTargets(const std::vector<MatchTarget> &targets,
+                                                           size_t hmm_count) {
+    size_t total_length = 0;
+    for (const auto &target : targets)
+        total_length += target.nucls.size();
+    size_t chunks = std::max<size_t>(1, 4 * omp_get_max_threads() / std::max<size_t>(1, hmm_count));
+    size_t chunk_length = std::max<size_t>(1, (total_length + chunks - 1) / chunks);
+
+    std::vector<std::pair<size_t, size_t>> res;
+    size_t from = 0, length = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        length += targets[i].nucls.size();
+        if (length >= chunk_length || i + 1 == targets.size()) {
+            res.emplace_back(from, i + 1);
+            from = i + 1;
+            length = 0;
+        }
+    }
+    return res;
+}
+
+static void MatchTargetInternal(hmmer::HMMMatcher &matcher, const MatchTarget &target,
+                                const std::string &type, const std::string &desc,
+                                MatchResult &res, size_t model_length,
+                                bool isAA = true) {
+    const path_extend::BidirectionalPath &path = *target.path;
+    const std::string &path_string = target.nucls;
     if (isAA) {
         for (size_t shift = 0; shift < 3; ++shift) {
             std::string ref_shift = std::to_string(path.GetId()) + "_" + std::to_string(shift);
-            std::string seq_aas = aa::translate(path_string.c_str() + shift);
-            matcher.match(ref_shift.c_str(), seq_aas.c_str());
+            matcher.match(ref_shift.c_str(), target.aas[shift].c_str());
         }
     } else {
             std::string ref_shift = std::to_string(path.GetId()) + "_0";
@@ -67,49 +144,27 @@ static void MatchContigsInternal(hmmer::HMMMatcher &matcher, const path_extend::
             seqpos.second = seqpos.second * (isAA ? 3 : 1)  + shift;
 
             std::string name(hit.name());
-#pragma omp critical
-            {
-                oss_contig << io::SingleRead(name, path_string);
-            }
+            res.contigs.push_back(&target);
             DEBUG(name);
             DEBUG("First - " << seqpos.first << ", second - " << seqpos.second);
-            res.push_back({name, type, desc,
-                           unsigned(seqpos.first), unsigned(seqpos.second),
-                           path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
+            res.alns.push_back({name, type, desc,
+                                unsigned(seqpos.first), unsigned(seqpos.second),
+                                path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
         }
     }
     matcher.reset_top_hits();
 }
 
-static void MatchContigs(const path_extend::PathContainer &contig_paths, const path_extend::ScaffoldSequenceMaker &scaffold_maker,
-                         const hmmer::HMM &hmm, const hmmer::hmmer_cfg &cfg,
-                         ContigAlnInfo &res, io::OFastaReadStream &oss_contig) {
-    DEBUG("Total contigs: " << contig_paths.size());
-    DEBUG("Model length - " << hmm.length());
-    hmmer::HMMMatcher matcher(hmm, cfg);
+static void MatchTargets(const std::vector<MatchTarget> &targets, size_t from, size_t to,
+                         hmmer::HMMMatcher &matcher, const hmmer::HMM &hmm,
+                         MatchResult &res) {
     bool isAA = hmm.abc()->type == eslAMINO;
-    for (auto iter = contig_paths.begin(); iter != contig_paths.end(); ++iter) {
-        const path_extend::BidirectionalPath &path = iter.get();
-        if (path.Length() <= 0)
-            continue;
-
-        std::string path_string = scaffold_maker.MakeSequence(path);
-        MatchContigsInternal(matcher, path, path_string,
-                             hmm.name(), hmm.desc() ? hmm.desc() : "",
-                             res, oss_contig, hmm.length(), isAA);
-
-        const path_extend::BidirectionalPath& conj_path = iter.getConjugate();
-        if (conj_path.Length() <= 0)
-            continue;
-
-        std::string path_string_conj = scaffold_maker.MakeSequence(conj_path);
-        MatchContigsInternal(matcher, conj_path, path_string_conj,
-                             hmm.name(), hmm.desc() ? hmm.desc() : "",
-                             res, oss_contig, hmm.length(), isAA);
-    }
+    for (size_t i = from; i < to; ++i)
+        MatchTargetInternal(matcher, targets[i],
+                            hmm.name(), hmm.desc() ? hmm.desc() : "",
+                            res, hmm.length(), isAA);
 }
 
-
 static void ParseHMMFile(std::vector<hmmer::HMM> &hmms, const std::string &filename) {
     auto hmmfile = hmmer::open_file(filename);
     if (std::error_code ec = hmmfile.getError()) {
@@ -198,24 +253,46 @@ ContigAlnInfo DomainMatcher::MatchDomains(debruijn_graph::GraphPack &gp,
     // so it will be a bit conservative for nucleotide HMMs / sequences
     hcfg.Z = 3 * broken_scaffolds.size();
 
-#   pragma omp parallel for
+    bool translate = std::any_of(hmms.begin(), hmms.end(),
+                                 [](const hmmer::HMM &hmm) { return hmm.abc()->type == eslAMINO; });
+    auto targets = CollectTargets(broken_scaffolds, scaffold_maker, translate);
+    auto chunks = SplitTargets(targets, hmms.size());
+    INFO("Matching " << hmms.size() << " models with " << targets.size() << " scaffold strands in "
+         << chunks.size() << " chunks");
+
+    std::vector<MatchItem> items;
     for (size_t i = 0; i < hmms.size(); ++i) {
-        ContigAlnInfo local_res;
-        std::string name = hmms[i].name();
-#       pragma omp critical
-        {
-            INFO("Matching contigs with " << name);
+        for (const auto &chunk : chunks)
+            items.push_back({ i, chunk.first, chunk.second });
+    }
+
+    // Consecutive items mostly share the model, so the matcher of the thread is rebuilt only on its change
+    std::vector<MatchResult> results(items.size());
+    std::vector<std::unique_ptr<hmmer::HMMMatcher>> matchers(omp_get_max_threads());
+    std::vector<size_t> matcher_hmms(matchers.size(), -1ull);
+#   pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto &item = items[i];
+        size_t thread = omp_get_thread_num();
+        if (matcher_hmms[thread] != item.hmm) {
+            matchers[thread].reset(new hmmer::HMMMatcher(hmms[item.hmm], hcfg));
+            matcher_hmms[thread] = item.hmm;
         }
 
-        MatchContigs(broken_scaffolds, scaffold_maker,
-                     hmms[i], hcfg,
-                     local_res, oss_contig);
+        MatchTargets(targets, item.from, item.to, *matchers[thread], hmms[item.hmm], results[i]);
+    }
 
-#       pragma omp critical
-        {
-            INFO("Matches for '" << name << "': " << local_res.size());
-            res.insert(res.end(), std::make_move_iterator(local_res.begin()), std::make_move_iterator(local_res.end()));
+    for (size_t i = 0, j = 0; i < hmms.size(); ++i) {
+        size_t matches = 0;
+        for (; j < items.size() && items[j].hmm == i; ++j) {
+            auto &result = results[j];
+            for (size_t k = 0; k < result.alns.size(); ++k)
+                oss_contig << io::SingleRead(result.alns[k].name, result.contigs[k]->nucls);
+            matches += result.alns.size();
+            res.insert(res.end(), std::make_move_iterator(result.alns.begin()), std::make_move_iterator(result.alns.end()));
+            result = MatchResult();
         }
+        INFO("Matches for '" << hmms[i].name() << "': " << matches);
     }
 
     INFO("Total domain matches: " << res.size());
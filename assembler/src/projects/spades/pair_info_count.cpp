@@ -12,7 +12,9 @@
 #include "paired_info/pair_info_filler.hpp"
 
 #include "modules/alignment/long_read_mapper.hpp"
+#include "modules/alignment/mapping_path_cache.hpp"
 #include "modules/alignment/bwa_sequence_mapper.hpp"
+#include "modules/alignment/minimizer_mapper.hpp"
 #include "modules/alignment/rna/ss_coverage_filler.hpp"
 
 #include "io/dataset_support/read_converter.hpp"
@@ -28,11 +30,23 @@ namespace debruijn_graph {
 namespace {
 
 using SequencingLib = io::SequencingLibrary<config::LibraryData>;
-using PairedInfoFilter = bf::counting_bloom_filter<std::pair<EdgeId, EdgeId>, 2>;
+
+struct EdgePairHash {
+    uint64_t operator()(const std::pair<EdgeId, EdgeId> &e) const {
+        uint64_t h1 = e.first.hash();
+
+        return XXH3_64bits_withSeed(&h1, sizeof(h1), e.second.hash());
+    }
+};
+
+using PairedInfoFilter = bf::blocked_counting_bloom_filter<std::pair<EdgeId, EdgeId>, EdgePairHash, 2>;
 using EdgePairCounter = hll::hll_with_hasher<std::pair<EdgeId, EdgeId>>;
 
+using ReadMinimizerIndex = MinimizerIndex<Graph>;
+
 std::shared_ptr<SequenceMapper<Graph>> ChooseProperMapper(const GraphPack& gp,
-                                                          const SequencingLib& library) {
+                                                          const SequencingLib& library,
+                                                          const ReadMinimizerIndex *minimizer_index = nullptr) {
     const auto &graph = gp.get<Graph>();
 
     if (library.type() == io::LibraryType::MatePairs) {
@@ -45,10 +59,39 @@ std::shared_ptr<SequenceMapper<Graph>> ChooseProperMapper(const GraphPack& gp,
         return std::make_shared<alignment::BWAReadMapper<Graph>>(graph);
     }
 
+    if (minimizer_index) {
+        INFO("Selecting minimizer mapper");
+        return std::make_shared<MinimizerSequenceMapper<Graph>>(graph, *minimizer_index);
+    }
+
     INFO("Selecting usual mapper");
     return MapperInstance(gp);
 }
 
+// Paired reads of a library are mapped several times (insert size estimation,
+// filtering and the paired info collection) while the graph stays the same
+template<class ReadType>
+void ProcessLibrary(SequenceMapperNotifier &notifier, io::ReadStreamList<ReadType> &streams,
+                    size_t ilib, const SequenceMapper<Graph> &mapper,
+                    const Graph &graph, const std::string &cache_prefix) {
+    if (!cfg::get().cache_read_mappings) {
+        notifier.ProcessLibrary(streams, ilib, mapper);
+        return;
+    }
+
+    MappingPathCache cache(cache_prefix, graph);
+    notifier.ProcessLibrary(streams, ilib, mapper, cache);
+}
+
+// Minimizer and exact k-mer mappers produce different paths for the same
+// graph, so they should not share the cached ones
+std::string PairedCachePrefix(const SequencingLib &lib, const ReadMinimizerIndex *minimizer_index) {
+    std::string prefix = lib.data().binary_reads_info.paired_read_prefix + "_paths";
+    if (minimizer_index)
+        prefix += "_mm" + std::to_string(minimizer_index->window());
+    return prefix;
+}
+
 class DEFilter : public SequenceMapperListener {
   public:
     DEFilter(PairedInfoFilter &filter, const Graph &g)
@@ -84,18 +127,12 @@ class DEFilter : public SequenceMapperListener {
 };
 
 class EdgePairCounterFiller : public SequenceMapperListener {
-    static uint64_t EdgePairHash(const std::pair<EdgeId, EdgeId> &e) {
-        uint64_t h1 = e.first.hash();
-
-        return XXH3_64bits_withSeed(&h1, sizeof(h1), e.second.hash());
-    }
-
   public:
     EdgePairCounterFiller(size_t thread_num)
-            : counter_(EdgePairHash) {
+            : counter_(EdgePairHash()) {
         buf_.reserve(thread_num);
         for (unsigned i = 0; i < thread_num; ++i)
-          buf_.emplace_back(EdgePairHash);
+          buf_.emplace_back(EdgePairHash());
     }
 
     void MergeBuffer(size_t i) override {
@@ -198,7 +235,8 @@ bool ShouldObtainSingleReadsPaths(size_t ilib) {
 
 bool CollectLibInformation(const GraphPack &gp,
                            size_t &edgepairs,
-                           size_t ilib, size_t edge_length_threshold) {
+                           size_t ilib, size_t edge_length_threshold,
+                           const ReadMinimizerIndex *minimizer_index) {
     INFO("Estimating insert size (takes a while)");
     InsertSizeCounter hist_counter(gp.get<Graph>(), edge_length_threshold);
     EdgePairCounterFiller pcounter(cfg::get().max_threads);
@@ -212,7 +250,8 @@ bool CollectLibInformation(const GraphPack &gp,
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
                                                 /*include_merged*/true);
 
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    ProcessLibrary(notifier, paired_streams, ilib, *ChooseProperMapper(gp, reads, minimizer_index),
+                   gp.get<Graph>(), PairedCachePrefix(reads, minimizer_index));
     //Check read length after lib processing since mate pairs a not used until this step
     VERIFY(reads.data().unmerged_read_length != 0);
 
@@ -271,7 +310,8 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
     auto mapper_ptr = ChooseProperMapper(gp, reads);
     if (use_binary) {
         auto single_streams = single_binary_readers(reads, false, map_paired);
-        notifier.ProcessLibrary(single_streams, ilib, *mapper_ptr);
+        ProcessLibrary(notifier, single_streams, ilib, *mapper_ptr, graph,
+                       reads.data().binary_reads_info.single_read_prefix + (map_paired ? "_all_paths" : "_paths"));
     } else {
         auto single_streams = single_easy_readers(reads, false,
                                                   map_paired, /*handle Ns*/false);
@@ -285,7 +325,8 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
 void ProcessPairedReads(GraphPack &gp,
                                std::unique_ptr<PairedInfoFilter> filter,
                                unsigned filter_threshold,
-                               size_t ilib) {
+                               size_t ilib,
+                               const ReadMinimizerIndex *minimizer_index) {
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     const auto &data = reads.data();
 
@@ -320,7 +361,8 @@ void ProcessPairedReads(GraphPack &gp,
 
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
                                                 /*include merged*/true);
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    ProcessLibrary(notifier, paired_streams, ilib, *ChooseProperMapper(gp, reads, minimizer_index),
+                   gp.get<Graph>(), PairedCachePrefix(reads, minimizer_index));
 }
 
 } // namespace
@@ -337,6 +379,15 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
         edge_length_threshold = std::max(edge_length_threshold, Nx(graph, 50));
 
     INFO("Min edge length for estimation: " << edge_length_threshold);
+
+    // The graph is not modified by the stage, so the index is shared by all libraries
+    std::unique_ptr<ReadMinimizerIndex> minimizer_index;
+    if (cfg::get().mm.pair_info_count) {
+        INFO("Building minimizer index, window " << cfg::get().mm.window);
+        minimizer_index.reset(new ReadMinimizerIndex(graph, cfg::get().mm.window));
+        minimizer_index->Refill();
+    }
+
     for (size_t i = 0; i < cfg::get().ds.reads.lib_count(); ++i) {
         auto &lib = cfg::get_writable().ds.reads[i];
         if (lib.is_hybrid_lib()) {
@@ -353,7 +404,7 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
                 size_t k = cfg::get().K;
 
                 size_t edgepairs = 0;
-                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold)) {
+                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold, minimizer_index.get())) {
                     cfg::get_writable().ds.reads[i].data().mean_insert_size = 0.0;
                     WARN("Unable to estimate insert size for paired library #" << i);
                     if (rl > 0 && rl <= k) {
@@ -381,11 +432,7 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
 
                 // Only filter paired-end libraries
                 if (filter_threshold && lib.type() == io::LibraryType::PairedEnd) {
-                    filter.reset(new PairedInfoFilter([](const std::pair<EdgeId, EdgeId> &e, uint64_t seed) {
-                                uint64_t h1 = e.first.hash();
-                                return XXH3_64bits_withSeed(&h1, sizeof(h1), (e.second.hash() * seed) ^ seed);
-                            },
-                            12 * edgepairs));
+                    filter.reset(new PairedInfoFilter(12 * edgepairs));
 
                     INFO("Filtering data for library #" << i);
                     {
@@ -395,14 +442,15 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
 
                         VERIFY(lib.data().unmerged_read_length != 0);
                         auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true);
-                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib));
+                        ProcessLibrary(notifier, reads, i, *ChooseProperMapper(gp, lib, minimizer_index.get()),
+                                       graph, PairedCachePrefix(lib, minimizer_index.get()));
                     }
                 }
 
                 INFO("Mapping library #" << i);
                 if (lib.data().mean_insert_size != 0.0) {
                     INFO("Mapping paired reads (takes a while) ");
-                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i);
+                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i, minimizer_index.get());
                 }
             }
 
@@ -414,6 +462,15 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
             }
         }
     }
+
+    // The graph is changed by the next stages, so the stored paths are not needed anymore
+    if (cfg::get().cache_read_mappings) {
+        for (const auto &lib : cfg::get().ds.reads) {
+            MappingPathCache::Remove(PairedCachePrefix(lib, minimizer_index.get()));
+            for (const char *suffix : { "_paths", "_all_paths" })
+                MappingPathCache::Remove(lib.data().binary_reads_info.single_read_prefix + suffix);
+        }
+    }
 }
 
 } // namespace debruijn_graph
@@ -237,7 +237,9 @@ void assemble_genome() {
                                             cfg::get().ds.reference_genome,
                                             cfg::get().flanking_range,
                                             cfg::get().pos.max_mapping_gap,
-                                            cfg::get().pos.max_gap_diff);
+                                            cfg::get().pos.max_gap_diff,
+                                            /* detach_indices */ true,
+                                            cfg::get().sequence_arena);
     if (cfg::get().need_mapping) {
         INFO("Will need read mapping, kmer mapper will be attached");
         conj_gp.get_mutable<debruijn_graph::KmerMapper<debruijn_graph::Graph>>().Attach();
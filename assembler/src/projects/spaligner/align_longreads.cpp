@@ -15,16 +15,25 @@
 #include "assembly_graph/core/graph.hpp"
 #include "utils/logger/log_writers.hpp"
 #include "modules/alignment/pacbio/g_aligner.hpp"
+#include "io/reads/mpmc_bounded.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include "mapping_printer.hpp"
 
 #include "llvm/Support/YAMLParser.h"
 #include "llvm/Support/YAMLTraits.h"
 
+#include <atomic>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <thread>
 #include <clipp/clipp.h>
 
+#include <sched.h>
+#include <unistd.h>
+
 using namespace std;
 
 void create_console_logger() {
@@ -43,6 +52,7 @@ template<> struct MappingTraits<debruijn_graph::config::pacbio_processor> {
         io.mapRequired("path_limit_pressing", cfg.path_limit_pressing);
         io.mapRequired("max_path_in_chaining", cfg.max_path_in_dijkstra);
         io.mapRequired("max_vertex_in_chaining", cfg.max_vertex_in_dijkstra);
+        io.mapOptional("distance_cache_size", cfg.distance_cache_size);
     }
 };
 
@@ -81,6 +91,7 @@ template<> struct MappingTraits<sensitive_aligner::GAlignerConfig> {
         io.mapRequired("output_format", cfg.output_format);
         io.mapRequired("run_dijkstra", cfg.gap_cfg.run_dijkstra);
         io.mapRequired("restore_ends", cfg.restore_ends);
+        io.mapOptional("ordered_output", cfg.ordered_output);
 
         io.mapRequired("hits_generation", cfg.pb);
         io.mapRequired("gap_closing", cfg.gap_cfg);
@@ -103,33 +114,175 @@ class LongReadsAligner {
         : g_(g),
           cfg_(cfg),
           galigner_(g_, cfg),
-          threads_(threads),
+          threads_(std::max(threads, 1)),
           mapping_printer_hub_(g_, edge_namer, output_dir, cfg.output_format) {
         aligned_reads_ = 0;
         processed_reads_ = 0;
     }
 
+    // The reads are loaded, aligned and written concurrently: the reader thread fills the chunks of reads, the
+    // aligner threads take the chunks from the shared queue as they become free, the writer thread outputs the
+    // formatted alignments of the finished chunks. Chunks are recycled, so the number of reads in flight is bounded.
+    // The reader and the writer mostly wait for I/O, so together they take the place of a single aligner.
     void RunAligner() {
         auto read_stream = io::FixingWrapper(io::FileReadStream(cfg_.path_to_sequences));
-        size_t n = 0;
-        size_t buffer_no = 0;
-        while (!read_stream.eof()) {
-            std::vector<io::SingleRead> read_buffer;
-            read_buffer.reserve(read_buffer_size);
-            io::SingleRead read;
-            for (size_t buf_size = 0; buf_size < read_buffer_size && !read_stream.eof(); ++buf_size) {
-                read_stream >> read;
-                read_buffer.push_back(move(read));
+
+        int aligners = std::max(threads_ - 1, 1);
+        size_t nchunks = 2;
+        while (nchunks < 4 * size_t(aligners))
+            nchunks *= 2;
+        std::vector<std::unique_ptr<ReadChunk>> pool;
+        mpmc_bounded_queue<ReadChunk*> free_queue(nchunks), work_queue(nchunks), done_queue(nchunks);
+        for (size_t i = 0; i < nchunks; ++i) {
+            pool.emplace_back(new ReadChunk(mapping_printer_hub_.size()));
+            free_queue.enqueue(pool.back().get());
+        }
+
+        // Idle time of every thread
+        double reader_idle = 0, writer_idle = 0;
+        std::vector<double> idle(aligners, 0.);
+        std::atomic<int> aligners_done(0);
+        utils::perf_counter pc;
+        // Started outside of the OpenMP region, so they run whatever number of aligner threads is granted
+        std::thread reader([&] {
+            size_t id = 0;
+            while (!read_stream.eof()) {
+                ReadChunk *chunk;
+                Dequeue(free_queue, chunk, reader_idle);
+                chunk->Fill(id++, read_stream);
+                Enqueue(work_queue, chunk);
             }
-            INFO("Prepared batch " << buffer_no << " of " << read_buffer.size() << " reads.");
-            AlignBatch(read_buffer);
-            ++buffer_no;
-            n += read_buffer.size();
-            INFO("Processed " << n << " reads");
+            work_queue.close();
+        });
+        std::thread writer([&] { WriteChunks(done_queue, free_queue, writer_idle); });
+
+        #pragma omp parallel num_threads(aligners)
+        {
+            #pragma omp single
+            aligners = omp_get_num_threads();
+
+            ReadChunk *chunk;
+            while (Dequeue(work_queue, chunk, idle[omp_get_thread_num()])) {
+                AlignChunk(*chunk);
+                Enqueue(done_queue, chunk);
+            }
+            // The last aligner to finish closes the queue
+            if (aligners_done.fetch_add(1) + 1 == aligners)
+                done_queue.close();
         }
+        reader.join();
+        writer.join();
+
+        double time = pc.time();
+        double aligners_idle = 0;
+        for (int i = 0; i < aligners; ++i)
+            aligners_idle += idle[i];
+        INFO("Processed " << processed_reads_ << " reads in " << time << " s (" << double(processed_reads_) / time
+             << " reads/s), aligned " << aligned_reads_);
+        INFO("Idle time: reader " << reader_idle << " s, aligners " << aligners_idle / aligners
+             << " s per thread, writer " << writer_idle << " s");
     }
 
   private:
+    struct ReadChunk {
+        size_t id = 0;
+        size_t size = 0;
+        // Reads are reused between the chunks, only the first size ones are valid
+        std::vector<io::SingleRead> reads;
+        // Formatted alignments per printer
+        std::vector<std::string> output;
+
+        explicit ReadChunk(size_t printers)
+                : output(printers) {}
+
+        template<class Stream>
+        void Fill(size_t chunk_id, Stream &stream) {
+            id = chunk_id;
+            size = 0;
+            size_t bases = 0;
+            // Reads are taken up to the total length, so the chunks of long reads are smaller
+            while (size < max_chunk_reads && bases < chunk_bases && !stream.eof()) {
+                if (size == reads.size())
+                    reads.emplace_back();
+                stream >> reads[size];
+                bases += reads[size].size();
+                ++size;
+            }
+        }
+    };
+
+    template<class T>
+    static void Enqueue(mpmc_bounded_queue<T> &queue, T data) {
+        while (!queue.enqueue(data))
+            sched_yield();
+    }
+
+    // Waits for the element and adds the waiting time to idle. Returns false if the queue is closed and empty.
+    template<class T>
+    static bool Dequeue(mpmc_bounded_queue<T> &queue, T &data, double &idle) {
+        if (queue.dequeue(data))
+            return true;
+
+        utils::perf_counter pc;
+        bool res = false;
+        while (!res) {
+            res = queue.dequeue(data);
+            if (!res && queue.is_closed()) {
+                // Queue might be closed right after the last element was enqueued
+                res = queue.dequeue(data);
+                break;
+            }
+            if (!res)
+                usleep(100);
+        }
+        idle += pc.time();
+        return res;
+    }
+
+    void AlignChunk(ReadChunk &chunk) const {
+        for (auto &output : chunk.output)
+            output.clear();
+
+        for (size_t i = 0; i < chunk.size; ++i) {
+            const io::SingleRead &read = chunk.reads[i];
+            OneReadMapping res = AlignRead(read);
+            if (res.edge_paths.size() > 0) {
+                for (size_t j = 0; j < chunk.output.size(); ++j)
+                    chunk.output[j] += mapping_printer_hub_.Format(j, res, read);
+                aligned_reads_.fetch_add(1, std::memory_order_relaxed);
+            }
+            processed_reads_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void WriteChunks(mpmc_bounded_queue<ReadChunk*> &done_queue, mpmc_bounded_queue<ReadChunk*> &free_queue,
+                     double &idle) {
+        // Finished chunks waiting for the preceding ones
+        std::map<size_t, ReadChunk*> pending;
+        size_t next_id = 0;
+        size_t reported = 0;
+        ReadChunk *chunk;
+        while (Dequeue(done_queue, chunk, idle)) {
+            pending.emplace(chunk->id, chunk);
+            while (!pending.empty() && (!cfg_.ordered_output || pending.begin()->first == next_id)) {
+                chunk = pending.begin()->second;
+                pending.erase(pending.begin());
+                for (size_t j = 0; j < chunk->output.size(); ++j)
+                    mapping_printer_hub_.Write(j, chunk->output[j]);
+                Enqueue(free_queue, chunk);
+                ++next_id;
+            }
+
+            size_t processed = processed_reads_.load(std::memory_order_relaxed);
+            if (processed >= reported + progress_step) {
+                size_t aligned = aligned_reads_.load(std::memory_order_relaxed);
+                INFO("Processed " << processed << " reads, aligned reads: " << aligned * 100 / processed <<
+                     "% (" << aligned << " out of " << processed << ")");
+                reported = processed - processed % progress_step;
+            }
+        }
+        VERIFY(pending.empty());
+    }
 
     OneReadMapping AlignRead(const io::SingleRead &read) const {
         DEBUG("Read " << read.name() << ". Current Read")
@@ -145,33 +298,9 @@ class LongReadsAligner {
         return current_read_mapping;
     }
 
-    void AlignBatch(const vector<io::SingleRead> &reads) {
-        size_t step = 10;
-        processed_reads_ = 0;
-        aligned_reads_ = 0;
-        #pragma omp parallel for schedule(guided, 50) num_threads(threads_)
-        for (size_t i = 0 ; i < reads.size(); ++i) {
-            OneReadMapping res = AlignRead(reads[i]);
-            if (res.edge_paths.size() > 0) {
-                mapping_printer_hub_.SaveMapping(res, reads[i]);
-            }
-            #pragma omp critical(aligner)
-            {
-                if (res.edge_paths.size() > 0) {
-                    aligned_reads_ ++;
-                }
-                processed_reads_ ++;
-                if (processed_reads_ * 100 / reads.size() >= step) {
-                    INFO("Processed \% reads: " << processed_reads_ * 100 / reads.size() <<
-                         "\%, Aligned reads: " << aligned_reads_ * 100 / processed_reads_ <<
-                         "\% (" << aligned_reads_ << " out of " << processed_reads_ << ")")
-                    step += 10;
-                }
-            }
-        }
-    }
-
-    const size_t read_buffer_size = 50000;
+    static const size_t max_chunk_reads = 1000;
+    static const size_t chunk_bases = 200000;
+    static const size_t progress_step = 10000;
 
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
     const GAlignerConfig &cfg_;
@@ -179,8 +308,8 @@ class LongReadsAligner {
     const int threads_;
     MappingPrinterHub mapping_printer_hub_;
 
-    int aligned_reads_;
-    int processed_reads_;
+    mutable std::atomic<size_t> aligned_reads_;
+    mutable std::atomic<size_t> processed_reads_;
 
 };
 
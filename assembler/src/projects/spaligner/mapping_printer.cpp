@@ -19,7 +19,7 @@ string MappingPrinter::StrId(const EdgeId &e) const {
     return id_str;
 }
 
-void MappingPrinterTSV::SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) {
+string MappingPrinterTSV::Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const {
     stringstream path_ss;
     stringstream path_len_ss;
     stringstream path_seq_ss;
@@ -54,13 +54,10 @@ void MappingPrinterTSV::SaveMapping(const sensitive_aligner::OneReadMapping &ali
                  + to_string(read.sequence().size()) +  "\t"
                  + path_ss.str() + "\t" + path_len_ss.str() + "\t" + path_seq_ss.str() + "\n";
     DEBUG("Read " << read.name() << " aligned and length=" << read.sequence().size());
-    #pragma omp critical
-    {
-        output_file_ << str;
-    }
+    return str;
 }
 
-void MappingPrinterFasta::SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) {
+string MappingPrinterFasta::Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const {
     string str = "";
     for (size_t j = 0; j < aligned_mappings.edge_paths.size(); ++ j) {
         auto &mappingpath = aligned_mappings.edge_paths[j];
@@ -80,10 +77,7 @@ void MappingPrinterFasta::SaveMapping(const sensitive_aligner::OneReadMapping &a
                                  + "|end_s=" + to_string(aligned_mappings.read_ranges[j].path_end.seq_pos)
                                  + "\n" + path_seq_str + "\n";
     }
-    #pragma omp critical
-    {
-        output_file_ << str;
-    }
+    return str;
 }
 
 string MappingPrinterGPA::Print(map<string, string> &line) const {
@@ -228,8 +222,9 @@ string MappingPrinterGPA::FormGPAOutput(const io::SingleRead &read,
 
 }
 
-void MappingPrinterGPA::SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) {
+string MappingPrinterGPA::Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const {
     int nameIndex = 0;
+    string str = "";
     for (size_t i = 0; i < aligned_mappings.edge_paths.size(); ++ i) {
         auto &path = aligned_mappings.edge_paths[i];
         auto &path_range = aligned_mappings.read_ranges[i];
@@ -244,12 +239,9 @@ void MappingPrinterGPA::SaveMapping(const sensitive_aligner::OneReadMapping &ali
         vector<Range> path_edgeranges;
         FormEdgeCigar(subread, path_seq, path_edgeblocks, path_edgecigar, path_edgeranges);
 
-        string path_line = FormGPAOutput(read, path, path_edgecigar, path_edgeranges, nameIndex, path_range);
-        #pragma omp critical
-        {
-            output_file_ << path_line;
-        }
+        str += FormGPAOutput(read, path, path_edgecigar, path_edgeranges, nameIndex, path_range);
     }
+    return str;
 }
 
 
@@ -24,7 +24,12 @@ class MappingPrinter {
     : g_(g), edge_namer_(edge_namer), output_dir_(output_dir)
   {}
 
-  virtual void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) = 0;
+  // Formats the read alignment, might be called concurrently
+  virtual std::string Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const = 0;
+
+  void Write(const std::string &str) {
+    output_file_ << str;
+  }
 
   virtual ~MappingPrinter () {};
 
@@ -48,7 +53,7 @@ class MappingPrinterTSV: public MappingPrinter {
     output_file_.open(output_dir_ + "/alignment.tsv", std::ofstream::out);
   }
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) override;
+  std::string Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const override;
 
   ~MappingPrinterTSV() {
     output_file_.close();
@@ -66,7 +71,7 @@ class MappingPrinterFasta: public MappingPrinter {
     output_file_.open(output_dir_ + "/alignment.fasta", std::ofstream::out);
   }
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) override;
+  std::string Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const override;
 
   ~MappingPrinterFasta() {
     output_file_.close();
@@ -104,7 +109,7 @@ class MappingPrinterGPA : public MappingPrinter {
                             const std::vector<Range> &edgeranges,
                             int &nameIndex, const PathRange &path_range) const;
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) override;
+  std::string Format(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const override;
 
   ~MappingPrinterGPA() {
     output_file_.close();
@@ -129,10 +134,16 @@ class MappingPrinterHub {
     }
   }
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read)  {
-    for (auto printer : mapping_printers_) {
-      printer->SaveMapping(aligned_mappings, read);
-    }
+  size_t size() const {
+    return mapping_printers_.size();
+  }
+
+  std::string Format(size_t i, const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const {
+    return mapping_printers_[i]->Format(aligned_mappings, read);
+  }
+
+  void Write(size_t i, const std::string &str) {
+    mapping_printers_[i]->Write(str);
   }
 
   ~MappingPrinterHub() {
@@ -0,0 +1,125 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Insert and lookup throughput of the counting Bloom filter and its blocked
+// variant of the same size. Keys are inserted with repetitions, half of the
+// queries are absent from the filter.
+
+#include "adt/bf.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+
+#define XXH_INLINE_ALL
+#include "xxh/xxhash.h"
+
+#include <clipp/clipp.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct KeyHash {
+    uint64_t operator()(uint64_t key) const {
+        return XXH3_64bits(&key, sizeof(key));
+    }
+};
+
+typedef bf::counting_bloom_filter<uint64_t, 2> Filter;
+typedef bf::blocked_counting_bloom_filter<uint64_t, KeyHash, 2> BlockedFilter;
+
+template<class BF>
+void Measure(const std::string &name, BF &filter,
+             const std::vector<uint64_t> &inserts, const std::vector<uint64_t> &queries,
+             size_t distinct, unsigned thr) {
+    utils::perf_counter pc;
+#   pragma omp parallel for schedule(static, 1 << 16)
+    for (size_t i = 0; i < inserts.size(); ++i)
+        filter.add(inserts[i]);
+    double insert_time = pc.time();
+
+    pc.reset();
+    size_t passed = 0;
+#   pragma omp parallel for schedule(static, 1 << 16) reduction(+:passed)
+    for (size_t i = 0; i < queries.size(); ++i)
+        passed += filter.lookup(queries[i]) > thr;
+    double lookup_time = pc.time();
+
+    // Present keys are inserted more than thr times, so all of them pass
+    size_t false_positives = passed - std::min(passed, distinct);
+    INFO(name << ": " << double(inserts.size()) / insert_time / 1e6 << " M inserts/s, "
+         << double(queries.size()) / lookup_time / 1e6 << " M lookups/s, "
+         << passed << " passed, false positive rate "
+         << double(false_positives) / double(queries.size() - distinct));
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    size_t keys = 10000000;
+    unsigned reps = 3;
+    unsigned cells_per_key = 12;
+    unsigned nthreads = omp_get_max_threads();
+
+    using namespace clipp;
+    auto cli = (
+        (option("-n", "--keys") & integer("value", keys)) % "# of distinct keys inserted",
+        (option("-r", "--reps") & integer("value", reps)) % "# of times every key is inserted",
+        (option("-c", "--cells") & integer("value", cells_per_key)) % "# of filter cells per key",
+        (option("-t", "--threads") & integer("value", nthreads)) % "# of threads"
+    );
+    if (!parse(argc, argv, cli) || !keys || reps < 2) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+    omp_set_num_threads(nthreads);
+
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> present(keys);
+    for (auto &key : present)
+        key = rng();
+
+    std::vector<uint64_t> inserts;
+    inserts.reserve(keys * reps);
+    for (unsigned i = 0; i < reps; ++i)
+        inserts.insert(inserts.end(), present.begin(), present.end());
+    std::shuffle(inserts.begin(), inserts.end(), rng);
+
+    std::vector<uint64_t> queries(present);
+    for (size_t i = 0; i < keys; ++i)
+        queries.push_back(rng());
+    std::shuffle(queries.begin(), queries.end(), rng);
+
+    INFO("Inserting " << inserts.size() << " keys using " << nthreads << " threads, "
+         << cells_per_key * keys << " cells");
+    // 2-bit cells saturate at 3
+    unsigned thr = std::min(reps, 3u) - 1;
+    {
+        Filter filter([](uint64_t key, uint64_t seed) {
+                          return XXH3_64bits_withSeed(&key, sizeof(key), seed);
+                      }, cells_per_key * keys);
+        Measure("counting_bloom_filter", filter, inserts, queries, keys, thr);
+    }
+    {
+        BlockedFilter filter(cells_per_key * keys);
+        Measure("blocked_counting_bloom_filter", filter, inserts, queries, keys, thr);
+    }
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Gap closing and ends recovering throughput of the sensitive aligner
+// Dijkstra over an assembly graph (e.g. the one of the spaligner/benchmarking
+// datasets) and the identity of the found alignments. The gaps are sampled
+// from the graph walks with random long read-like errors, the per gap results
+// could be dumped to compare the different builds.
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "io/graph/gfa_reader.hpp"
+#include "modules/alignment/pacbio/gap_dijkstra.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace debruijn_graph;
+using namespace sensitive_aligner;
+
+namespace {
+
+struct Gap {
+    std::string seq;
+    EdgeId start_e, end_e;
+    int start_p, end_p;
+};
+
+std::vector<Gap> SampleGaps(const Graph &g, size_t count, size_t len,
+                            double error_rate, std::mt19937 &rng) {
+    std::vector<EdgeId> edges(g.e_size());
+    std::copy(g.e_begin(), g.e_end(), edges.begin());
+    std::uniform_real_distribution<double> error(0, 1);
+
+    std::vector<Gap> res;
+    res.reserve(count);
+    while (res.size() < count) {
+        Gap gap;
+        gap.start_e = edges[rng() % edges.size()];
+        gap.start_p = int(rng() % g.length(gap.start_e));
+        std::string s = g.EdgeNucls(gap.start_e).Subseq(gap.start_p, g.length(gap.start_e)).str();
+        EdgeId e = gap.start_e;
+        while (s.size() < len) {
+            VertexId v = g.EdgeEnd(e);
+            if (!g.OutgoingEdgeCount(v))
+                break;
+            size_t next = rng() % g.OutgoingEdgeCount(v);
+            for (EdgeId out : g.OutgoingEdges(v)) {
+                if (!next--) {
+                    e = out;
+                    break;
+                }
+            }
+            size_t rest = len - s.size();
+            if (rest <= g.length(e)) {
+                gap.end_e = e;
+                gap.end_p = int(rest);
+            }
+            s += g.EdgeNucls(e).Subseq(0, std::min(rest, g.length(e))).str();
+        }
+        if (s.size() < len || gap.end_e == EdgeId())
+            continue;
+
+        // Long read-like errors, the substitutions and indels are equally likely
+        gap.seq.reserve(s.size() + s.size() / 10);
+        for (char c : s) {
+            if (error(rng) >= error_rate) {
+                gap.seq += c;
+                continue;
+            }
+            switch (rng() % 3) {
+                case 0: gap.seq += nucl(char((dignucl(c) + 1 + rng() % 3) % 4)); break;
+                case 1: gap.seq += c; gap.seq += nucl(char(rng() % 4)); break;
+                default: break;
+            }
+        }
+        res.push_back(std::move(gap));
+    }
+    return res;
+}
+
+struct Result {
+    int score;
+    unsigned status;
+    std::string path;
+};
+
+template<class Algo>
+Result Collect(Algo &algo) {
+    algo.CloseGap();
+    return { algo.edit_distance(), algo.return_code().status, algo.path_str() };
+}
+
+// Mirrors the Dijkstra run of GapFiller::BestScoredPathDijkstra
+Result CloseGap(const Graph &g, const GapClosingConfig &cfg, const Gap &gap) {
+    int s_len = int(gap.seq.size());
+    int ed_limit = std::min(std::max(cfg.ed_lower_bound, s_len / cfg.max_ed_proportion), cfg.ed_upper_bound);
+    size_t path_max_length = size_t(s_len + ed_limit);
+
+    auto backward = omnigraph::DijkstraHelper<Graph>::CreateBackwardBoundedDijkstra(g, path_max_length);
+    backward.Run(g.EdgeStart(gap.end_e));
+    auto forward = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g, path_max_length);
+    forward.Run(g.EdgeEnd(gap.start_e));
+    const auto &reached = forward.ProcessedVertices();
+    std::unordered_map<VertexId, size_t> vertex_pathlen;
+    for (VertexId v : backward.ProcessedVertices()) {
+        if (reached.count(v))
+            vertex_pathlen[v] = backward.GetDistance(v);
+    }
+    if (size_t(s_len) * vertex_pathlen.size() > cfg.max_gs_states)
+        return { std::numeric_limits<int>::max(), 0, "" };
+
+    DijkstraGapFiller algo(g, cfg, gap.seq, gap.start_e, gap.end_e,
+                           gap.start_p, gap.end_p, ed_limit, vertex_pathlen);
+    return Collect(algo);
+}
+
+// Mirrors the Dijkstra run of GapFiller::Run
+Result RecoverEnd(const Graph &g, const EndsClosingConfig &cfg, const Gap &gap) {
+    int s_len = int(gap.seq.size());
+    int score = std::min(std::min(std::max(cfg.ed_lower_bound, s_len / cfg.max_ed_proportion), cfg.ed_upper_bound),
+                         s_len);
+    DijkstraEndsReconstructor algo(g, cfg, gap.seq, gap.start_e, gap.start_p, score);
+    return Collect(algo);
+}
+
+template<class F>
+void Measure(const std::string &name, const std::vector<Gap> &gaps, std::ostream *dump, const F &f) {
+    std::vector<Result> results;
+    results.reserve(gaps.size());
+    utils::perf_counter pc;
+    for (const auto &gap : gaps)
+        results.push_back(f(gap));
+    double time = pc.time();
+
+    size_t found = 0, checksum = 0;
+    double identity = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &res = results[i];
+        checksum = checksum * 31 + std::hash<std::string>()(res.path) + size_t(res.score) + res.status;
+        if (dump)
+            *dump << name << '\t' << i << '\t' << res.score << '\t' << res.status << '\t' << res.path << '\n';
+        if (res.score == std::numeric_limits<int>::max())
+            continue;
+        found += 1;
+        identity += 1. - double(res.score) / double(gaps[i].seq.size());
+    }
+    INFO(name << ": " << (time * 1e3 / double(gaps.size())) << " ms per gap, "
+         << found << " of " << gaps.size() << " aligned, mean identity "
+         << (found ? identity / double(found) : 0.) << " (checksum " << checksum << ")");
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    std::string graph_path, dump_path;
+    size_t count = 1000, len = 1000;
+    double error_rate = 0.1;
+    unsigned seed = 42;
+
+    using namespace clipp;
+    auto cli = (
+        value("graph (GFA file)", graph_path),
+        (option("-n", "--gaps") & integer("value", count)) % "# of gaps",
+        (option("-l", "--length") & integer("value", len)) % "Gap length",
+        (option("-e", "--errors") & number("value", error_rate)) % "Error rate",
+        (option("-s", "--seed") & integer("value", seed)) % "Random seed",
+        (option("-o", "--dump") & value("file", dump_path)) % "Dump the per gap results to the file"
+    );
+    if (!parse(argc, argv, cli)) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+
+    gfa::GFAReader gfa(graph_path);
+    Graph g(gfa.k());
+    gfa.to_graph(g);
+    INFO("Graph loaded, " << g.size() << " vertices, " << g.e_size() << " edges");
+
+    std::mt19937 rng(seed);
+    auto gaps = SampleGaps(g, count, len, error_rate, rng);
+    INFO(gaps.size() << " gaps sampled");
+
+    // The spaligner defaults
+    GapClosingConfig gap_cfg;
+    gap_cfg.find_shortest_path = false;
+    gap_cfg.ed_lower_bound = 500;
+    gap_cfg.ed_upper_bound = 2000;
+    EndsClosingConfig ends_cfg;
+    ends_cfg.penalty_ratio = 0.1f;
+    ends_cfg.max_ed_proportion = 5;
+    ends_cfg.ed_lower_bound = 500;
+    ends_cfg.ed_upper_bound = 2000;
+
+    std::ofstream dump;
+    if (!dump_path.empty())
+        dump.open(dump_path);
+    std::ostream *out = dump.is_open() ? &dump : nullptr;
+
+    Measure("gap closing", gaps, out, [&](const Gap &gap) { return CloseGap(g, gap_cfg, gap); });
+    Measure("ends recovering", gaps, out, [&](const Gap &gap) { return RecoverEnd(g, ends_cfg, gap); });
+
+    return 0;
+}
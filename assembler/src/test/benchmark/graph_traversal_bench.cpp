@@ -0,0 +1,107 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Traversal throughput over a saved assembly graph before and after the
+// graph storage is compacted into traversal order.
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "io/binary/basic.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <functional>
+#include <string>
+
+using namespace debruijn_graph;
+
+namespace {
+
+void Measure(const std::string &name, unsigned rounds,
+             const std::function<size_t()> &f) {
+    size_t checksum = f(); // warm-up
+    utils::perf_counter pc;
+    for (unsigned i = 0; i < rounds; ++i)
+        f();
+    double time = pc.time();
+    INFO(name << ": " << (time / rounds * 1e3) << " ms per round (checksum " << checksum << ")");
+}
+
+// Two-hop scan of the adjacency lists
+size_t Scan(const Graph &g) {
+    size_t res = 0;
+    for (VertexId v : g)
+        for (EdgeId e : g.OutgoingEdges(v))
+            for (EdgeId next : g.OutgoingEdges(g.EdgeEnd(e)))
+                res += g.length(next);
+    return res;
+}
+
+size_t BoundedSearches(const Graph &g, size_t bound, size_t starts) {
+    size_t res = 0;
+    for (VertexId v : g) {
+        if (!starts--)
+            break;
+        auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g, bound);
+        dijkstra.Run(v);
+        res += dijkstra.ReachedVertices().size();
+    }
+    return res;
+}
+
+void Run(const Graph &g, const std::string &prefix, unsigned rounds, size_t bound, size_t starts) {
+    Measure(prefix + "scan", rounds, [&] { return Scan(g); });
+    Measure(prefix + "bounded dijkstra", rounds, [&] { return BoundedSearches(g, bound, starts); });
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    std::string graph_path;
+    unsigned k = 55;
+    size_t bound = 1000;
+    size_t starts = -1ul;
+    unsigned rounds = 3;
+
+    using namespace clipp;
+    auto cli = (
+        value("graph basename (binary graph save)", graph_path),
+        (required("-k") & integer("value", k)) % "K-mer length of the graph",
+        (option("-d", "--distance") & integer("value", bound)) % "Length bound for Dijkstra searches",
+        (option("-n", "--starts") & integer("value", starts)) % "# of Dijkstra start vertices (all by default)",
+        (option("-r", "--rounds") & integer("value", rounds)) % "# of rounds"
+    );
+    if (!parse(argc, argv, cli)) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+
+    Graph g(k);
+    io::binary::BasicGraphIO<Graph>().Load(graph_path, g);
+    INFO("Graph loaded, " << g.size() << " vertices, " << g.e_size() << " edges");
+
+    Run(g, "original ", rounds, bound, starts);
+
+    utils::perf_counter pc;
+    VERIFY(g.Compact());
+    INFO("Compaction took " << (pc.time() * 1e3) << " ms");
+
+    Run(g, "compacted ", rounds, bound, starts);
+
+    return 0;
+}
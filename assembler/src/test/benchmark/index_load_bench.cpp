@@ -0,0 +1,128 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Startup time of the edge index saved in the stream layout (deserialized on
+// load) and in the mapped one (used in place) over a synthetic graph. The
+// graph is generated deterministically, so the index could be saved once and
+// then loaded with --load-only after the page cache is dropped.
+
+#include "assembly_graph/core/graph.hpp"
+#include "io/binary/edge_index.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace debruijn_graph;
+
+namespace {
+
+typedef EdgeIndex<Graph> Index;
+
+void CreateGraph(Graph &g, size_t edges, std::mt19937 &rng) {
+    std::string nucls;
+    VertexId v = g.AddVertex();
+    for (size_t i = 0; i < edges; ++i) {
+        nucls.resize(g.k() + 1 + rng() % 500);
+        for (auto &c : nucls)
+            c = "ACGT"[rng() & 3];
+        VertexId u = g.AddVertex();
+        g.AddEdge(v, u, Sequence(nucls));
+        v = u;
+    }
+}
+
+std::vector<RtSeq> CreateQueries(const Graph &g, size_t queries, std::mt19937 &rng) {
+    std::vector<EdgeId> edges(g.e_size());
+    std::copy(g.e_begin(), g.e_end(), edges.begin());
+
+    unsigned k = unsigned(g.k() + 1);
+    std::vector<RtSeq> res;
+    res.reserve(queries);
+    for (size_t i = 0; i < queries; ++i) {
+        const Sequence &seq = g.EdgeNucls(edges[rng() % edges.size()]);
+        res.emplace_back(k, seq, rng() % (seq.size() - k + 1));
+    }
+    return res;
+}
+
+void Run(const std::string &name, const Graph &g, const std::string &basename,
+         const std::vector<RtSeq> &queries) {
+    utils::perf_counter pc;
+    Index index(g, ".");
+    bool loaded = io::binary::Load(basename, index);
+    CHECK_FATAL_ERROR(loaded, "Cannot load " << basename);
+    double load_time = pc.time();
+
+    // The first queries page the mapped index in
+    pc.reset();
+    size_t found = 0;
+    for (const auto &kmer : queries)
+        found += index.contains(kmer);
+    INFO(name << ": loaded in " << load_time << " s, first " << queries.size() << " queries took "
+         << pc.time() << " s (" << found << " found)");
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    std::string basename;
+    size_t edges = 50000;
+    size_t queries = 100000;
+    unsigned k = 55;
+    bool load_only = false;
+
+    using namespace clipp;
+    auto cli = (
+        value("basename of the saved indices", basename),
+        (option("-e", "--edges") & integer("value", edges)) % "# of edges in the graph",
+        (option("-q", "--queries") & integer("value", queries)) % "# of k-mers looked up after the load",
+        (option("-k") & integer("value", k)) % "K-mer length of the graph",
+        option("--load-only").set(load_only) % "Load the indices saved by the previous run"
+    );
+    if (!parse(argc, argv, cli) || !edges) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+
+    std::mt19937 rng(42);
+    Graph g(k);
+    CreateGraph(g, edges, rng);
+    std::string stream_basename = basename + "_stream";
+
+    if (!load_only) {
+        Index index(g, ".");
+        index.Refill();
+
+        io::binary::EdgeIndexIO<Graph> io;
+        utils::perf_counter pc;
+        io.IOSingle<Index>::Save(stream_basename, index);
+        INFO("Stream layout saved in " << pc.time() << " s");
+        pc.reset();
+        io.Save(basename, index);
+        INFO("Mapped layout saved in " << pc.time() << " s");
+    }
+
+    auto kmers = CreateQueries(g, queries, rng);
+    Run("stream layout", g, stream_basename, kmers);
+    Run("mapped layout", g, basename, kmers);
+
+    return 0;
+}
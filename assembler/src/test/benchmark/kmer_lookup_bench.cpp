@@ -0,0 +1,149 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Throughput of scalar and batched k-mer lookups in the edge index built
+// over a synthetic graph.
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/index/edge_index_builders.hpp"
+#include "assembly_graph/index/edge_position_index.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace debruijn_graph;
+
+namespace {
+
+typedef KmerFreeEdgeIndex<Graph> Index;
+
+void CreateGraph(Graph &g, size_t edges, std::mt19937 &rng) {
+    std::string nucls;
+    VertexId v = g.AddVertex();
+    for (size_t i = 0; i < edges; ++i) {
+        nucls.resize(g.k() + 1 + rng() % 500);
+        for (auto &c : nucls)
+            c = "ACGT"[rng() & 3];
+        VertexId u = g.AddVertex();
+        g.AddEdge(v, u, Sequence(nucls));
+        v = u;
+    }
+}
+
+// Graph k-mers, every tenth query is a random (most likely absent) one
+std::vector<RtSeq> CreateQueries(const Graph &g, size_t queries, std::mt19937 &rng) {
+    std::vector<EdgeId> edges(g.e_size());
+    std::copy(g.e_begin(), g.e_end(), edges.begin());
+
+    unsigned k = g.k() + 1;
+    std::vector<RtSeq> res;
+    res.reserve(queries);
+    std::string nucls(k, 'A');
+    for (size_t i = 0; i < queries; ++i) {
+        if (i % 10 == 9) {
+            for (auto &c : nucls)
+                c = "ACGT"[rng() & 3];
+            res.emplace_back(k, nucls.c_str());
+            continue;
+        }
+
+        EdgeId e = edges[rng() % edges.size()];
+        const Sequence &seq = g.EdgeNucls(e);
+        res.emplace_back(k, seq, rng() % (seq.size() - k + 1));
+    }
+    return res;
+}
+
+void Measure(const std::string &name, size_t queries, unsigned rounds,
+             const std::function<size_t()> &f) {
+    size_t checksum = f(); // warm-up
+    utils::perf_counter pc;
+    for (unsigned i = 0; i < rounds; ++i)
+        f();
+    double time = pc.time();
+    INFO(name << ": " << (double(queries) * rounds / time / 1e6) << " M lookups/s (checksum " << checksum << ")");
+}
+
+size_t ScalarLookups(const Index &index, const std::vector<RtSeq> &queries) {
+    size_t res = 0;
+    for (const auto &kmer : queries) {
+        auto kwh = index.ConstructKWH(kmer);
+        if (index.contains(kwh))
+            res += index.get_value(kwh).offset();
+    }
+    return res;
+}
+
+size_t BatchedLookups(const Index &index, const std::vector<RtSeq> &queries) {
+    const size_t batch = Index::KMerIndexT::LOOKUP_BATCH;
+    std::vector<Index::KeyWithHash> kwhs;
+    kwhs.reserve(batch);
+
+    size_t res = 0;
+    for (size_t start = 0; start < queries.size(); start += batch) {
+        kwhs.clear();
+        for (size_t i = start; i < std::min(start + batch, queries.size()); ++i)
+            kwhs.push_back(index.ConstructKWH(queries[i]));
+
+        index.ResolveKWH(kwhs.data(), kwhs.size());
+        for (const auto &kwh : kwhs)
+            if (index.contains(kwh))
+                res += index.get_value(kwh).offset();
+    }
+    return res;
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    size_t edges = 50000;
+    size_t queries = 2000000;
+    unsigned k = 55;
+    unsigned rounds = 3;
+
+    using namespace clipp;
+    auto cli = (
+        (option("-e", "--edges") & integer("value", edges)) % "# of edges in the graph",
+        (option("-q", "--queries") & integer("value", queries)) % "# of k-mers looked up per round",
+        (option("-k") & integer("value", k)) % "K-mer length of the graph",
+        (option("-r", "--rounds") & integer("value", rounds)) % "# of rounds"
+    );
+    if (!parse(argc, argv, cli) || !edges) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+
+    std::mt19937 rng(42);
+    Graph g(k);
+    CreateGraph(g, edges, rng);
+
+    utils::perf_counter pc;
+    Index index(g);
+    GraphPositionFillingIndexBuilder<Index>().BuildIndexFromGraph(index, g);
+    INFO("Index of " << index.size() << " k-mers built in " << pc.time() << " s");
+
+    auto kmers = CreateQueries(g, queries, rng);
+    Measure("scalar", queries, rounds, [&] { return ScalarLookups(index, kmers); });
+    Measure("batched", queries, rounds, [&] { return BatchedLookups(index, kmers); });
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Splits the k-mers of a set of read files into buckets the way the graph
+// construction does (DeBruijnReadKMerSplitter::Split) and reports the time
+// and the total size of the sorted runs written.
+
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/ph_map/storing_traits.hpp"
+#include "io/reads/io_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <string>
+#include <vector>
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> files;
+    unsigned nthreads = omp_get_max_threads();
+    unsigned k = 55;
+    size_t num_files = 0;
+    size_t buffer_size = 0;
+    std::string workdir = ".";
+
+    using namespace clipp;
+    auto cli = (
+        values("reads", files) % "Read files",
+        (option("-k") & integer("value", k)) % "k-mer length",
+        (option("-t", "--threads") & integer("value", nthreads)) % "# of threads",
+        (option("-n", "--buckets") & integer("value", num_files)) % "# of buckets (default: 10 * # of threads)",
+        (option("-b", "--buffer") & integer("value", buffer_size)) % "Read buffer size in bytes (default: by free memory)",
+        (option("-w", "--workdir") & value("dir", workdir)) % "Directory for temporary files"
+    );
+    if (!parse(argc, argv, cli) || files.empty()) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+    if (!num_files)
+        num_files = 10 * nthreads;
+
+    io::SingleStreams streams;
+    for (const auto &file : files)
+        streams.push_back(io::EasyStream(file, /* followed_by_rc */ true));
+
+    using Splitter = utils::DeBruijnReadKMerSplitter<io::SingleRead,
+                                                     utils::StoringTypeFilter<utils::InvertableStoring>>;
+    auto tmp_dir = fs::tmp::make_temp_dir(workdir, "kmer_splitter_bench");
+    Splitter splitter(tmp_dir, k + 1, streams, buffer_size);
+
+    utils::perf_counter pc;
+    auto raw_kmers = splitter.Split(num_files, nthreads);
+    double time = pc.time();
+
+    size_t runs = 0, kmers = 0;
+    for (const auto &raw : raw_kmers) {
+        std::ifstream idx(raw->file() + ".idx", std::ios::binary);
+        size_t cnt;
+        while (idx.read((char*)&cnt, sizeof(cnt))) {
+            runs += 1;
+            kmers += cnt;
+        }
+    }
+    INFO("Split into " << raw_kmers.size() << " buckets of " << runs << " sorted runs (" << kmers << " k-mers) in "
+         << utils::human_readable_time(time));
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Short read mapping throughput of the exact k-mer mapper and the minimizer
+// one over a saved assembly graph, and the fraction of reads both map the
+// same way. Reads are either given or sampled from the graph walks with
+// random substitutions.
+
+#include "assembly_graph/core/graph.hpp"
+#include "io/binary/basic.hpp"
+#include "io/reads/io_helper.hpp"
+#include "modules/alignment/minimizer_mapper.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace debruijn_graph;
+
+namespace {
+
+std::vector<io::SingleRead> SampleReads(const Graph &g, size_t count, size_t len,
+                                        double error_rate, std::mt19937 &rng) {
+    std::vector<EdgeId> edges(g.e_size());
+    std::copy(g.e_begin(), g.e_end(), edges.begin());
+    std::uniform_real_distribution<double> error(0, 1);
+
+    std::vector<io::SingleRead> res;
+    res.reserve(count);
+    while (res.size() < count) {
+        EdgeId e = edges[rng() % edges.size()];
+        std::string s = g.EdgeNucls(e).Subseq(rng() % g.length(e)).str();
+        while (s.size() < len) {
+            VertexId v = g.EdgeEnd(e);
+            if (!g.OutgoingEdgeCount(v))
+                break;
+            size_t next = rng() % g.OutgoingEdgeCount(v);
+            for (EdgeId out : g.OutgoingEdges(v)) {
+                if (!next--) {
+                    e = out;
+                    break;
+                }
+            }
+            s += g.EdgeNucls(e).Subseq(g.k()).str();
+        }
+        if (s.size() < len)
+            continue;
+
+        s.resize(len);
+        for (auto &c : s) {
+            if (error(rng) < error_rate)
+                c = nucl(char((dignucl(c) + 1 + rng() % 3) % 4));
+        }
+        res.emplace_back(std::to_string(res.size()), s);
+    }
+    return res;
+}
+
+std::vector<io::SingleRead> LoadReads(const std::vector<std::string> &files) {
+    std::vector<io::SingleRead> res;
+    for (const auto &file : files) {
+        auto stream = io::EasyStream(file, /* followed_by_rc */ false);
+        io::SingleRead r;
+        while (!stream.eof()) {
+            stream >> r;
+            res.push_back(r);
+        }
+    }
+    return res;
+}
+
+std::vector<MappingPath<EdgeId>> Measure(const std::string &name, const SequenceMapper<Graph> &mapper,
+                                         const std::vector<io::SingleRead> &reads, unsigned rounds) {
+    std::vector<MappingPath<EdgeId>> res(reads.size());
+    utils::perf_counter pc;
+    for (unsigned i = 0; i < rounds; ++i) {
+#       pragma omp parallel for schedule(dynamic, 1024)
+        for (size_t j = 0; j < reads.size(); ++j)
+            res[j] = mapper.MapRead(reads[j]);
+    }
+    double time = pc.time();
+
+    size_t mapped = 0;
+    for (const auto &path : res)
+        mapped += !path.empty();
+    INFO(name << ": " << double(reads.size()) * rounds / time / 1e6 << " M reads/s, "
+         << mapped << " of " << reads.size() << " mapped");
+    return res;
+}
+
+bool SameMapping(const MappingPath<EdgeId> &a, const MappingPath<EdgeId> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].first != b[i].first ||
+            !(a[i].second.initial_range == b[i].second.initial_range) ||
+            !(a[i].second.mapped_range == b[i].second.mapped_range))
+            return false;
+    }
+    return true;
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    std::string graph_path;
+    std::vector<std::string> read_files;
+    unsigned k = 55;
+    size_t count = 1000000, len = 150;
+    double error_rate = 0.005;
+    unsigned window = 10;
+    unsigned rounds = 3;
+    unsigned nthreads = omp_get_max_threads();
+
+    using namespace clipp;
+    auto cli = (
+        value("graph basename (binary graph save)", graph_path),
+        (required("-k") & integer("value", k)) % "K-mer length of the graph",
+        (option("--reads") & values("files", read_files)) % "Reads to map instead of the sampled ones",
+        (option("-n", "--count") & integer("value", count)) % "# of sampled reads",
+        (option("-l", "--length") & integer("value", len)) % "Length of sampled reads",
+        (option("-e", "--errors") & number("value", error_rate)) % "Substitution rate of sampled reads",
+        (option("-w", "--window") & integer("value", window)) % "Minimizer window",
+        (option("-r", "--rounds") & integer("value", rounds)) % "# of rounds",
+        (option("-t", "--threads") & integer("value", nthreads)) % "# of threads"
+    );
+    if (!parse(argc, argv, cli) || !window || !rounds) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+    omp_set_num_threads(nthreads);
+
+    Graph g(k);
+    io::binary::BasicGraphIO<Graph>().Load(graph_path, g);
+    INFO("Graph loaded, " << g.size() << " vertices, " << g.e_size() << " edges");
+
+    std::mt19937 rng(42);
+    auto reads = read_files.empty() ? SampleReads(g, count, len, error_rate, rng) : LoadReads(read_files);
+    INFO(reads.size() << " reads, " << nthreads << " threads");
+
+    utils::perf_counter pc;
+    EdgeIndex<Graph> index(g, ".");
+    index.Refill();
+    KmerMapper<Graph> kmer_mapper(g);
+    INFO("Edge index built in " << pc.time() << " s");
+
+    pc.reset();
+    MinimizerIndex<Graph> minimizer_index(g, window);
+    minimizer_index.Refill();
+    INFO("Minimizer index built in " << pc.time() << " s");
+
+    auto exact = Measure("exact k-mer mapper", BasicSequenceMapper<Graph, EdgeIndex<Graph>>(g, index, kmer_mapper),
+                         reads, rounds);
+    auto sampled = Measure("minimizer mapper", MinimizerSequenceMapper<Graph>(g, minimizer_index),
+                           reads, rounds);
+
+    size_t same = 0;
+    for (size_t i = 0; i < reads.size(); ++i)
+        same += SameMapping(exact[i], sampled[i]);
+    INFO(same << " of " << reads.size() << " reads are mapped the same way");
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Throughput of the nucleotide packing kernels for every instruction set
+// supported by the host.
+
+#include "sequence/nucl_kernels.hpp"
+#include "sequence/sequence.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void Measure(const std::string &name, size_t bytes, unsigned rounds,
+             const std::function<void()> &f) {
+    f(); // warm-up
+    utils::perf_counter pc;
+    for (unsigned i = 0; i < rounds; ++i)
+        f();
+    double time = pc.time();
+    INFO(name << ": " << (double(bytes) * rounds / time / 1e9) << " GB/s");
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    size_t size_mb = 64;
+    size_t read_length = 150;
+    unsigned rounds = 5;
+
+    using namespace clipp;
+    auto cli = (
+        (option("-s", "--size") & integer("value", size_mb)) % "Size of the nucleotide buffer (in Mb)",
+        (option("-l", "--length") & integer("value", read_length)) % "Read length for Sequence construction",
+        (option("-r", "--rounds") & integer("value", rounds)) % "# of rounds"
+    );
+    if (!parse(argc, argv, cli) || !read_length) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+
+    size_t n = size_mb << 20;
+    std::string nucls(n, 'A');
+    std::mt19937 rng(42);
+    for (auto &c : nucls)
+        c = "ACGT"[rng() & 3];
+    std::vector<uint8_t> packed((n + 3) / 4);
+    std::string out(n, '-');
+
+    nucl_kernels::Isa best = nucl_kernels::DetectIsa();
+    for (auto isa : { nucl_kernels::Isa::Scalar, nucl_kernels::Isa::SSE42, nucl_kernels::Isa::AVX2 }) {
+        if (isa > best)
+            break;
+        nucl_kernels::ActiveIsa() = isa;
+        std::string prefix = std::string(nucl_kernels::IsaName(isa)) + " ";
+
+        Measure(prefix + "pack", n, rounds,
+                [&] { nucl_kernels::Pack(nucls.data(), n, packed.data()); });
+        Measure(prefix + "pack rc", n, rounds,
+                [&] { nucl_kernels::Pack(nucls.data(), n, packed.data(), true); });
+        Measure(prefix + "unpack", n, rounds,
+                [&] { nucl_kernels::Unpack(packed.data(), 0, n, &out[0]); });
+        Measure(prefix + "unpack rc", n, rounds,
+                [&] { nucl_kernels::Unpack(packed.data(), 1, n - 1, &out[0], true); });
+        Measure(prefix + "reverse complement", n, rounds,
+                [&] { nucl_kernels::ReverseComplement(nucls.data(), n, &out[0]); });
+        Measure(prefix + "validate", n, rounds,
+                [&] { VERIFY_MSG(nucl_kernels::IsValid(nucls.data(), n), "Invalid nucleotides"); });
+
+        std::vector<std::string> reads;
+        for (size_t i = 0; i + read_length <= std::min(n, size_t(16) << 20); i += read_length)
+            reads.push_back(nucls.substr(i, read_length));
+        Measure(prefix + "Sequence from reads", reads.size() * read_length, rounds,
+                [&] {
+                    size_t total = 0;
+                    for (const auto &read : reads)
+                        total += Sequence(read).size();
+                    VERIFY_MSG(total == reads.size() * read_length, "Size mismatch");
+                });
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Memory footprint and lookup throughput of the clustered paired info index
+// for the available storage backends on a synthetic graph.
+
+#include "assembly_graph/core/graph.hpp"
+#include "paired_info/paired_info.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/memory_limit.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <clipp/clipp.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace debruijn_graph;
+using namespace omnigraph::de;
+
+namespace {
+
+struct Pair {
+    EdgeId e1, e2;
+    Point p;
+};
+
+std::vector<EdgeId> CreateGraph(Graph &g, size_t edges, std::mt19937 &rng) {
+    std::vector<EdgeId> res;
+    std::string nucls;
+    VertexId v = g.AddVertex();
+    for (size_t i = 0; i < edges; ++i) {
+        nucls.resize(g.k() + 1 + rng() % 500);
+        for (auto &c : nucls)
+            c = "ACGT"[rng() & 3];
+        VertexId u = g.AddVertex();
+        res.push_back(g.AddEdge(v, u, Sequence(nucls)));
+        res.push_back(g.conjugate(res.back()));
+        v = u;
+    }
+    return res;
+}
+
+// Edges are paired with the ones located nearby, as in real libraries
+std::vector<Pair> CreatePairs(const std::vector<EdgeId> &edges, size_t pairs, size_t window,
+                              std::mt19937 &rng) {
+    std::vector<Pair> res;
+    res.reserve(pairs);
+    for (size_t i = 0; i < pairs; ++i) {
+        size_t idx = rng() % edges.size();
+        size_t other = std::min(edges.size() - 1, idx + rng() % window);
+        res.push_back({ edges[idx], edges[other],
+                        Point(DEDistance(rng() % 1000), DEWeight(1 + rng() % 10), 0.) });
+    }
+    return res;
+}
+
+template<template<typename, typename> class Container>
+void Run(const std::string &name, const Graph &g,
+         const std::vector<Pair> &pairs, const std::vector<EdgeId> &edges, unsigned rounds) {
+    typedef PairedIndex<Graph, PointTraits, Container> Index;
+
+    size_t mem = utils::get_used_memory();
+    utils::perf_counter pc;
+    Index index(g);
+    for (const auto &pair : pairs)
+        index.Add(pair.e1, pair.e2, pair.p);
+    double fill_time = pc.time();
+    size_t used = utils::get_used_memory() - mem;
+    INFO(name << ": filled " << index.size() << " points in " << fill_time << " s, "
+         << used / 1024 / 1024 << " Mb used");
+
+    pc.reset();
+    size_t points = 0;
+    for (unsigned r = 0; r < rounds; ++r)
+        for (const auto &pair : pairs)
+            points += index.Get(pair.e1, pair.e2).size();
+    double time = pc.time();
+    INFO(name << ": histogram lookups: " << (double(pairs.size()) * rounds / time / 1e6)
+         << " M/s (checksum " << points << ")");
+
+    pc.reset();
+    points = 0;
+    for (unsigned r = 0; r < rounds; ++r)
+        for (EdgeId e : edges)
+            for (auto entry : index.Get(e))
+                points += entry.second.size();
+    time = pc.time();
+    INFO(name << ": neighbourhood traversals: " << (double(edges.size()) * rounds / time / 1e6)
+         << " M/s (checksum " << points << ")");
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    size_t edges = 100000;
+    size_t pairs = 10000000;
+    size_t window = 50;
+    unsigned rounds = 3;
+
+    using namespace clipp;
+    auto cli = (
+        (option("-e", "--edges") & integer("value", edges)) % "# of edges in the graph",
+        (option("-p", "--pairs") & integer("value", pairs)) % "# of points added to the index",
+        (option("-w", "--window") & integer("value", window)) % "Max distance (in edges) between paired edges",
+        (option("-r", "--rounds") & integer("value", rounds)) % "# of rounds"
+    );
+    if (!parse(argc, argv, cli) || !edges || !window) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+
+    std::mt19937 rng(42);
+    Graph g(55);
+    auto graph_edges = CreateGraph(g, edges, rng);
+    auto index_pairs = CreatePairs(graph_edges, pairs, window, rng);
+
+    Run<safe_btree_map>("safe_btree_map", g, index_pairs, graph_edges, rounds);
+    Run<flat_hash_map>("flat_hash_map", g, index_pairs, graph_edges, rounds);
+
+    return 0;
+}
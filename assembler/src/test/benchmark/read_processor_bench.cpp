@@ -0,0 +1,132 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Compares single-producer ReadProcessor::Run with multi-producer
+// ReadProcessor::RunParallel on a set of read files, the latter both for
+// SingleReads and CompactReads.
+
+#include "io/reads/io_helper.hpp"
+#include "io/reads/read_processor.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <clipp/clipp.h>
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct NuclCounter {
+    std::vector<size_t> nucls;
+
+    explicit NuclCounter(unsigned nthreads)
+            : nucls(nthreads, 0) {}
+
+    bool operator()(std::unique_ptr<io::SingleRead> r) {
+        return (*this)(*r);
+    }
+
+    template<class Read>
+    bool operator()(const Read &r) {
+        // Simulate some per-read work: convert read to Sequence and count
+        // non-A nucleotides
+        const Sequence &seq = r.sequence();
+        size_t cnt = 0;
+        for (size_t i = 0; i < seq.size(); ++i)
+            cnt += seq[i] != 0;
+        nucls[omp_get_thread_num()] += cnt;
+        return false;
+    }
+
+    size_t total() const {
+        return std::accumulate(nucls.begin(), nucls.end(), size_t(0));
+    }
+};
+
+io::SingleStreams OpenStreams(const std::vector<std::string> &files) {
+    io::SingleStreams streams;
+    for (const auto &file : files)
+        streams.push_back(io::EasyStream(file, /* followed_by_rc */ false));
+    return streams;
+}
+
+io::CompactSingleStreams OpenCompactStreams(const std::vector<std::string> &files) {
+    io::CompactSingleStreams streams;
+    for (const auto &file : files)
+        streams.push_back(io::CompactStream(file, /* followed_by_rc */ false));
+    return streams;
+}
+
+void Report(const std::string &mode, size_t reads, size_t nucls, double time) {
+    INFO(mode << ": " << reads << " reads (" << nucls << " non-A nucls) in "
+         << utils::human_readable_time(time) << ", " << (double) reads / time << " reads/s");
+}
+
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> files;
+    unsigned nthreads = omp_get_max_threads();
+    unsigned nproducers = 0;
+    size_t batch_size = 1024;
+
+    using namespace clipp;
+    auto cli = (
+        values("reads", files) % "Read files",
+        (option("-t", "--threads") & integer("value", nthreads)) % "# of consumer threads",
+        (option("-p", "--producers") & integer("value", nproducers)) % "# of producer threads (default: # of files)",
+        (option("-b", "--batch") & integer("value", batch_size)) % "Read batch size"
+    );
+    if (!parse(argc, argv, cli) || files.empty()) {
+        std::cout << make_man_page(cli, argv[0]);
+        return 1;
+    }
+
+    create_console_logger();
+    if (!nproducers)
+        nproducers = unsigned(files.size());
+
+    {
+        auto streams = OpenStreams(files);
+        NuclCounter counter(nthreads);
+        hammer::ReadProcessor rp(nthreads);
+        utils::perf_counter pc;
+        for (size_t i = 0; i < streams.size(); ++i)
+            rp.Run(streams[i], counter);
+        Report("Single producer", rp.processed(), counter.total(), pc.time());
+    }
+
+    {
+        auto streams = OpenStreams(files);
+        NuclCounter counter(nthreads);
+        hammer::ReadProcessor rp(nthreads);
+        utils::perf_counter pc;
+        rp.RunParallel(streams, counter, nproducers, batch_size);
+        Report(std::to_string(nproducers) + " producers", rp.processed(), counter.total(), pc.time());
+    }
+
+    {
+        auto streams = OpenCompactStreams(files);
+        NuclCounter counter(nthreads);
+        hammer::ReadProcessor rp(nthreads);
+        utils::perf_counter pc;
+        rp.RunParallel(streams, counter, nproducers, batch_size);
+        Report(std::to_string(nproducers) + " producers, compact reads", rp.processed(), counter.total(), pc.time());
+    }
+
+    return 0;
+}
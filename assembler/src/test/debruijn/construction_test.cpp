@@ -13,6 +13,8 @@
 #include "pipeline/graph_pack.hpp" // FIXME: get rid of it
 #include "modules/graph_construction.hpp"
 #include "modules/alignment/edge_index.hpp"
+#include "io/reads/io_helper.hpp"
+#include "utils/kmer_counting.hpp"
 
 #include "test_utils.hpp"
 #include "tmp_folder_fixture.hpp"
@@ -20,6 +22,7 @@
 #include <vector>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 #include <gtest/gtest.h>
 
@@ -86,6 +89,24 @@ void CheckIndex(const std::vector<std::string> &reads, const std::string &tmpdir
     }
 }
 
+TEST_F( GraphConstruction, PerfectLoop ) {
+    // The loop has no junctions, so it is not reached by the unbranching paths
+    const size_t k = 11;
+    std::string loop = "CCGTAATGCCTTTCCCTAACAGAGTTTTTCGAACTCGTGT";
+    std::vector<std::string> reads = { loop.substr(5) + loop + loop.substr(0, k) };
+
+    Graph g(k);
+    auto workdir = fs::tmp::make_temp_dir("tmp", "tests");
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(io::VectorReadStream<io::SingleRead>(MakeReads(reads))));
+    ConstructGraph(config::debruijn_config::construction(), workdir, streams, g);
+
+    ASSERT_EQ(2u, g.e_size());
+    for (EdgeId e : g.edges()) {
+        EXPECT_EQ(g.EdgeStart(e), g.EdgeEnd(e));
+        EXPECT_EQ(loop.size(), g.length(e));
+    }
+}
+
 TEST_F( GraphConstruction, TestKmerStoringIndex ) {
     std::vector<std::string> reads = { "CGAAACCAC", "CGAAAACAC", "AACCACACC", "AAACACACC" };
     CheckIndex(reads, tmp_folder(), 5);
@@ -106,3 +127,44 @@ TEST_F( GraphConstruction, SimpleTestEarlyPairedInfo ) {
 
     AssertGraph(3, paired_reads, 5, 6, edges, coverage_info, edge_pair_info);
 }
+
+TEST_F( GraphConstruction, SinglePassCoverageHistogram ) {
+    unsigned k = 22, thr = 3;
+    rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(k);
+    io::ReadStreamList<io::SingleRead> streams;
+    streams.push_back(io::EasyStream("test_dataset/ecoli_1K_1.fq.gz", false));
+    streams.push_back(io::EasyStream("test_dataset/ecoli_1K_2.fq.gz", false));
+
+    // The filter is small initially, so it is expanded several times
+    qf::cqf cqf(1 << 8, qf::cqf::hash_bits_for(1 << 20));
+
+    struct HashCounter {
+        std::unordered_map<uint64_t, size_t> counts;
+        uint64_t mask;
+        size_t max_read_length = 0;
+
+        void ProcessKmer(const RtSeq &, uint64_t hash) {
+            counts[hash & mask] += 1;
+        }
+    } counter;
+    counter.mask = cqf.range_mask();
+    utils::KmerSequenceProcessor<decltype(hasher), HashCounter> processor(hasher, counter);
+    streams.reset();
+    for (auto &stream : streams) {
+        io::SingleRead r;
+        while (!stream.eof()) {
+            stream >> r;
+            counter.max_read_length = std::max(counter.max_read_length, r.size());
+            if (r.size() >= k)
+                processor.ProcessSequence(r.sequence(), k);
+        }
+    }
+
+    size_t kmers = utils::FillCoverageHistogramAndEstimateCardinality(cqf, k, hasher, streams, thr,
+                                                                       counter.max_read_length);
+    EXPECT_GT(cqf.slots(), 1u << 8);
+    EXPECT_GT(double(kmers), 0.9 * double(counter.counts.size()));
+    EXPECT_LT(double(kmers), 1.5 * double(counter.counts.size()));
+    for (const auto &entry : counter.counts)
+        EXPECT_EQ(std::min<size_t>(thr, entry.second), std::min<size_t>(thr, cqf.lookup(entry.first)));
+}
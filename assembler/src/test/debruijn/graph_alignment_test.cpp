@@ -8,6 +8,8 @@
 #include "pipeline/config_struct.hpp"
 
 #include "modules/alignment/sequence_mapper.hpp"
+#include "modules/alignment/minimizer_mapper.hpp"
+#include "modules/alignment/mapping_path_cache.hpp"
 #include "modules/alignment/pacbio/g_aligner.hpp"
 
 #include "io/reads/io_helper.hpp"
@@ -17,6 +19,8 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 
 using namespace debruijn_graph;
 
@@ -72,6 +76,40 @@ TEST(GraphAligner, EdlibSHWFULLTestZero  ) {
     edlib::edlibFreeAlignResult(result);
 }
 
+TEST(GraphAligner, MyersAlignerTest) {
+    std::mt19937 rng(42);
+    sensitive_aligner::MyersAligner aligner;
+    for (size_t i = 0; i < 2000; ++i) {
+        // Short and multi block queries, the targets are the mutated queries with a random tail
+        std::string query;
+        size_t query_len = 1 + rng() % (i % 4 ? 64 : 300);
+        for (size_t j = 0; j < query_len; ++j)
+            query += nucl(char(rng() % 4));
+        std::string target;
+        for (char c : query) {
+            switch (rng() % 10) {
+                case 0: target += nucl(char(rng() % 4)); break;
+                case 1: target += c; target += 'N'; break;
+                case 2: break;
+                default: target += c;
+            }
+        }
+        for (size_t j = rng() % 100; j > 0; --j)
+            target += nucl(char(rng() % 4));
+        if (target.empty())
+            continue;
+        int max_score = int(rng() % (query_len / 2 + 2));
+
+        std::vector<int> positions, scores;
+        SHWDistanceExtended(target, query, max_score, positions, scores);
+        std::vector<int> myers_positions, myers_scores;
+        sensitive_aligner::MyersAligner::Profile profile(query.data(), (int) query.size());
+        aligner.Align(profile, target.data(), (int) target.size(), max_score, myers_positions, myers_scores);
+        EXPECT_EQ(positions, myers_positions);
+        EXPECT_EQ(scores, myers_scores);
+    }
+}
+
 debruijn_graph::config::pacbio_processor InitializePacBioProcessor() {
     debruijn_graph::config::pacbio_processor pb;  
     pb.internal_length_cutoff = 200; //500
@@ -196,3 +234,123 @@ TEST(GraphAligner, DijkstraGrowEndsTest ) {
     int score = ends_filler.edit_distance();
     EXPECT_EQ(ideal_score, score);
 }
+
+static std::string RandomGraphWalk(const Graph &g, const std::vector<EdgeId> &edges,
+                                   size_t len, std::mt19937 &rng) {
+    EdgeId e = edges[rng() % edges.size()];
+    std::string s = g.EdgeNucls(e).Subseq(rng() % g.length(e)).str();
+    while (s.size() < len) {
+        VertexId v = g.EdgeEnd(e);
+        if (!g.OutgoingEdgeCount(v))
+            break;
+        size_t next = rng() % g.OutgoingEdgeCount(v);
+        for (EdgeId out : g.OutgoingEdges(v)) {
+            if (!next--) {
+                e = out;
+                break;
+            }
+        }
+        s += g.EdgeNucls(e).Subseq(g.k()).str();
+    }
+    return s.substr(0, len);
+}
+
+static void CheckSameMapping(const MappingPath<EdgeId> &expected, const MappingPath<EdgeId> &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].first, actual[i].first);
+        EXPECT_EQ(expected[i].second.initial_range, actual[i].second.initial_range);
+        EXPECT_EQ(expected[i].second.mapped_range, actual[i].second.mapped_range);
+    }
+}
+
+TEST(GraphAligner, MinimizerMapperTest ) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    EdgeIndex<Graph> index(g, "tmp");
+    index.Refill();
+    KmerMapper<Graph> kmer_mapper(g);
+    BasicSequenceMapper<Graph, EdgeIndex<Graph>> exact_mapper(g, index, kmer_mapper);
+
+    MinimizerIndex<Graph> minimizer_index(g, 10);
+    minimizer_index.Refill();
+    MinimizerSequenceMapper<Graph> mapper(g, minimizer_index);
+
+    std::vector<EdgeId> edges(g.e_size());
+    std::copy(g.e_begin(), g.e_end(), edges.begin());
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < 2000; ++i) {
+        std::string s = RandomGraphWalk(g, edges, 200, rng);
+        CheckSameMapping(exact_mapper.MapSequence(Sequence(s)), mapper.MapSequence(Sequence(s)));
+
+        // Both flanks of a single error contain several windows
+        if (s.size() < 200)
+            continue;
+        s[100] = nucl(char((dignucl(s[100]) + 1 + rng() % 3) % 4));
+        CheckSameMapping(exact_mapper.MapSequence(Sequence(s)), mapper.MapSequence(Sequence(s)));
+    }
+}
+
+TEST(GraphAligner, DistanceCacheTest ) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    std::vector<VertexId> vertices(g.begin(), g.end());
+    std::mt19937 rng(42);
+    std::vector<std::pair<VertexId, VertexId>> queries;
+    for (size_t i = 0; i < 200; ++i) {
+        VertexId start = vertices[rng() % vertices.size()];
+        auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g, 5000, 500);
+        dijkstra.Run(start);
+        auto reached = dijkstra.ReachedVertices();
+        // Reached targets and some random ones for every start
+        for (size_t j = 0; j < 4; ++j)
+            queries.emplace_back(start, reached[rng() % reached.size()]);
+        queries.emplace_back(start, vertices[rng() % vertices.size()]);
+    }
+
+    // Small capacity to evict the runs
+    sensitive_aligner::DistanceCache cache(g, 5000, 500, 64);
+    for (size_t round = 0; round < 2; ++round) {
+        std::vector<size_t> distances(queries.size());
+#       pragma omp parallel for
+        for (size_t i = 0; i < queries.size(); ++i)
+            distances[i] = cache.GetDistance(queries[i].first, queries[i].second);
+
+        for (size_t i = 0; i < queries.size(); ++i) {
+            auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g, 5000, 500);
+            dijkstra.Run(queries[i].first);
+            size_t expected = dijkstra.DistanceCounted(queries[i].second) ? dijkstra.GetDistance(queries[i].second) : size_t(-1);
+            EXPECT_EQ(expected, distances[i]);
+        }
+    }
+
+    auto stats = cache.stats();
+    EXPECT_EQ(2 * queries.size(), stats.hits + stats.misses);
+    EXPECT_GT(stats.hits, 0u);
+    EXPECT_GT(stats.evictions, 0u);
+}
+
+TEST(GraphAligner, GraphFingerprintTest) {
+    // Long enough to span several packed words, differing only in the middle
+    std::string nucls = "ACGTTGCAAGCTTACGGATCCATGCATGACCGGTTAACGTACGTAGCTAGCTTTGGCAACGTTGCAGTCGA";
+    std::string changed = nucls;
+    changed[nucls.size() / 2] = changed[nucls.size() / 2] == 'A' ? 'C' : 'A';
+
+    auto fingerprint = [](const std::string &s) {
+        Graph g(5);
+        g.AddEdge(g.AddVertex(), g.AddVertex(), Sequence(s));
+        return GraphFingerprint(g);
+    };
+    EXPECT_EQ(fingerprint(nucls), fingerprint(nucls));
+    EXPECT_NE(fingerprint(nucls), fingerprint(changed));
+
+    // Hashes of the reverse complement and unaligned subsequence views match the ones of the copies
+    Sequence seq(nucls);
+    EXPECT_EQ(Sequence((!seq).str()).GetHash(), (!seq).GetHash());
+    EXPECT_EQ(Sequence(seq.Subseq(3, 40).str()).GetHash(), seq.Subseq(3, 40).GetHash());
+    EXPECT_EQ(Sequence(seq.Subseq(0, 40).str()).GetHash(), seq.Subseq(0, 40).GetHash());
+}
@@ -5,6 +5,7 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/handlers/edges_position_handler.hpp"
 
 #include <vector>
 #include <set>
@@ -106,3 +107,96 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+TEST( GraphCore, Compact ) {
+    Graph g(5);
+    omnigraph::EdgesPositionHandler<Graph> positions(g, 0);
+    std::vector<VertexId> v;
+    for (size_t i = 0; i < 6; ++i)
+        v.push_back(g.AddVertex());
+    g.AddEdge(v[0], v[1], Sequence("AACGCTATT"));
+    EdgeId tip = g.AddEdge(v[1], v[2], Sequence("CTATTGGACG"));
+    g.AddEdge(v[1], v[3], Sequence("CTATTCCAGA"));
+    g.AddEdge(v[3], v[4], Sequence("CCAGATTTGC"));
+    g.AddEdge(v[4], g.conjugate(v[4]), Sequence("TTTGCAAA"));
+    EdgeId extra = g.AddEdge(v[5], v[3], Sequence("GGCACCAGA"));
+    g.coverage_index().SetRawCoverage(tip, 42);
+    positions.AddEdgePosition(tip, "ref", 10, 15, 0, 5);
+    // Leave holes in the id space
+    g.DeleteEdge(extra);
+    g.DeleteVertex(v[5]);
+
+    std::multiset<std::string> edges;
+    for (EdgeId e : g.edges())
+        edges.insert(g.EdgeNucls(e).str());
+    size_t vertex_cnt = g.size(), edge_cnt = g.e_size();
+
+    ASSERT_TRUE(g.Compact());
+
+    EXPECT_EQ(vertex_cnt, g.size());
+    EXPECT_EQ(edge_cnt, g.e_size());
+    std::multiset<std::string> compacted;
+    std::set<uint64_t> eids, vids;
+    for (EdgeId e : g.edges()) {
+        compacted.insert(g.EdgeNucls(e).str());
+        eids.insert(g.int_id(e));
+        EXPECT_EQ(e, g.conjugate(g.conjugate(e)));
+        EXPECT_EQ(!g.EdgeNucls(e), g.EdgeNucls(g.conjugate(e)));
+        EXPECT_EQ(g.EdgeEnd(e), g.conjugate(g.EdgeStart(g.conjugate(e))));
+        if (g.EdgeNucls(e) == Sequence("CTATTGGACG")) {
+            EXPECT_EQ(42u, g.coverage_index().RawCoverage(e));
+            ASSERT_EQ(1u, positions.GetEdgePositions(e).size());
+            EXPECT_EQ("ref", positions.GetEdgePositions(e).front().contigId);
+        }
+    }
+    EXPECT_EQ(edges, compacted);
+    for (VertexId u : g) {
+        vids.insert(g.int_id(u));
+        for (EdgeId e : g.OutgoingEdges(u))
+            EXPECT_EQ(u, g.EdgeStart(e));
+    }
+    // Ids are dense
+    EXPECT_EQ(edge_cnt, *eids.rbegin() - *eids.begin() + 1);
+    EXPECT_EQ(vertex_cnt, *vids.rbegin() - *vids.begin() + 1);
+
+    // Graph remains modifiable
+    VertexId added = g.AddVertex();
+    EXPECT_EQ(vids.end(), vids.find(g.int_id(added)));
+    EXPECT_EQ(vertex_cnt + 2, g.size());
+
+    // Ids stored outside of handlers can not be translated
+    auto it = g.SmartEdgeBegin();
+    EXPECT_FALSE(g.Compact());
+}
+
+TEST( GraphCore, SequenceArena ) {
+    Sequence escaped;
+    {
+        Graph g(5, /* sequence_arena */ true);
+        ASSERT_NE(nullptr, g.master().arena());
+        VertexId v1 = g.AddVertex(), v2 = g.AddVertex(), v3 = g.AddVertex();
+        Sequence read("TTAACGCTATTGGACGAAC");
+        // Unaligned and reverse-complement views are copied as well
+        EdgeId e1 = g.AddEdge(v1, v2, read.Subseq(2, 11));
+        EdgeId e2 = g.AddEdge(v2, v3, !Sequence("CCAGCGTCCAATAG"));
+        EXPECT_EQ(Sequence("AACGCTATT"), g.EdgeNucls(e1));
+        EXPECT_EQ(Sequence("CTATTGGACGCTGG"), g.EdgeNucls(e2));
+
+        std::string long_edge(10000, 'A');
+        long_edge += "CGTAC";
+        EdgeId e3 = g.AddEdge(v3, g.AddVertex(), Sequence(long_edge));
+        EXPECT_EQ(long_edge, g.EdgeNucls(e3).str());
+
+        EdgeId merged = g.MergePath(std::vector<EdgeId>{e1, e2});
+        EXPECT_EQ(Sequence("AACGCTATTGGACGCTGG"), g.EdgeNucls(merged));
+        auto split = g.SplitEdge(merged, 6);
+        EXPECT_EQ(Sequence("AACGCTATTGG"), g.EdgeNucls(split.first));
+        EXPECT_EQ(Sequence("ATTGGACGCTGG"), g.EdgeNucls(split.second));
+
+        escaped = g.EdgeNucls(g.conjugate(split.second));
+        g.DeleteEdge(split.first);
+        EXPECT_EQ(Sequence("AACGCTATTGGACGCTGG").Subseq(6), !escaped);
+    }
+    // The arena is kept while its sequences are alive
+    EXPECT_EQ(Sequence("CCAGCGTCCAAT"), escaped);
+}
@@ -7,11 +7,19 @@
 #include "test_utils.hpp"
 #include "random_graph.hpp"
 #include "assembly_graph/handlers/id_track_handler.hpp"
+#include "io/binary/checkpoint.hpp"
+#include "io/binary/edge_index.hpp"
 #include "io/binary/graph.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
+#include "io/reads/io_helper.hpp"
+#include "io/reads/compact_read.hpp"
+#include "io/reads/gz_reader.hpp"
 
 #include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <fstream>
 
 using namespace debruijn_graph;
 
@@ -109,3 +117,273 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+TEST(Io, EdgeIndex) {
+    const auto &graph = CommonGraph();
+    EdgeIndex<Graph> index(graph, "tmp");
+    index.Refill();
+
+    Save(file_name, index);
+    EdgeIndex<Graph> mapped(graph, "tmp");
+    ASSERT_TRUE(Load(file_name, mapped));
+    // Modifications of the mapped index do not reach the file
+    EdgeId removed = *graph.ConstEdgeBegin();
+    mapped.HandleDelete(removed);
+    EdgeIndex<Graph> remapped(graph, "tmp");
+    ASSERT_TRUE(Load(file_name, remapped));
+
+    // Files in the stream layout are still readable. Note that the mapped file
+    // should not be overwritten in place
+    std::string stream_file_name = std::string(file_name) + ".stream";
+    EdgeIndexIO<Graph> io;
+    io.IOSingle<EdgeIndex<Graph>>::Save(stream_file_name, index);
+    EdgeIndex<Graph> read(graph, "tmp");
+    ASSERT_TRUE(Load(stream_file_name, read));
+
+    for (EdgeId e : graph.edges()) {
+        const Sequence &seq = graph.EdgeNucls(e);
+        RtSeq kmer = seq.start<RtSeq>(index.k()) >> 'A';
+        for (size_t i = index.k() - 1; i < seq.size(); ++i) {
+            kmer <<= seq[i];
+            auto pos = index.get(kmer);
+            EXPECT_EQ(pos, remapped.get(kmer));
+            EXPECT_EQ(pos, read.get(kmer));
+            if (pos.first != removed && pos.first != graph.conjugate(removed))
+                EXPECT_EQ(pos, mapped.get(kmer));
+            else
+                EXPECT_FALSE(mapped.contains(kmer));
+        }
+    }
+}
+
+TEST(Io, Checkpoint) {
+    const auto &graph = CommonGraph();
+
+    KmerMapper<Graph> kmer_mapper(graph);
+    RandomKmerMapper<Graph>(kmer_mapper).Generate(100);
+
+    // Small chunks, so the file consists of many of them
+    ChunkedFormat format;
+    format.chunk_size = 1024;
+    {
+        CheckpointWriter checkpoint(format, /*background*/ true);
+        {
+            CheckpointWriter::Scope scope(checkpoint);
+            Save(file_name, kmer_mapper);
+        }
+        bool done = false;
+        checkpoint.Commit([&done] { done = true; });
+        checkpoint.Wait();
+        EXPECT_TRUE(done);
+    }
+
+    KmerMapper<Graph> new_mapper(graph);
+    ASSERT_TRUE(Load(file_name, new_mapper));
+    CompareContainers(kmer_mapper, new_mapper);
+
+    // Damaged content is detected
+    std::string kmm_file_name = std::string(file_name) + ".kmm";
+    {
+        std::fstream file(kmm_file_name, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(0, std::ios::end);
+        std::streamoff pos = file.tellg() / 2;
+        char c;
+        file.seekg(pos);
+        file.get(c);
+        file.seekp(pos);
+        file.put(char(c ^ 0x20));
+    }
+    KmerMapper<Graph> damaged(graph);
+    EXPECT_THROW(Load(file_name, damaged), std::ios_base::failure);
+
+    // Without the active writer the files are compressed on the fly
+    OutputFile::set_format(format);
+    Save(file_name, kmer_mapper);
+    OutputFile::set_format(ChunkedFormat());
+    EXPECT_FALSE(fs::check_existence(kmm_file_name + ".tmp"));
+    KmerMapper<Graph> streamed(graph);
+    ASSERT_TRUE(Load(file_name, streamed));
+    CompareContainers(kmer_mapper, streamed);
+
+    // The file not closed explicitly does not replace the previous one
+    {
+        OutputFile file(kmm_file_name);
+        file.stream() << "garbage";
+    }
+    EXPECT_FALSE(fs::check_existence(kmm_file_name + ".tmp"));
+    KmerMapper<Graph> kept(graph);
+    ASSERT_TRUE(Load(file_name, kept));
+    CompareContainers(kmer_mapper, kept);
+}
+
+TEST(Io, CompactRead) {
+    const char *reads_file = "test_dataset/ecoli_1K_1.fq.gz";
+
+    auto single = io::EasyStream(reads_file, /* followed_by_rc */ true, /* handle_Ns */ false);
+    auto compact = io::CompactStream(reads_file, /* followed_by_rc */ true);
+
+    size_t n = 0;
+    io::SingleRead sr;
+    io::CompactRead cr;
+    while (!single.eof()) {
+        ASSERT_FALSE(compact.eof());
+        single >> sr;
+        compact >> cr;
+        EXPECT_EQ(sr.name(), cr.name());
+        EXPECT_EQ(sr.GetSequenceString(), cr.GetSequenceString());
+        EXPECT_EQ(sr.GetQualityString(), cr.GetQualityString());
+        EXPECT_EQ(sr.sequence(), cr.sequence());
+        EXPECT_EQ(sr.IsValid(), cr.IsValid());
+        n += 1;
+    }
+    EXPECT_TRUE(compact.eof());
+    EXPECT_GT(n, 0u);
+}
+
+TEST(Io, CompactReadBatcher) {
+    // Tiny buffers to force several batches
+    io::CompactReadBatcher batcher(16, 16);
+    std::vector<io::SingleRead> reads = {
+        io::SingleRead("read1", "ACGTACGTAC", std::string(10, 30)),
+        io::SingleRead("read2_RC", "ACGTNACGT", std::string(9, 20)),
+        io::SingleRead("a_quite_long_read_name", "TTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT"),
+        io::SingleRead("", "GATTACA")
+    };
+
+    std::vector<io::CompactRead> compact;
+    for (const auto &read : reads)
+        compact.push_back(batcher.Add(read));
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+        for (bool rc : { false, true }) {
+            io::SingleRead sr = rc ? !reads[i] : reads[i];
+            io::CompactRead cr = rc ? !compact[i] : compact[i];
+            EXPECT_EQ(sr.name(), cr.name());
+            EXPECT_EQ(sr.GetSequenceString(), cr.GetSequenceString());
+            EXPECT_EQ(sr.GetQualityString(), cr.GetQualityString());
+            EXPECT_EQ(sr.IsValid(), cr.IsValid());
+            if (sr.IsValid()) {
+                EXPECT_EQ(sr.sequence(), cr.sequence());
+            }
+            EXPECT_EQ(sr.GetSequenceString(), cr.ToSingleRead().GetSequenceString());
+        }
+    }
+}
+
+namespace {
+
+std::string Inflate(const char *filename) {
+    gzFile gz = gzopen(filename, "rb");
+    EXPECT_NE(gz, nullptr);
+    std::string res;
+    char buf[1 << 16];
+    int len;
+    while ((len = gzread(gz, buf, sizeof(buf))) > 0)
+        res.append(buf, len);
+    gzclose(gz);
+    return res;
+}
+
+// Writes data as a sequence of BGZF blocks followed by the empty EOF block
+void WriteBGZF(const std::string &filename, const std::string &data, size_t block_size) {
+    std::ofstream out(filename, std::ios::binary);
+    auto write_block = [&](const char *s, size_t size) {
+        std::vector<unsigned char> deflated(compressBound(uLong(size)) + 64);
+        z_stream zs = {};
+        int res = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        ASSERT_EQ(res, Z_OK);
+        zs.next_in = (Bytef*) s;
+        zs.avail_in = uInt(size);
+        zs.next_out = deflated.data();
+        zs.avail_out = uInt(deflated.size());
+        ASSERT_EQ(deflate(&zs, Z_FINISH), Z_STREAM_END);
+        size_t deflated_size = zs.total_out;
+        deflateEnd(&zs);
+
+        size_t bsize = 18 + deflated_size + 8 - 1;
+        unsigned char header[18] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0,
+                                     (unsigned char) (bsize & 0xFF), (unsigned char) (bsize >> 8) };
+        uint32_t crc = uint32_t(crc32(0, (const Bytef*) s, uInt(size)));
+        uint32_t isize = uint32_t(size);
+        out.write((const char*) header, sizeof(header));
+        out.write((const char*) deflated.data(), deflated_size);
+        out.write((const char*) &crc, sizeof(crc));
+        out.write((const char*) &isize, sizeof(isize));
+    };
+
+    for (size_t i = 0; i < data.size(); i += block_size)
+        write_block(data.data() + i, std::min(block_size, data.size() - i));
+    write_block("", 0);
+}
+
+std::string ReadAll(io::GzReader &reader) {
+    std::string res;
+    // Odd read sizes to cross the chunk boundaries at arbitrary places
+    char buf[4099];
+    for (unsigned len = 1; ; len = len * 3 % sizeof(buf) + 1) {
+        int read = reader.read(buf, len);
+        if (read <= 0)
+            break;
+        res.append(buf, read);
+    }
+    return res;
+}
+
+}
+
+TEST(Io, GzReader) {
+    const char *reads_file = "test_dataset/ecoli_1K_1.fq.gz";
+    std::string expected = Inflate(reads_file);
+    ASSERT_FALSE(expected.empty());
+
+    const char *plain_file = "src/test/debruijn/graph_fragments/saves/test_save.fq";
+    const char *bgzf_file = "src/test/debruijn/graph_fragments/saves/test_save.fq.bgz";
+    {
+        std::ofstream plain(plain_file, std::ios::binary);
+        plain << expected;
+    }
+    WriteBGZF(bgzf_file, expected, 1000);
+
+    std::vector<std::pair<const char*, io::GzReader::Format>> files = {
+        { reads_file, io::GzReader::Format::Gzip },
+        { plain_file, io::GzReader::Format::Plain },
+        { bgzf_file, io::GzReader::Format::BGZF }
+    };
+    for (const auto &file : files) {
+        io::GzReader reader(file.first);
+        ASSERT_TRUE(reader.is_open());
+        EXPECT_EQ(file.second, reader.format());
+        EXPECT_EQ(expected, ReadAll(reader));
+        EXPECT_EQ(0, reader.read(nullptr, 0));
+    }
+
+    // Decompression is accounted while the file is still open
+    {
+        auto before = io::DecompressionStats::Current();
+        io::GzReader reader(bgzf_file);
+        EXPECT_EQ(expected, ReadAll(reader));
+        auto stats = io::DecompressionStats::Current() - before;
+        EXPECT_EQ(expected.size(), stats.uncompressed);
+        EXPECT_GT(stats.compressed, 0u);
+    }
+
+    // Parsing of BGZF should produce exactly the same reads
+    auto gzip_reads = io::EasyStream(reads_file, /* followed_by_rc */ false);
+    auto bgzf_reads = io::EasyStream(bgzf_file, /* followed_by_rc */ false);
+    io::SingleRead r1, r2;
+    size_t n = 0;
+    while (!gzip_reads.eof()) {
+        ASSERT_FALSE(bgzf_reads.eof());
+        gzip_reads >> r1;
+        bgzf_reads >> r2;
+        EXPECT_EQ(r1, r2);
+        n += 1;
+    }
+    EXPECT_TRUE(bgzf_reads.eof());
+    EXPECT_GT(n, 0u);
+
+    EXPECT_FALSE(io::GzReader("src/test/debruijn/graph_fragments/saves/no_such_file").is_open());
+
+    fs::remove_if_exists(plain_file);
+    fs::remove_if_exists(bgzf_file);
+}
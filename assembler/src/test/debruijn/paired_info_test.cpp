@@ -458,3 +458,29 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+TEST(PairedInfo, HashMapBackend) {
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+
+    TestIndex pi(graph);
+    debruijn_graph::RandomPairedIndex<TestIndex>(pi, 100).Generate(20);
+
+    PairedIndex<debruijn_graph::Graph, RawPointTraits, flat_hash_map> hpi(graph);
+    hpi.Merge(pi);
+    EXPECT_EQ(pi.size(), hpi.size());
+
+    for (auto it = pair_begin(pi); it != pair_end(pi); ++it)
+        EXPECT_EQ((*it).Unwrap(), hpi.Get(it.first(), it.second()).Unwrap());
+
+    size_t pairs = 0, hpairs = 0;
+    for (auto it = pair_begin(pi); it != pair_end(pi); ++it)
+        pairs += 1;
+    for (auto it = pair_begin(hpi); it != pair_end(hpi); ++it)
+        hpairs += 1;
+    EXPECT_EQ(pairs, hpairs);
+
+    for (auto it = pair_begin(pi); it != pair_end(pi); ++it)
+        hpi.Remove(it.first(), it.second());
+    EXPECT_EQ(0u, hpi.size());
+}
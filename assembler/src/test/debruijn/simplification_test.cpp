@@ -8,12 +8,15 @@
 #include "stages/simplification_pipeline/graph_simplification.hpp"
 #include "stages/simplification_pipeline/single_cell_simplification.hpp"
 #include "stages/simplification_pipeline/rna_simplification.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include "graphio.hpp"
 #include "tmp_folder_fixture.hpp"
 
 #include <gtest/gtest.h>
 
+#include <unordered_set>
+
 using namespace debruijn_graph;
 using namespace debruijn_graph::config;
 
@@ -351,6 +354,110 @@ TEST_F( Simplification,  CompressorTest ) {
     EXPECT_EQ(graph.size(), graph_size);
 }
 
+std::vector<std::string> SortedEdgeSequences(const Graph &g) {
+    std::vector<std::string> answer;
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        answer.push_back(g.EdgeNucls(*it).str());
+    std::sort(answer.begin(), answer.end());
+    return answer;
+}
+
+template<class AlgoFactory>
+void TestConcurrentAlgorithm(const std::string &path, AlgoFactory make_algo) {
+    Graph serial(55), concurrent(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, serial));
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, concurrent));
+    size_t initial_size = serial.size();
+
+    auto info = standard_simplif_relevant_info();
+    make_algo(serial, info)->Run();
+    info.set_concurrent_mutation(true);
+    make_algo(concurrent, info)->Run();
+
+    EXPECT_LT(serial.size(), initial_size);
+    EXPECT_EQ(serial.size(), concurrent.size());
+    EXPECT_EQ(SortedEdgeSequences(serial), SortedEdgeSequences(concurrent));
+}
+
+void TestConcurrentMutation(const std::string &path, const std::string &tc_condition) {
+    debruijn_config::simplification::tip_clipper tc_config;
+    tc_config.condition = tc_condition;
+    TestConcurrentAlgorithm(path, [&](Graph &g, const debruijn::simplification::SimplifInfoContainer &info) {
+        return debruijn::simplification::TipClipperInstance(g, tc_config, info);
+    });
+}
+
+TEST_F( Simplification,  ConcurrentTipClipper ) {
+    TestConcurrentMutation(graph_fragment_root() + "tips/graph", standard_tc_config().condition);
+}
+
+TEST_F( Simplification,  ConcurrentTipClipper1 ) {
+    TestConcurrentMutation(graph_fragment_root() + "big_complex_bulge/big_complex_bulge", "{ tc_lb 20. , cb 1000000. , rctc 10000. }");
+}
+
+TEST_F( Simplification,  ConcurrentTipClipper2 ) {
+    TestConcurrentMutation(graph_fragment_root() + "topology_ec/big_bad", "{ tc_lb 20. , cb 1000000. , rctc 10000. }");
+}
+
+TEST_F( Simplification,  ConcurrentLowCoverageEdgeRemover ) {
+    debruijn_config::simplification::low_covered_edge_remover lcer_config;
+    lcer_config.enabled = true;
+    lcer_config.coverage_threshold = 500.;
+    TestConcurrentAlgorithm(graph_fragment_root() + "topology_ec/big_bad",
+                            [&](Graph &g, const debruijn::simplification::SimplifInfoContainer &info) {
+        return debruijn::simplification::LowCoverageEdgeRemoverInstance(g, lcer_config, info);
+    });
+}
+
+TEST_F( Simplification,  ConcurrentRelativeECRemover ) {
+    debruijn_config::simplification::relative_coverage_ec_remover rcec_config;
+    rcec_config.enabled = true;
+    rcec_config.max_ec_length = 1000;
+    rcec_config.rcec_ratio = 15.;
+    TestConcurrentAlgorithm(graph_fragment_root() + "topology_ec/big_bad",
+                            [&](Graph &g, const debruijn::simplification::SimplifInfoContainer &info) {
+        return debruijn::simplification::RelativeECRemoverInstance(g, rcec_config, info, nullptr);
+    });
+}
+
+// Removes the tips and returns the number of the removed ones created by the compression
+size_t ClipTipsCountingCascade(Graph &g, const std::string &tc_condition, bool concurrent, unsigned nthreads) {
+    debruijn_config::simplification::tip_clipper tc_config;
+    tc_config.condition = tc_condition;
+    auto info = standard_simplif_relevant_info();
+    info.set_concurrent_mutation(concurrent);
+
+    std::unordered_set<EdgeId> initial;
+    for (EdgeId e : g.edges())
+        initial.insert(e);
+    size_t cascaded = 0;
+    auto algo = debruijn::simplification::TipClipperInstance(g, tc_config, info,
+                                                              [&](EdgeId e) { cascaded += !initial.count(e); });
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(nthreads);
+    algo->Run();
+    omp_set_num_threads(threads);
+    return cascaded;
+}
+
+TEST_F( Simplification,  ConcurrentTipClipperCascade ) {
+    // Some of the tips appear only after the compression of the clipped ones
+    std::string path = graph_fragment_root() + "big_complex_bulge/big_complex_bulge";
+    std::string condition = "{ tc_lb 20. , cb 1000000. , rctc 10000. }";
+    Graph serial(55), single(55), concurrent(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, serial));
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, single));
+    ASSERT_TRUE(graphio::ScanBasicGraph(path, concurrent));
+
+    EXPECT_GT(ClipTipsCountingCascade(serial, condition, false, 1), 0u);
+    EXPECT_GT(ClipTipsCountingCascade(single, condition, true, 1), 0u);
+    EXPECT_GT(ClipTipsCountingCascade(concurrent, condition, true, 4), 0u);
+
+    // Batches do not depend on the number of threads
+    EXPECT_EQ(SortedEdgeSequences(single), SortedEdgeSequences(concurrent));
+    EXPECT_EQ(SortedEdgeSequences(serial), SortedEdgeSequences(concurrent));
+}
+
 #if 0
 TEST_F( Simplification,  ParallelCompressor1 ) {
     std::string path = "./src/test/debruijn/graph_fragments/compression/graph";
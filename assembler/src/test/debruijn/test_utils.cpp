@@ -17,6 +17,7 @@
 #include "paired_info/weights.hpp"
 
 #include "modules/alignment/sequence_mapper_notifier.hpp"
+#include "modules/alignment/mapping_path_cache.hpp"
 #include "paired_info/pair_info_filler.hpp"
 
 #include <gtest/gtest.h>
@@ -225,6 +226,15 @@ void AssertGraph(size_t k, const std::vector<MyPairedRead> &paired_reads, size_t
     notifier.ProcessLibrary(paired_streams, 0, *MapperInstance(gp));
     
     AssertPairInfo(graph, paired_indices[0], AddComplement(AddBackward(etalon_pair_info)));
+
+    // Mappings are recorded during the first pass and replayed during the second one
+    MappingPathCache cache(workdir->dir() + "/paths", graph);
+    for (size_t pass = 0; pass < 2; ++pass) {
+        paired_indices[0].clear();
+        notifier.ProcessLibrary(paired_streams, 0, *MapperInstance(gp), cache);
+        EXPECT_EQ(pass > 0, cache.replaying());
+        AssertPairInfo(graph, paired_indices[0], AddComplement(AddBackward(etalon_pair_info)));
+    }
 }
 
 }
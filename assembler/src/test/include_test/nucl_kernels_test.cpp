@@ -0,0 +1,108 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "sequence/nucl_kernels.hpp"
+#include "sequence/sequence.hpp"
+#include "sequence/sequence_tools.hpp"
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace nucl_kernels;
+
+namespace {
+
+std::string RandomNucls(std::mt19937 &rng, size_t n, const std::string &alphabet) {
+    std::string res(n, 'A');
+    for (auto &c : res)
+        c = alphabet[rng() % alphabet.size()];
+    return res;
+}
+
+class NuclKernels : public ::testing::TestWithParam<Isa> {
+  protected:
+    void SetUp() override {
+        saved_ = ActiveIsa();
+        if (GetParam() > DetectIsa())
+            GTEST_SKIP() << IsaName(GetParam()) << " is not supported";
+        ActiveIsa() = GetParam();
+    }
+
+    void TearDown() override {
+        ActiveIsa() = saved_;
+    }
+
+    std::mt19937 rng_{42};
+    Isa saved_;
+};
+
+}
+
+TEST_P( NuclKernels, Pack ) {
+    for (size_t n = 0; n < 300; ++n) {
+        for (const std::string &alphabet : { std::string("ACGT"), std::string("acgtACGT"), std::string("ACGTN"),
+                                              std::string("\0\1\2\3", 4) }) {
+            std::string s = RandomNucls(rng_, n, alphabet);
+            for (bool rc : { false, true }) {
+                std::vector<uint8_t> expected((n + 3) / 4), actual((n + 3) / 4);
+                scalar::Pack(s.data(), n, expected.data(), rc);
+                Pack(s.data(), n, actual.data(), rc);
+                EXPECT_EQ(expected, actual) << s << " rc: " << rc;
+            }
+        }
+    }
+}
+
+TEST_P( NuclKernels, Unpack ) {
+    for (size_t n = 0; n < 300; ++n) {
+        for (size_t from = 0; from < 8; ++from) {
+            std::vector<uint8_t> packed((from + n + 3) / 4);
+            for (auto &b : packed)
+                b = uint8_t(rng_());
+            for (bool rc : { false, true }) {
+                std::string expected(n, '-'), actual(n, '-');
+                scalar::Unpack(packed.data(), from, n, &expected[0], rc);
+                Unpack(packed.data(), from, n, &actual[0], rc);
+                EXPECT_EQ(expected, actual) << "from: " << from << " rc: " << rc;
+            }
+        }
+    }
+}
+
+TEST_P( NuclKernels, IsValid ) {
+    for (size_t n = 1; n < 200; ++n) {
+        std::string s = RandomNucls(rng_, n, "acgtACGT");
+        EXPECT_TRUE(IsValid(s.data(), n));
+        s[rng_() % n] = 'N';
+        EXPECT_FALSE(IsValid(s.data(), n)) << s;
+    }
+}
+
+TEST_P( NuclKernels, ReverseComplement ) {
+    for (size_t n = 0; n < 200; ++n) {
+        std::string s = RandomNucls(rng_, n, "acgtnACGTN");
+        std::string expected(n, '-'), actual(n, '-');
+        scalar::ReverseComplement(s.data(), n, &expected[0]);
+        ReverseComplement(s.data(), n, &actual[0]);
+        EXPECT_EQ(expected, actual);
+    }
+}
+
+TEST_P( NuclKernels, Sequence ) {
+    for (size_t n = 1; n < 300; n += 7) {
+        std::string s = RandomNucls(rng_, n, "ACGT");
+        Sequence seq(s), rc(s, true);
+        EXPECT_EQ(s, seq.str());
+        EXPECT_EQ(::ReverseComplement(s), rc.str());
+        EXPECT_EQ(rc, !seq);
+        EXPECT_EQ(s.substr(n / 3, n / 2), seq.Subseq(n / 3, n / 3 + n / 2).str());
+        EXPECT_EQ(rc.Subseq(n / 5).str(), (!seq).Subseq(n / 5).str());
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Isa, NuclKernels,
+                         ::testing::Values(Isa::Scalar, Isa::SSE42, Isa::AVX2));